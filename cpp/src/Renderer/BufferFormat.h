@@ -0,0 +1,192 @@
+//==============================================================================================//
+// Classname:
+//      BufferFormat
+//
+//==============================================================================================//
+// Description:
+//      Storage formats of the image buffers of the rasterizer. The kernels compute in float and
+//		convert on every load and store, so the reduced formats only change the memory traffic
+//		and the size of the buffers. The formats match the tensor types of the operators:
+//		float, half, bfloat16, uint16 (unorm16) and uint8 (sRGB encoded unorm8 for the render
+//		buffer, unorm8 for textures).
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <cuda_runtime.h>
+#include <cuda_fp16.h>
+#include <string>
+
+//==============================================================================================//
+
+/*
+Float32Format	: float
+HalfFormat		: IEEE half
+BFloat16Format	: upper 16 bits of the float, rounded to nearest even
+Unorm16Format	: [0, 1] in 16 bit steps, for the barycentric coordinates
+SRGB8Format		: [0, 1] sRGB encoded in 8 bit steps, for exported renders (not differentiable)
+Unorm8Format	: [0, 1] in 8 bit steps, for textures (the 8 bit image values the float textures are loaded from)
+*/
+enum BufferFormat
+{
+	Float32Format, HalfFormat, BFloat16Format, Unorm16Format, SRGB8Format, Unorm8Format
+};
+
+//==============================================================================================//
+
+/*
+Format of the tensor type name of the operators (DataTypeString), float if the name is unknown
+*/
+inline BufferFormat getBufferFormat(const std::string& typeName)
+{
+	if (typeName == "half")
+		return BufferFormat::HalfFormat;
+	else if (typeName == "bfloat16")
+		return BufferFormat::BFloat16Format;
+	else if (typeName == "uint16")
+		return BufferFormat::Unorm16Format;
+	else if (typeName == "uint8")
+		return BufferFormat::SRGB8Format;
+
+	return BufferFormat::Float32Format;
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ int getBufferFormatSize(BufferFormat format)
+{
+	if (format == BufferFormat::Float32Format)
+		return 4;
+	else if (format == BufferFormat::SRGB8Format || format == BufferFormat::Unorm8Format)
+		return 1;
+
+	return 2;
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ unsigned short floatToBFloat16Bits(float value)
+{
+	union { float f; unsigned int u; } bits;
+	bits.f = value;
+
+	//NaN stays a (quiet) NaN, everything else is rounded to nearest even
+	if ((bits.u & 0x7FFFFFFFu) > 0x7F800000u)
+		return (unsigned short)((bits.u >> 16) | 0x0040u);
+
+	return (unsigned short)((bits.u + 0x7FFFu + ((bits.u >> 16) & 1u)) >> 16);
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ float bFloat16BitsToFloat(unsigned short value)
+{
+	union { float f; unsigned int u; } bits;
+	bits.u = (unsigned int)value << 16;
+	return bits.f;
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ float linearToSRGB(float value)
+{
+	return value <= 0.0031308f ? 12.92f * value : 1.055f * powf(value, 1.f / 2.4f) - 0.055f;
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ float sRGBToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+//==============================================================================================//
+
+//the loads and stores use device intrinsics, the host compiled operators only see the formats
+#ifdef __CUDACC__
+
+//==============================================================================================//
+
+/*
+Stores value as element index of buffer
+*/
+inline __device__ void storeBufferValue(void* buffer, int index, float value, BufferFormat format)
+{
+	if (format == BufferFormat::Float32Format)
+		((float*)buffer)[index] = value;
+	else if (format == BufferFormat::HalfFormat)
+		((__half*)buffer)[index] = __float2half_rn(value);
+	else if (format == BufferFormat::BFloat16Format)
+		((unsigned short*)buffer)[index] = floatToBFloat16Bits(value);
+	else if (format == BufferFormat::Unorm16Format)
+		((unsigned short*)buffer)[index] = (unsigned short)(__saturatef(value) * 65535.f + 0.5f);
+	else if (format == BufferFormat::SRGB8Format)
+		((unsigned char*)buffer)[index] = (unsigned char)(linearToSRGB(__saturatef(value)) * 255.f + 0.5f);
+	else if (format == BufferFormat::Unorm8Format)
+		((unsigned char*)buffer)[index] = (unsigned char)(__saturatef(value) * 255.f + 0.5f);
+}
+
+//==============================================================================================//
+
+/*
+Loads element index of buffer as float
+*/
+inline __device__ float loadBufferValue(const void* buffer, int index, BufferFormat format)
+{
+	if (format == BufferFormat::HalfFormat)
+		return __half2float(((const __half*)buffer)[index]);
+	else if (format == BufferFormat::BFloat16Format)
+		return bFloat16BitsToFloat(((const unsigned short*)buffer)[index]);
+	else if (format == BufferFormat::Unorm16Format)
+		return ((const unsigned short*)buffer)[index] / 65535.f;
+	else if (format == BufferFormat::SRGB8Format)
+		return sRGBToLinear(((const unsigned char*)buffer)[index] / 255.f);
+	else if (format == BufferFormat::Unorm8Format)
+		return ((const unsigned char*)buffer)[index] / 255.f;
+
+	return ((const float*)buffer)[index];
+}
+
+//==============================================================================================//
+
+/*
+Loads the color of element index of an RGB (channels 3) or an RGBA padded (channels 4) buffer. The padded layout is read with one
+aligned vector load per element, the alpha channel is ignored.
+*/
+inline __device__ float3 loadBufferColor(const void* buffer, int index, int channels, BufferFormat format)
+{
+	if (channels == 4)
+	{
+		if (format == BufferFormat::Float32Format)
+		{
+			float4 color = ((const float4*)buffer)[index];
+			return make_float3(color.x, color.y, color.z);
+		}
+		else if (format == BufferFormat::HalfFormat)
+		{
+			uint2 packed = ((const uint2*)buffer)[index];
+			float2 rg = __half22float2(*(const __half2*)&packed.x);
+			float2 ba = __half22float2(*(const __half2*)&packed.y);
+			return make_float3(rg.x, rg.y, ba.x);
+		}
+		else if (format == BufferFormat::Unorm8Format)
+		{
+			uchar4 color = ((const uchar4*)buffer)[index];
+			return make_float3(color.x / 255.f, color.y / 255.f, color.z / 255.f);
+		}
+	}
+
+	return make_float3(
+		loadBufferValue(buffer, channels * index + 0, format),
+		loadBufferValue(buffer, channels * index + 1, format),
+		loadBufferValue(buffer, channels * index + 2, format));
+}
+
+//==============================================================================================//
+
+#endif
+
+//==============================================================================================//
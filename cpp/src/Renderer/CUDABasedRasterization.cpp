@@ -9,54 +9,58 @@
 //==============================================================================================//
 
 CUDABasedRasterization::CUDABasedRasterization(
-	std::vector<int>faces, 
-	std::vector<float>textureCoordinates, 
+	const std::vector<int>& faces, 
+	const std::vector<float>& textureCoordinates, 
 	int numberOfVertices,
 	int numberOfCameras,
 	int frameResolutionU, 
 	int frameResolutionV, 
 	std::string albedoMode, 
 	std::string shadingMode,
-	bool computeNormal)
+	bool computeNormal,
+	bool reorderMesh,
+	bool twoSided,
+	bool triangleSetup,
+	std::string visibilityMode,
+	bool hierarchicalZ,
+	bool profile,
+	bool launchGraphs,
+	std::string vertexNormalLayout,
+	int outputs,
+	std::string renderBufferFormat,
+	std::string barycentricFormat,
+	std::string textureFormat,
+	std::string textureSampling,
+	const std::string& topologyCacheDirectory)
+	:
+	d_reorderedVertices(NULL),
+	d_reorderedVertexColor(NULL),
+	d_reorderedVertexNormal(NULL),
+	d_internalVertexNormal(NULL),
+	numberOfAllocatedBatches(0)
 {
-	//faces
-	if(faces.size() % 3 == 0)
-	{
-		input.F = (faces.size() / 3);
-		cutilSafeCall(cudaMalloc(&input.d_facesVertex, sizeof(int3) * input.F));
-		cutilSafeCall(cudaMemcpy(input.d_facesVertex, faces.data(), sizeof(int3)*input.F, cudaMemcpyHostToDevice));
-
-		// Get the vertexFaces, vertexFacesId
-		std::vector<int> vertexFaces, vertexFacesId;
-		getVertexFaces(numberOfVertices, faces, vertexFaces, vertexFacesId);
-		cutilSafeCall(cudaMalloc(&input.d_vertexFaces, sizeof(int) * vertexFaces.size()));
-		cutilSafeCall(cudaMemcpy(input.d_vertexFaces, vertexFaces.data(), sizeof(int)*vertexFaces.size(), cudaMemcpyHostToDevice));
-		cutilSafeCall(cudaMalloc(&input.d_vertexFacesId, sizeof(int) * vertexFacesId.size()));
-		cutilSafeCall(cudaMemcpy(input.d_vertexFacesId, vertexFacesId.data(), sizeof(int)*vertexFacesId.size(), cudaMemcpyHostToDevice));
-	}
-	else
-	{
-		std::cout << "No triangular faces!" << std::endl;
-	}
+	//shared topology
+	topology = MeshTopology::acquire(faces, textureCoordinates, numberOfVertices, reorderMesh, topologyCacheDirectory);
+
+	input.F						= topology->getNumberOfFaces();
+	input.d_facesVertex			= topology->get_D_facesVertex();
+	input.d_vertexFaces			= topology->get_D_vertexFaces();
+	input.d_vertexFacesId		= topology->get_D_vertexFacesId();
+	input.d_textureCoordinates	= topology->get_D_textureCoordinates();
+	input.d_textureMapIds		= NULL;
+	input.d_originalFaceIds		= topology->get_D_originalFaceIds();
+	input.d_reorderedFaceIds	= topology->get_D_reorderedFaceIds();
+
+	//meshlet culling
+	input.numberOfMeshlets		= topology->getNumberOfMeshlets();
+	input.d_meshletFaces		= topology->get_D_meshletFaces();
+	input.d_meshlets			= topology->get_D_meshlets();
+	input.twoSided				= twoSided;
 
-	//texture coordinates
-	if (textureCoordinates.size() % 6 == 0)
-	{
-		cutilSafeCall(cudaMalloc(&input.d_textureCoordinates, sizeof(float) * 6 * input.F));
-		cutilSafeCall(cudaMemcpy(input.d_textureCoordinates, textureCoordinates.data(), sizeof(float)*input.F * 6, cudaMemcpyHostToDevice));
-	}
-	else
-	{
-		std::cout << "Texture coordinates have wrong dimensionality!" << std::endl;
-	}
-	
 	//camera parameters
 	
 	input.numberOfCameras = numberOfCameras;
 
-	cutilSafeCall(cudaMalloc(&input.d_inverseExtrinsics,		sizeof(float4)*input.numberOfCameras * 4));
-	cutilSafeCall(cudaMalloc(&input.d_inverseProjection,		sizeof(float4)*input.numberOfCameras * 4));
-
 	input.w = frameResolutionU;
 	input.h = frameResolutionV;
 
@@ -92,210 +96,251 @@ CUDABasedRasterization::CUDABasedRasterization(
 		input.shadingMode = ShadingMode::Shadeless;
 	}
 
+	//visibility mode
+	if (visibilityMode == "packed")
+	{
+		input.visibilityMode = VisibilityMode::Packed;
+	}
+	else if (visibilityMode == "quantized")
+	{
+		input.visibilityMode = VisibilityMode::Quantized;
+	}
+
+	//vertex normal layout
+	if (vertexNormalLayout == "perCamera")
+	{
+		input.vertexNormalLayout = VertexNormalLayout::PerCamera;
+	}
+	else if (vertexNormalLayout == "shared")
+	{
+		input.vertexNormalLayout = VertexNormalLayout::Shared;
+	}
+
+	//storage formats of the image buffers, given as the names of the tensor types
+	input.renderBufferFormat	= getBufferFormat(renderBufferFormat);
+	input.barycentricFormat		= getBufferFormat(barycentricFormat);
+
+	//8 bit textures hold the image values in 1 / 255 steps, like the float textures loaded from images
+	input.textureFormat			= textureFormat == "uint8" ? BufferFormat::Unorm8Format : getBufferFormat(textureFormat);
+	input.textureChannels		= 3;
+
+	//texture sampling, the mip pyramid is built in every forward pass
+	if (textureSampling == "nearest")
+	{
+		input.textureSampling = TextureSampling::Nearest;
+	}
+	else if (textureSampling == "trilinear")
+	{
+		input.textureSampling = TextureSampling::Trilinear;
+	}
+
+	createTextureMipmap(textureMipmap, false);
+	input.d_textureMipmap		= NULL;
+	input.textureMipmapLevels	= 1;
+	input.textureMipmapTexels	= 0;
+
+	//requested outputs, the vertex normals are only kept internally if they are not requested, one copy is enough then
+	input.outputs = outputs;
+	if (!isOutputRequested(RenderOutput::VertexNormalOutput))
+	{
+		input.vertexNormalLayout = VertexNormalLayout::Shared;
+	}
+
 	//misc
 	input.N = numberOfVertices;
-	cutilSafeCall(cudaMalloc(&input.d_BBoxes,				sizeof(int4)   *	input.F*input.numberOfCameras));
-	cutilSafeCall(cudaMalloc(&input.d_projectedVertices,	sizeof(float3) *	numberOfVertices * input.numberOfCameras));
-	cutilSafeCall(cudaMalloc(&input.d_faceNormal,			sizeof(float3) *	input.F * input.numberOfCameras));
+	cutilSafeCall(cudaMalloc(&input.d_numberOfVisibleMeshlets,	sizeof(int)));
+	cutilSafeCall(cudaMalloc(&input.d_numberOfVisibleFaces,		sizeof(int)));
+	cutilSafeCall(cudaMalloc(&input.d_faceBucketSizes,			sizeof(int) *			NUMBER_OF_FACE_BUCKETS));
 
-	cutilSafeCall(cudaMalloc(&input.d_depthBuffer, sizeof(int) * input.numberOfCameras * input.h * input.w ));
+	//the number of binned faces is read back without waiting for the stream and only used to regrow the tile face lists
+	cutilSafeCall(cudaMallocHost(&input.h_numberOfBinnedFaces,	sizeof(int)));
+	cutilSafeCall(cudaEventCreateWithFlags(&input.binnedFacesEvent, cudaEventDisableTiming));
+
+	input.numberOfTilesU	= (input.w + RASTERIZER_TILE_SIZE - 1) / RASTERIZER_TILE_SIZE;
+	input.numberOfTilesV	= (input.h + RASTERIZER_TILE_SIZE - 1) / RASTERIZER_TILE_SIZE;
 
 	input.computeNormal = computeNormal;
-	textureMapFaceIdSet = false;
-	texCoords = textureCoordinates;
+	input.triangleSetup = triangleSetup;
+	input.hierarchicalZ = hierarchicalZ;
+	input.profile = profile;
+
+	//the fixed shape stages are captured once per shape and replayed afterwards
+	createLaunchGraph(geometryGraph);
+	createLaunchGraph(rasterGraph);
+	input.geometryGraph = launchGraphs ? &geometryGraph : NULL;
+	input.rasterGraph	= launchGraphs ? &rasterGraph : NULL;
+
+	//the default stream until the op sets its own
+	input.stream = 0;
+
+	//the per view and per batch element buffers, they grow with the batch size
+	setNumberOfBatches(1);
 }
 
 //==============================================================================================//
 
 CUDABasedRasterization::~CUDABasedRasterization()
 {
-	cutilSafeCall(cudaFree(input.d_BBoxes));
-	cutilSafeCall(cudaFree(input.d_projectedVertices));
-	cutilSafeCall(cudaFree(input.d_cameraExtrinsics));
-	cutilSafeCall(cudaFree(input.d_cameraIntrinsics));
-	cutilSafeCall(cudaFree(input.d_textureCoordinates));
-	cutilSafeCall(cudaFree(input.d_facesVertex));
-	cutilSafeCall(cudaFree(input.d_vertexFaces));
-	cutilSafeCall(cudaFree(input.d_vertexFacesId));
-	cutilSafeCall(cudaFree(input.d_faceNormal));
+	freeBatchBuffers();
+	destroyLaunchGraph(geometryGraph);
+	destroyLaunchGraph(rasterGraph);
+	destroyTextureMipmap(textureMipmap);
+	cutilSafeCall(cudaFree(input.d_numberOfVisibleMeshlets));
+	cutilSafeCall(cudaFree(input.d_numberOfVisibleFaces));
+	cutilSafeCall(cudaFree(input.d_faceBucketSizes));
+	cutilSafeCall(cudaFreeHost(input.h_numberOfBinnedFaces));
+	cutilSafeCall(cudaEventDestroy(input.binnedFacesEvent));
 }
 
 //==============================================================================================//
 
-void CUDABasedRasterization::getVertexFaces(int numberOfVertices, std::vector<int> faces, std::vector<int> &vertexFaces, std::vector<int> &vertexFacesId)
+void CUDABasedRasterization::setNumberOfBatches(int numberOfBatches)
 {
-	int vertexId;
-	int faceId;
-	int startId;
-	int numFacesPerVertex;
-	
-	for (int i = 0; i<numberOfVertices; i++) 
+	input.numberOfBatches	= numberOfBatches;
+	input.numberOfViews		= numberOfBatches * input.numberOfCameras;
+
+	if (numberOfBatches <= numberOfAllocatedBatches)
+		return;
+
+	if (numberOfAllocatedBatches > 0)
+		freeBatchBuffers();
+
+	numberOfAllocatedBatches = numberOfBatches;
+
+	int numberOfViews = input.numberOfViews;
+
+	cutilSafeCall(cudaMalloc(&input.d_BBoxes,				sizeof(int4)   *	input.F * numberOfViews));
+	cutilSafeCall(cudaMalloc(&input.d_faceSetups,			sizeof(FaceSetup) *	input.F * numberOfViews));
+	cutilSafeCall(cudaMalloc(&input.d_projectedVertices,	sizeof(float3) *	input.N * numberOfViews));
+	cutilSafeCall(cudaMalloc(&input.d_faceNormal,			sizeof(float3) *	input.F * numberOfBatches));
+
+	cutilSafeCall(cudaMalloc(&input.d_depthBuffer, sizeof(int) * numberOfViews * input.h * input.w ));
+	cutilSafeCall(cudaMalloc(&input.d_visibilityBuffer, sizeof(unsigned long long) * numberOfViews * input.h * input.w));
+
+	//cached camera setup, recomputed only for changed cameras
+	createCameraSetup(cameraSetup, numberOfViews, input.stream);
+	input.d_inverseExtrinsics	= cameraSetup.d_inverseExtrinsics;
+	input.d_inverseProjection	= cameraSetup.d_inverseProjection;
+	input.d_cameraCenters		= cameraSetup.d_cameraCenters;
+
+	cutilSafeCall(cudaMalloc(&input.d_meshletBounds,			sizeof(MeshletBounds) *	input.numberOfMeshlets * numberOfBatches));
+	cutilSafeCall(cudaMalloc(&input.d_visibleMeshlets,			sizeof(int2) *			input.numberOfMeshlets * numberOfViews));
+	cutilSafeCall(cudaMalloc(&input.d_visibleFaces,				sizeof(int2) *			input.F * numberOfViews));
+
+	//size classes of the binning, the small and medium faces share the first half
+	cutilSafeCall(cudaMalloc(&input.d_faceBuckets,				sizeof(int) *			2 * input.F * numberOfViews));
+
+	//tile binning, the face lists grow on demand
+	input.tileFacesCapacity = input.F * numberOfViews;
+	cutilSafeCall(cudaMalloc(&input.d_tileFaceCounts,	sizeof(int) *	input.numberOfTilesU * input.numberOfTilesV * numberOfViews));
+	cutilSafeCall(cudaMalloc(&input.d_tileFaceOffsets,	sizeof(int) *	(input.numberOfTilesU * input.numberOfTilesV * numberOfViews + 1)));
+	cutilSafeCall(cudaMalloc(&input.d_tileFaces,		sizeof(int) *	input.tileFacesCapacity));
+
+	//a readback of the old lists is complete, the frees above waited for the device
+	*input.h_numberOfBinnedFaces = 0;
+
+	//reordered mesh
+	if (topology->isReordered())
 	{
-		vertexId = i;
-		startId = vertexFaces.size();
-		
-		for (int j = 0; j<faces.size(); j += 3)
-		{
-			faceId = int(j / 3);
-			if (vertexId == faces[j] || vertexId == faces[j + 1] || vertexId == faces[j + 2])
-			{
-				vertexFaces.push_back(faceId);
-			}
-		}
-		numFacesPerVertex = vertexFaces.size() - startId;
-		if (numFacesPerVertex>0)
-		{
-			vertexFacesId.push_back(startId);
-			vertexFacesId.push_back(numFacesPerVertex);
-		}
-		else
-			std::cout << "WARNING:: --------- no faces for vertex " << vertexId << " --------- " << std::endl;
+		cutilSafeCall(cudaMalloc(&d_reorderedVertices,		sizeof(float3) *	input.N * numberOfBatches));
+		cutilSafeCall(cudaMalloc(&d_reorderedVertexColor,	sizeof(float3) *	input.N * numberOfBatches));
+		cutilSafeCall(cudaMalloc(&d_reorderedVertexNormal,	sizeof(float3) *	input.N * numberOfBatches * getNumberOfVertexNormalCopies()));
+	}
+
+	//unrequested vertex normals
+	if (!isOutputRequested(RenderOutput::VertexNormalOutput))
+	{
+		cutilSafeCall(cudaMalloc(&d_internalVertexNormal,	sizeof(float3) *	input.N * numberOfBatches));
 	}
 }
 
 //==============================================================================================//
 
-bool rayTriangleIntersectHost(float3 orig, float3 dir, float3 v0, float3 v1, float3 v2, float &t, float &a, float &b)
+void CUDABasedRasterization::freeBatchBuffers()
+{
+	cutilSafeCall(cudaFree(input.d_BBoxes));
+	cutilSafeCall(cudaFree(input.d_faceSetups));
+	cutilSafeCall(cudaFree(input.d_projectedVertices));
+	cutilSafeCall(cudaFree(input.d_faceNormal));
+	cutilSafeCall(cudaFree(input.d_depthBuffer));
+	cutilSafeCall(cudaFree(input.d_visibilityBuffer));
+	destroyCameraSetup(cameraSetup);
+	cutilSafeCall(cudaFree(input.d_meshletBounds));
+	cutilSafeCall(cudaFree(input.d_visibleMeshlets));
+	cutilSafeCall(cudaFree(input.d_visibleFaces));
+	cutilSafeCall(cudaFree(input.d_faceBuckets));
+	cutilSafeCall(cudaFree(input.d_tileFaceCounts));
+	cutilSafeCall(cudaFree(input.d_tileFaceOffsets));
+	cutilSafeCall(cudaFree(input.d_tileFaces));
+	cutilSafeCall(cudaFree(d_reorderedVertices));
+	cutilSafeCall(cudaFree(d_reorderedVertexColor));
+	cutilSafeCall(cudaFree(d_reorderedVertexNormal));
+	cutilSafeCall(cudaFree(d_internalVertexNormal));
+}
+
+//==============================================================================================//
+
+void CUDABasedRasterization::renderBuffers()
 {
-	//just to make it numerically more stable
-	v0 = v0 / 1000.f;
-	v1 = v1 / 1000.f;
-	v2 = v2 / 1000.f;
-	orig = orig / 1000.f;
-
-	// compute plane's normal
-	float3  v0v1 = v1 - v0;
-	float3  v0v2 = v2 - v0;
-
-	// no need to normalize
-	float3  N = cross(v0v1, v0v2); // N 
-
-	/////////////////////////////
-	// Step 1: finding P
-	/////////////////////////////
-
-	// check if ray and plane are parallel ?
-	float NdotRayDirection = dot(dir, N);
-	if (fabs(NdotRayDirection) < 0.0000001f) // almost 0 
+	//the texture map face ids are only needed for the normal map and shared between all users of the topology
+	if (input.computeNormal)
 	{
-		return false; // they are parallel so they don't intersect ! 
+		input.d_textureMapIds = topology->get_D_textureMapIds(input.texWidth, input.texHeight, input.stream);
 	}
-	// compute d parameter using equation 2
-	float d = dot(N, v0);
 
-	// compute t (equation 3)
-	t = (dot(v0, N) - dot(orig, N)) / NdotRayDirection;
-	// check if the triangle is in behind the ray
-	if (t < 0)
+	//the vertex normals feed the shading and the normal map even if they are not an output
+	if (!isOutputRequested(RenderOutput::VertexNormalOutput))
 	{
-		return false; // the triangle is behind 
+		input.d_vertexNormal = d_internalVertexNormal;
 	}
-	// compute the intersection point using equation 1
-	float3 P = orig + t * dir;
-
-	/////////////////////////////
-	// Step 2: inside-outside test
-	/////////////////////////////
 
-	float3 C; // vector perpendicular to triangle's plane 
+	int numberOfLaunches = updateCameraSetupGPU(cameraSetup, input.numberOfViews, input.d_cameraExtrinsics, input.d_cameraIntrinsics, input.stream);
 
-			  // edge 0
-	float3 edge0 = v1 - v0;
-	float3 vp0 = P - v0;
-	C = cross(edge0, vp0);
-	if (dot(N, C) < 0)
+	//the mip pyramid is built once per texture input and shared by all cameras of a batch element
+	if (input.albedoMode == AlbedoMode::Textured && input.textureSampling == TextureSampling::Trilinear && isOutputRequested(RenderOutput::RenderBufferOutput))
 	{
-		return false;
-	}
-	// edge 1
-	float3 edge1 = v2 - v1;
-	float3 vp1 = P - v1;
-	C = cross(edge1, vp1);
-	if ((a = dot(N, C)) < 0)
-	{
-		return false;
+		numberOfLaunches += updateTextureMipmapGPU(textureMipmap, input.d_textureMap, input.textureFormat, input.textureChannels, input.texWidth, input.texHeight, input.numberOfBatches, input.stream);
+
+		input.d_textureMipmap		= textureMipmap.d_levels;
+		input.textureMipmapLevels	= textureMipmap.numberOfLevels;
+		input.textureMipmapTexels	= textureMipmap.numberOfTexels;
 	}
-	// edge 2
-	float3 edge2 = v0 - v2;
-	float3 vp2 = P - v2;
-	C = cross(edge2, vp2);
 
-	if ((b = dot(N, C)) < 0)
+	if (!topology->isReordered())
 	{
-		return false;
+		numberOfLaunches += renderBuffersGPU(input);
 	}
+	else
+	{
+		//the kernels work in the reordered vertex ids, the inputs and outputs of the operator stay in the original ids
+		float3* d_vertices		= input.d_vertices;
+		float3* d_vertexColor	= input.d_vertexColor;
+		float3* d_vertexNormal	= input.d_vertexNormal;
 
-	float denom = dot(N, N);
-	a /= denom;
-	b /= denom;
-
-	return true; // this ray hits the triangle 
-}
+		gatherReorderedVerticesGPU(d_vertices,		d_reorderedVertices,	topology->get_D_originalVertexIds(), input.N, input.numberOfBatches, input.stream);
+		gatherReorderedVerticesGPU(d_vertexColor,	d_reorderedVertexColor, topology->get_D_originalVertexIds(), input.N, input.numberOfBatches, input.stream);
 
-//==============================================================================================//
+		input.d_vertices		= d_reorderedVertices;
+		input.d_vertexColor		= d_reorderedVertexColor;
+		input.d_vertexNormal	= d_reorderedVertexNormal;
 
-void CUDABasedRasterization::renderBuffers()
-{
-	//init the texture map face ids 
-	//this has to be done in the forward once since the texture size cannot be determined in the constructor
-	if (!textureMapFaceIdSet)
-	{
-		//texture map ids 
-		float4* h_textureMapFaceIds = new float4[input.texHeight * input.texWidth];
-		cutilSafeCall(cudaMalloc(&input.d_textureMapIds, sizeof(float4) *	input.texHeight * input.texWidth));
+		numberOfLaunches += renderBuffersGPU(input);
 
-		//init pixels
-		for (int x = 0; x < input.texWidth; x++)
-		{
-			for (int y = 0; y < input.texHeight; y++)
-			{
-				//init pixel
-				h_textureMapFaceIds[y * input.texWidth + x] = make_float4(0, 0, 0, 0);
-			}
-		}
+		numberOfLaunches += 2;
 
-#pragma omp parallel for
-		//check if it is inside a triangle
-		for (int f = 0; f < input.F; f++)
+		if (isOutputRequested(RenderOutput::VertexNormalOutput))
 		{
-			float3 texCoord0 = make_float3(input.texWidth * texCoords[f * 3 * 2 + 0 * 2 + 0], input.texHeight * (1.f - texCoords[f * 3 * 2 + 0 * 2 + 1]), 0.f);
-			float3 texCoord1 = make_float3(input.texWidth * texCoords[f * 3 * 2 + 1 * 2 + 0], input.texHeight * (1.f - texCoords[f * 3 * 2 + 1 * 2 + 1]), 0.f);
-			float3 texCoord2 = make_float3(input.texWidth * texCoords[f * 3 * 2 + 2 * 2 + 0], input.texHeight * (1.f - texCoords[f * 3 * 2 + 2 * 2 + 1]), 0.f);
-
-			int xMin = fmax(fmin(texCoord0.x, fmin(texCoord1.x, texCoord2.x)) - 2, 0);
-			int xMax = fmin(fmax(texCoord0.x, fmax(texCoord1.x, texCoord2.x)) + 2, input.texWidth);
-
-			int yMin = fmax(fmin(texCoord0.y, fmin(texCoord1.y, texCoord2.y)) - 2, 0);
-			int yMax = fmin(fmax(texCoord0.y, fmax(texCoord1.y, texCoord2.y)) + 2, input.texHeight);
-
-			for (int x = xMin; x < xMax; x++)
-			{
-				for (int y = yMin; y < yMax; y++)
-				{
-					//pixel ray
-					float3 d = make_float3(0.f, 0.f, -1.f);
-					float3 o = make_float3(x + 0.5f, y + 0.5f, 1.f);
-
-					float a, b, c, t;
-
-					bool intersect = rayTriangleIntersectHost(o, d, texCoord0, texCoord1, texCoord2, t, a, b);
-
-					if (!intersect)
-						a = b = c = -1.f;
-					else
-						c = 1.f - a - b;
-
-					if (a != -1.f && b != -1.f && c != -1.f)
-					{	
-						h_textureMapFaceIds[y * input.texWidth + x] = make_float4(f, a, b, c);
-					}
-				}
-			}
+			scatterReorderedVerticesGPU(d_reorderedVertexNormal, d_vertexNormal, topology->get_D_originalVertexIds(), input.N, input.numberOfBatches * getNumberOfVertexNormalCopies(), input.stream);
+			numberOfLaunches++;
 		}
 
-		cutilSafeCall(cudaMemcpy(input.d_textureMapIds, h_textureMapFaceIds, sizeof(float4) *	input.texHeight * input.texWidth, cudaMemcpyHostToDevice));
-		textureMapFaceIdSet = true;
+		input.d_vertices		= d_vertices;
+		input.d_vertexColor		= d_vertexColor;
+		input.d_vertexNormal	= d_vertexNormal;
 	}
 
-	renderBuffersGPU(input);
+	if (input.profile)
+	{
+		std::cout << "Forward pass: " << numberOfLaunches << " kernel launches for " << input.numberOfBatches << " batch elements of " << input.numberOfCameras << " cameras" << std::endl;
+	}
 }
@@ -2,12 +2,15 @@
 //==============================================================================================//
 
 #include <cuda_runtime.h> 
+#include <iostream>
 #include "../Utils/cudaUtil.h"
 #include "CUDABasedRasterizationInput.h"
 #include "../Utils/CameraUtil.h"
 #include "../Utils/IndexHelper.h"
 #include "../Utils/cuda_SimpleMatrixUtil.h"
 #include "../Utils/RendererUtil.h"
+#include "TextureAtlas.h"
+#include "LaunchGraph.h"
 
 #ifndef FLT_MAX
 #define FLT_MAX  1000000
@@ -18,49 +21,51 @@
 //==============================================================================================//
 
 /*
-Initializes camera data
+Initializes all arrays of all views
 */
-__global__ void initializeCamerasDevice(CUDABasedRasterizationInput input)
+__global__ void initializeDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < 1)
+	if (idx<input.w*input.h*input.numberOfViews)
 	{
-		for (int idc = 0; idc < input.numberOfCameras; idc++)
+		if (idx == 0)
 		{
-			float4x4 h_intrinsics;
-			float4x4 h_extrinsics;
+			*input.d_numberOfVisibleMeshlets = 0;
+			*input.d_numberOfVisibleFaces = 0;
+		}
+
+		if (idx < input.numberOfViews && isOutputRequested(input, CulledFacesOutput))
+			input.d_culledFaces[idx] = 0;
+
+		if (idx < 2 * input.numberOfViews && isOutputRequested(input, HiZStatisticsOutput))
+			input.d_hiZStatistics[idx] = 0;
 
-			h_extrinsics.setIdentity();
-			h_intrinsics.setIdentity();
+		if (idx < NUMBER_OF_FACE_BUCKETS)
+			input.d_faceBucketSizes[idx] = 0;
+
+		if (idx < input.numberOfViews * input.numberOfTilesU * input.numberOfTilesV)
+			input.d_tileFaceCounts[idx] = 0;
+
+		//the rasterization writes every pixel in the visibility and the shading stage
+		if (input.computeNormal)
+		{
+			input.d_depthBuffer[idx] = INT_MAX;
 
-			for (int row = 0; row < 3; row++)
+			if (isOutputRequested(input, FaceOutput))
+				input.d_faceIDBuffer[idx] = -1;
+
+			if (isOutputRequested(input, BarycentricOutput))
 			{
-				h_intrinsics(row, 0) = input.d_cameraIntrinsics[3 * idc + row].x;
-				h_intrinsics(row, 1) = input.d_cameraIntrinsics[3 * idc + row].y;
-				h_intrinsics(row, 2) = input.d_cameraIntrinsics[3 * idc + row].z;
-				h_intrinsics(row, 3) = 0.f;
-
-				h_extrinsics(row, 0) = input.d_cameraExtrinsics[3 * idc + row].x;
-				h_extrinsics(row, 1) = input.d_cameraExtrinsics[3 * idc + row].y;
-				h_extrinsics(row, 2) = input.d_cameraExtrinsics[3 * idc + row].z;
-				h_extrinsics(row, 3) = input.d_cameraExtrinsics[3 * idc + row].w;
+				storeBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 0, 0.f, input.barycentricFormat);
+				storeBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 1, 0.f, input.barycentricFormat);
 			}
 
-			float4x4 h_inExtrinsics = h_extrinsics.getInverse();
-			float4x4 h_invProjection = (h_intrinsics * h_extrinsics).getInverse();
-
-			for (int row = 0; row < 4; row++)
+			if (isOutputRequested(input, RenderBufferOutput))
 			{
-				input.d_inverseExtrinsics[4 * idc + row].x = h_inExtrinsics(row, 0);
-				input.d_inverseExtrinsics[4 * idc + row].y = h_inExtrinsics(row, 1);
-				input.d_inverseExtrinsics[4 * idc + row].z = h_inExtrinsics(row, 2);
-				input.d_inverseExtrinsics[4 * idc + row].w = h_inExtrinsics(row, 3);
-
-				input.d_inverseProjection[4 * idc + row].x = h_invProjection(row, 0);
-				input.d_inverseProjection[4 * idc + row].y = h_invProjection(row, 1);
-				input.d_inverseProjection[4 * idc + row].z = h_invProjection(row, 2);
-				input.d_inverseProjection[4 * idc + row].w = h_invProjection(row, 3);
+				storeBufferValue(input.d_renderBuffer, 3 * idx + 0, 0.f, input.renderBufferFormat);
+				storeBufferValue(input.d_renderBuffer, 3 * idx + 1, 1.f, input.renderBufferFormat);
+				storeBufferValue(input.d_renderBuffer, 3 * idx + 2, 0.f, input.renderBufferFormat);
 			}
 		}
 	}
@@ -69,405 +74,1078 @@ __global__ void initializeCamerasDevice(CUDABasedRasterizationInput input)
 //==============================================================================================//
 
 /*
-Initializes all arrays
+Computes the face normals of every batch element, they do not depend on the camera
 */
-__global__ void initializeDevice(CUDABasedRasterizationInput input)
+__global__ void renderFaceNormalDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx<input.w*input.h*input.numberOfCameras)
+	if (idx < input.numberOfBatches * input.F)
 	{
-		input.d_depthBuffer[idx] = INT_MAX;
+		int idb = idx / input.F;
+		int idf = idx % input.F;
 
-		input.d_faceIDBuffer[idx] = -1;
+		const float3* vertices = input.d_vertices + idb * input.N;
 
-		input.d_barycentricCoordinatesBuffer[2 * idx + 0] = 0.f;
-		input.d_barycentricCoordinatesBuffer[2 * idx + 1] = 0.f;
+		int indexv0 = input.d_facesVertex[idf].x;
+		int indexv1 = input.d_facesVertex[idf].y;
+		int indexv2 = input.d_facesVertex[idf].z;
 
-		input.d_renderBuffer[3 * idx + 0] = 0.f;
-		input.d_renderBuffer[3 * idx + 1] = 1.f;
-		input.d_renderBuffer[3 * idx + 2] = 0.f;
+		float3 v0 = vertices[indexv0];
+		float3 v1 = vertices[indexv1];
+		float3 v2 = vertices[indexv2];
+	
+		input.d_faceNormal[idx] = cross(v1 - v0, v2 - v0);
 	}
 }
 
 //==============================================================================================//
 
 /*
-Project the vertices into the image plane and store depth value
+Geometry stage, one thread per vertex and batch element: computes the vertex normal once and projects the vertex into the image plane
+of every camera of the batch element (with the depth). In the per camera layout the normal is copied for every camera, all kernels
+read the first copy.
 */
-__global__ void projectVerticesDevice(CUDABasedRasterizationInput input)
+__global__ void renderGeometryDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < input.numberOfCameras * input.N)
+	if (idx < input.numberOfBatches * input.N)
 	{
-		int2 index = index1DTo2D(input.numberOfCameras, input.N, idx);
-		int idc = index.x;
-		int idv = index.y;
+		int idb = idx / input.N;
+		int idv = idx % input.N;
+
+		const float3* faceNormals = input.d_faceNormal + idb * input.F;
+
+		int2 verFaceId = input.d_vertexFacesId[idv];
+		float3 vertNorm;
+		for (int i = verFaceId.x; i<verFaceId.x + verFaceId.y; i++)
+		{
+			int faceId = input.d_vertexFaces[i];
+
+			if (i == verFaceId.x)
+				vertNorm = faceNormals[faceId];
+			else
+			{
+				vertNorm.x = vertNorm.x + faceNormals[faceId].x;
+				vertNorm.y = vertNorm.y + faceNormals[faceId].y;
+				vertNorm.z = vertNorm.z + faceNormals[faceId].z;
+			}
+		}
 
-		float3 v0 = input.d_vertices[idv];
+		int numberOfNormalCopies = getNumberOfVertexNormalCopies(input);
+		for (int copy = 0; copy < numberOfNormalCopies; copy++)
+		{
+			input.d_vertexNormal[(idb * numberOfNormalCopies + copy) * input.N + idv] = vertNorm;
+		}
 
-		float3 c_v0 = getCamSpacePoint(&input.d_cameraExtrinsics[3 * idc], v0);
-		float3 i_v0 = projectPointFloat3(&input.d_cameraIntrinsics[3 * idc], c_v0);
+		float3 v0 = input.d_vertices[idx];
 
-		input.d_projectedVertices[idx] = i_v0;
+		for (int idc = idb * input.numberOfCameras; idc < (idb + 1) * input.numberOfCameras; idc++)
+		{
+			float3 c_v0 = getCamSpacePoint(&input.d_cameraExtrinsics[3 * idc], v0);
+			float3 i_v0 = projectPointFloat3(&input.d_cameraIntrinsics[3 * idc], c_v0);
+
+			input.d_projectedVertices[idc * input.N + idv] = i_v0;
+		}
 	}
 }
 
+
 //==============================================================================================//
 
 /*
-Computes the face normals
+Computes the bounding sphere and normal cone of every meshlet for the current vertex positions of every batch element
 */
-__global__ void renderFaceNormalDevice(CUDABasedRasterizationInput input)
+__global__ void computeMeshletBoundsDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < input.numberOfCameras * input.F)
+	if (idx < input.numberOfBatches * input.numberOfMeshlets)
 	{
-		int2 index = index1DTo2D(input.numberOfCameras, input.F, idx);
-		int idf = index.y;
+		int idb = idx / input.numberOfMeshlets;
+		int idm = idx % input.numberOfMeshlets;
 
-		int indexv0 = input.d_facesVertex[idf].x;
-		int indexv1 = input.d_facesVertex[idf].y;
-		int indexv2 = input.d_facesVertex[idf].z;
-
-		float3 v0 = input.d_vertices[indexv0];
-		float3 v1 = input.d_vertices[indexv1];
-		float3 v2 = input.d_vertices[indexv2];
-	
-		input.d_faceNormal[idx] = cross(v1 - v0, v2 - v0);
+		input.d_meshletBounds[idx] = computeMeshletBounds(input.d_meshlets[idm], input.d_meshletFaces, input.d_facesVertex, input.d_vertices + idb * input.N);
 	}
 }
 
 //==============================================================================================//
 
 /*
-Computes the vertex normals
+Collects the (view, meshlet) pairs which are not rejected by the frustum and normal cone test, the faces of rejected meshlets are counted as culled
 */
-__global__ void renderVertexNormalDevice(CUDABasedRasterizationInput input)
+__global__ void cullMeshletsDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < input.numberOfCameras * input.N)
+	if (idx < input.numberOfViews * input.numberOfMeshlets)
 	{
-		int2 index = index1DTo2D(input.numberOfCameras, input.N, idx);
-		int idv = index.y;
+		int2 index = index1DTo2D(input.numberOfViews, input.numberOfMeshlets, idx);
+		int idc = index.x;
+		int idm = index.y;
+		int idb = idc / input.numberOfCameras;
 
-		int2 verFaceId = input.d_vertexFacesId[idv];
-		float3 vertNorm;
-		for (int i = verFaceId.x; i<verFaceId.x + verFaceId.y; i++)
-		{
-			int faceId = input.d_vertexFaces[i];
+		float3 cameraPosition = input.d_cameraCenters[idc];
 
-			if (i == verFaceId.x)
-				vertNorm = input.d_faceNormal[faceId];
-			else
-			{
-				vertNorm.x = vertNorm.x + input.d_faceNormal[faceId].x;
-				vertNorm.y = vertNorm.y + input.d_faceNormal[faceId].y;
-				vertNorm.z = vertNorm.z + input.d_faceNormal[faceId].z;
-			}
+		if (isMeshletVisible(input.d_meshletBounds[idb * input.numberOfMeshlets + idm], input.d_cameraExtrinsics + 3 * idc, input.d_cameraIntrinsics + 3 * idc, cameraPosition, input.w, input.h, input.twoSided))
+		{
+			int visibleId = atomicAdd(input.d_numberOfVisibleMeshlets, 1);
+			input.d_visibleMeshlets[visibleId] = make_int2(idc, idm);
+		}
+		else if (isOutputRequested(input, CulledFacesOutput))
+		{
+			atomicAdd(&input.d_culledFaces[idc], input.d_meshlets[idm].y);
 		}
-		input.d_vertexNormal[idx] = vertNorm;
 	}
 }
 
+//==============================================================================================//
+
+/*
+Maps a thread of the face kernels to a face of a visible meshlet (MESHLET_SIZE threads per visible meshlet)
+*/
+__inline__ __device__ bool getVisibleFace(const CUDABasedRasterizationInput& input, unsigned int idx, int& idc, int& idf)
+{
+	int visibleId = idx / MESHLET_SIZE;
+	if (visibleId >= *input.d_numberOfVisibleMeshlets)
+		return false;
+
+	int2 visibleMeshlet = input.d_visibleMeshlets[visibleId];
+	int2 meshlet = input.d_meshlets[visibleMeshlet.y];
+
+	int faceInMeshlet = idx % MESHLET_SIZE;
+	if (faceInMeshlet >= meshlet.y)
+		return false;
+
+	idc = visibleMeshlet.x;
+	idf = input.d_meshletFaces[meshlet.x + faceInMeshlet];
+	return true;
+}
 
 //==============================================================================================//
 
 /*
-Project the vertices into the image plane,
-computes the 2D bounding box per triangle in the image plane
-and computes the maximum bounding box for all triangles of the mesh
+Returns the range (minTileU, minTileV, maxTileU, maxTileV) of screen tiles overlapped by a face bounding box
 */
-__global__ void projectFacesDevice(CUDABasedRasterizationInput input)
+__inline__ __device__ int4 getFaceTiles(int4 bbox)
 {
-	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+	return make_int4(bbox.x / RASTERIZER_TILE_SIZE, bbox.y / RASTERIZER_TILE_SIZE, bbox.z / RASTERIZER_TILE_SIZE, bbox.w / RASTERIZER_TILE_SIZE);
+}
 
-	if (idx < input.numberOfCameras * input.F)
-	{
-		int2 index = index1DTo2D(input.numberOfCameras, input.F, idx);
-		int idc = index.x;
-		int idf = index.y;
+//==============================================================================================//
+
+/*
+Culls the faces of the visible meshlets which are behind the near plane (the depth clamp of projectPointFloat3), outside the image or,
+for one sided rendering, back facing. The remaining faces get their 2D bounding box and triangle setup and are compacted into
+d_visibleFaces.
+*/
+__global__ void cullFacesDevice(CUDABasedRasterizationInput input)
+{
+	const unsigned int threadId = blockIdx.x * blockDim.x + threadIdx.x;
 
+	int idc, idf;
+	if (getVisibleFace(input, threadId, idc, idf))
+	{
 		int indexv0 = input.d_facesVertex[idf].x;
 		int indexv1 = input.d_facesVertex[idf].y;
 		int indexv2 = input.d_facesVertex[idf].z;
 
+		const float3* vertices = input.d_vertices + (idc / input.numberOfCameras) * input.N;
+
 		float3 i_v0 = input.d_projectedVertices[idc* input.N + indexv0];
 		float3 i_v1 = input.d_projectedVertices[idc* input.N + indexv1];
 		float3 i_v2 = input.d_projectedVertices[idc* input.N + indexv2];
 
-		input.d_BBoxes[idx].x = fmaxf(fminf(i_v0.x, fminf(i_v1.x, i_v2.x)) - 0.5f, 0);  //minx
-		input.d_BBoxes[idx].y = fmaxf(fminf(i_v0.y, fminf(i_v1.y, i_v2.y)) - 0.5f, 0);  //miny
+		int4 bbox = computeFaceBoundingBox(i_v0, i_v1, i_v2, input.w, input.h);
+
+		bool isCulled = (i_v0.z <= 0.00001f && i_v1.z <= 0.00001f && i_v2.z <= 0.00001f) || bbox.x > bbox.z || bbox.y > bbox.w;
+
+		//same orientation as the normal cone test of the meshlets
+		if (!isCulled && !input.twoSided)
+		{
+			float3 v0 = vertices[indexv0];
+			float3 cameraPosition = input.d_cameraCenters[idc];
+			float3 normal = cross(vertices[indexv1] - v0, vertices[indexv2] - v0);
+			isCulled = dot(normal, v0 - cameraPosition) > 0.f;
+		}
+
+		if (isCulled)
+		{
+			if (isOutputRequested(input, CulledFacesOutput))
+				atomicAdd(&input.d_culledFaces[idc], 1);
+			return;
+		}
+
+		input.d_BBoxes[idc * input.F + idf] = bbox;
+		input.d_faceSetups[idc * input.F + idf] = computeFaceSetup(i_v0, i_v1, i_v2, input.triangleSetup);
 
-		input.d_BBoxes[idx].z = fminf(fmaxf(i_v0.x, fmaxf(i_v1.x, i_v2.x)) + 0.5f, input.w - 1);   //maxx
-		input.d_BBoxes[idx].w = fminf(fmaxf(i_v0.y, fmaxf(i_v1.y, i_v2.y)) + 0.5f, input.h - 1);  //maxy
+		int visibleId = atomicAdd(input.d_numberOfVisibleFaces, 1);
+		input.d_visibleFaces[visibleId] = make_int2(idc, idf);
 	}
 }
 
 //==============================================================================================//
 
 /*
-Render the depth, faceId and barycentricCoordinates buffers
+Sorts the visible faces into the size classes of the binning by the number of tiles overlapped by their bounding box.
+The small and the medium bucket grow towards each other in the first half of d_faceBuckets, which holds all visible faces.
 */
-__global__ void renderDepthBufferDevice(CUDABasedRasterizationInput input)
+__global__ void classifyFacesDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < input.numberOfCameras * input.F)
+	if (idx < *input.d_numberOfVisibleFaces)
 	{
-		int2 index = index1DTo2D(input.numberOfCameras, input.F, idx);
-		int idc = index.x;
-		int idf = index.y;
+		int idc = input.d_visibleFaces[idx].x;
+		int idf = input.d_visibleFaces[idx].y;
 
-		int indexv0 = input.d_facesVertex[idf].x;
-		int indexv1 = input.d_facesVertex[idf].y;
-		int indexv2 = input.d_facesVertex[idf].z;
+		int4 tiles = getFaceTiles(input.d_BBoxes[idc * input.F + idf]);
+		int numberOfFaceTiles = (tiles.z - tiles.x + 1) * (tiles.w - tiles.y + 1);
+
+		int capacity = input.F * input.numberOfViews;
+
+		if (numberOfFaceTiles <= BINNING_SMALL_FACE_TILES)
+			input.d_faceBuckets[atomicAdd(&input.d_faceBucketSizes[0], 1)] = idx;
+		else if (numberOfFaceTiles <= BINNING_MEDIUM_FACE_TILES)
+			input.d_faceBuckets[capacity - 1 - atomicAdd(&input.d_faceBucketSizes[1], 1)] = idx;
+		else
+			input.d_faceBuckets[capacity + atomicAdd(&input.d_faceBucketSizes[2], 1)] = idx;
+	}
+}
+
+//==============================================================================================//
+
+/*
+Returns the shaded color of pixel pixelId of view idc covered by face idf
+*/
+__inline__ __device__ float3 shadePixel(const CUDABasedRasterizationInput& input, int idc, int idf, int pixelId, float3 abc)
+{
+	int idb = idc / input.numberOfCameras;
+	const float3* vertexNormal	= input.d_vertexNormal + idb * getNumberOfVertexNormalCopies(input) * input.N;
+	const float3* vertexColor	= input.d_vertexColor + idb * input.N;
+	int textureOffset			= idb * input.texHeight * input.texWidth;
+
+	int indexv0 = input.d_facesVertex[idf].x;
+	int indexv1 = input.d_facesVertex[idf].y;
+	int indexv2 = input.d_facesVertex[idf].z;
+
+	//get pix normal
+	float3 v0_norm = vertexNormal[indexv0];
+	float3 v1_norm = vertexNormal[indexv1];
+	float3 v2_norm = vertexNormal[indexv2];
+	float3 pixNorm = v0_norm * abc.x + v1_norm * abc.y + v2_norm * abc.z;
+	pixNorm = pixNorm / length(pixNorm);
+
+	//get normal flip
+	int u = pixelId % input.w;
+	int v = (pixelId / input.w) % input.h;
+	float3 d = getPixelRayDirection(input.d_inverseProjection + 4 * idc, input.d_cameraCenters[idc], u, v);
+	if (dot(pixNorm, d) > 0.f) 
+		pixNorm = -pixNorm;
+
+	float3 color = make_float3(0.f,0.f,0.f);
+
+	//albedo
+	if (input.albedoMode == AlbedoMode::Textured && input.textureSampling == TextureSampling::Trilinear)
+	{
+		const float3* vertices = input.d_vertices + idb * input.N;
+		float2 textureSize = make_float2(input.texWidth, input.texHeight);
+		float2 texCoord0 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 1]) * textureSize;
+		float2 texCoord1 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 1]) * textureSize;
+		float2 texCoord2 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 1]) * textureSize;
+		float2 finalTexCoord = texCoord0 * abc.x + texCoord1 * abc.y + texCoord2 * abc.z;
+
+		//the level of detail follows the footprint of the pixel in the texture
+		float lod = getTextureLOD(input.d_cameraCenters[idc], input.d_inverseProjection + 4 * idc, u, v, input.w, input.h, vertices[indexv0], vertices[indexv1], vertices[indexv2], texCoord0, texCoord1, texCoord2);
+
+		MipmapTap taps[TRILINEAR_TAPS];
+		getTrilinearTaps(finalTexCoord, lod, input.texWidth, input.texHeight, input.textureMipmapLevels, taps);
+
+		color = sampleMipmapTaps(taps, input.d_textureMap, textureOffset, input.textureChannels, input.textureFormat, input.d_textureMipmap, idb * input.textureMipmapTexels);
+	}
+	else if (input.albedoMode == AlbedoMode::Textured)
+	{
+		float2 texCoord0 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 1]);
+		float2 texCoord1 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 1]);
+		float2 texCoord2 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 1]);
+		float2 finalTexCoord = texCoord0* abc.x + texCoord1* abc.y + texCoord2* abc.z;
+		finalTexCoord.x = finalTexCoord.x * input.texWidth;
+		finalTexCoord.y = finalTexCoord.y * input.texHeight;
+
+		finalTexCoord.x = fmaxf(finalTexCoord.x, 0);
+		finalTexCoord.x = fminf(finalTexCoord.x, input.texWidth - 1);
+		finalTexCoord.y = fmaxf(finalTexCoord.y, 0);
+		finalTexCoord.y = fminf(finalTexCoord.y, input.texHeight - 1);
+		 
+		float U0 = finalTexCoord.x;
+		float V0 = finalTexCoord.y;
+
+		float  LU = int(finalTexCoord.x - 0.5f) + 0.5f;
+		float  HU = int(finalTexCoord.x - 0.5f) + 1.5f;
+
+		float  LV = int(finalTexCoord.y - 0.5f) + 0.5f;
+		float  HV = int(finalTexCoord.y - 0.5f) + 1.5f;
+
+		float3 colorLULV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)LV + (int)LU, input.textureChannels, input.textureFormat);
+
+		float3 colorLUHV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)HV + (int)LU, input.textureChannels, input.textureFormat);
+
+		float3 colorHULV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)LV + (int)HU, input.textureChannels, input.textureFormat);
+
+		float3 colorHUHV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)HV + (int)HU, input.textureChannels, input.textureFormat);
+
+		float weightLULV = (V0 - LV) * (U0 - LU);
+		float weightLUHV = (HV - V0) * (U0 - LU);
+		float weightHULV = (V0 - LV) * (HU - U0);
+		float weightHUHV = (HV - V0) * (HU - U0);
+		//printf("%f", weightLULV + weightLUHV + weightHULV + weightHUHV);
+		//color = weightLULV * colorLULV + weightHULV * colorHULV + weightLUHV * colorLUHV + weightHUHV * colorHUHV;
+		color = colorLULV;
+	}
+	else if (input.albedoMode == AlbedoMode::VertexColor)
+	{
+		color = make_float3(
+			vertexColor[indexv0].x * abc.x + vertexColor[indexv1].x * abc.y + vertexColor[indexv2].x * abc.z,
+			vertexColor[indexv0].y * abc.x + vertexColor[indexv1].y * abc.y + vertexColor[indexv2].y * abc.z,
+			vertexColor[indexv0].z * abc.x + vertexColor[indexv1].z * abc.y + vertexColor[indexv2].z * abc.z);
+	}
+	else if (input.albedoMode == AlbedoMode::Normal)
+	{
+		color = make_float3((1.f + pixNorm.x) / 2.f,  (1.f + pixNorm.y) / 2.f, (1.f + pixNorm.z) / 2.f);
+	}
+	else if (input.albedoMode == AlbedoMode::Lighting)
+	{
+		color = make_float3(1.f, 1.f, 1.f);
+	}
+	else if (input.albedoMode == AlbedoMode::ForegroundMask)
+	{
+		color = make_float3(1.f, 1.f, 1.f);
+	}
+	
+	//shading
+	if ((input.shadingMode == ShadingMode::Shaded && (input.albedoMode != AlbedoMode::Normal)) || input.albedoMode == AlbedoMode::Lighting)
+	{
+		color = getShading(color, pixNorm, input.d_shCoeff + (idc * 27));
+	}
+
+	return color;
+}
+
+//==============================================================================================//
+
+/*
+Exclusive prefix sum over the face counts of all tiles (single block), resets the counts for the binning
+*/
+__global__ void scanTileFacesDevice(CUDABasedRasterizationInput input)
+{
+	__shared__ int partialSums[THREADS_PER_BLOCK_CUDABASEDRASTERIZER];
+
+	int numberOfTiles = input.numberOfViews * input.numberOfTilesU * input.numberOfTilesV;
+	int runningSum = 0;
+
+	for (int chunkStart = 0; chunkStart < numberOfTiles; chunkStart += blockDim.x)
+	{
+		int tileId = chunkStart + threadIdx.x;
+		int count = tileId < numberOfTiles ? input.d_tileFaceCounts[tileId] : 0;
+
+		partialSums[threadIdx.x] = count;
+		__syncthreads();
+
+		//inclusive scan of the chunk
+		for (int offset = 1; offset < blockDim.x; offset *= 2)
+		{
+			int value = threadIdx.x >= offset ? partialSums[threadIdx.x - offset] : 0;
+			__syncthreads();
+			partialSums[threadIdx.x] += value;
+			__syncthreads();
+		}
+
+		if (tileId < numberOfTiles)
+		{
+			input.d_tileFaceOffsets[tileId] = runningSum + partialSums[threadIdx.x] - count;
+			input.d_tileFaceCounts[tileId] = 0;
+		}
+
+		runningSum += partialSums[blockDim.x - 1];
+		__syncthreads();
+	}
+
+	if (threadIdx.x == 0)
+		input.d_tileFaceOffsets[numberOfTiles] = runningSum;
+}
+
+//==============================================================================================//
+
+/*
+Counts the face in (countOnly) or writes it into the tiles of its tile range with the row major index in [firstTile, lastTile) and step stride.
+Entries past tileFacesCapacity are dropped, the rasterization takes the faces of those tiles from d_visibleFaces.
+*/
+__inline__ __device__ void binFaceTiles(CUDABasedRasterizationInput& input, int idc, int idf, int4 tiles, int firstTile, int lastTile, int stride, bool countOnly)
+{
+	int numberOfColumns = tiles.z - tiles.x + 1;
+
+	for (int tile = firstTile; tile < lastTile; tile += stride)
+	{
+		int tileId = (idc * input.numberOfTilesV + tiles.y + tile / numberOfColumns) * input.numberOfTilesU + tiles.x + tile % numberOfColumns;
+		int slot = atomicAdd(&input.d_tileFaceCounts[tileId], 1);
+
+		if (!countOnly && input.d_tileFaceOffsets[tileId] + slot < input.tileFacesCapacity)
+			input.d_tileFaces[input.d_tileFaceOffsets[tileId] + slot] = idf;
+	}
+}
+
+//==============================================================================================//
+
+/*
+Maps an entry of d_faceBuckets to the camera, face and tile range of the visible face
+*/
+__inline__ __device__ int4 getBucketFace(const CUDABasedRasterizationInput& input, int bucketId, int& idc, int& idf)
+{
+	int2 visibleFace = input.d_visibleFaces[input.d_faceBuckets[bucketId]];
+	idc = visibleFace.x;
+	idf = visibleFace.y;
+	return getFaceTiles(input.d_BBoxes[idc * input.F + idf]);
+}
+
+//==============================================================================================//
+
+/*
+Bins the small faces, one thread per face. The threads stride over the small faces counted by classifyFacesDevice.
+*/
+template<bool countOnly>
+__global__ void binSmallFacesDevice(CUDABasedRasterizationInput input)
+{
+	int numberOfFaces = input.d_faceBucketSizes[0];
+
+	for (int idx = blockIdx.x * blockDim.x + threadIdx.x; idx < numberOfFaces; idx += gridDim.x * blockDim.x)
+	{
+		int idc, idf;
+		int4 tiles = getBucketFace(input, idx, idc, idf);
+
+		binFaceTiles(input, idc, idf, tiles, 0, (tiles.z - tiles.x + 1) * (tiles.w - tiles.y + 1), 1, countOnly);
+	}
+}
+
+//==============================================================================================//
+
+/*
+Bins the medium faces, one warp per face with the tiles interleaved over the lanes. The warps stride over the medium faces counted by
+classifyFacesDevice.
+*/
+template<bool countOnly>
+__global__ void binMediumFacesDevice(CUDABasedRasterizationInput input)
+{
+	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+	int numberOfFaces = input.d_faceBucketSizes[1];
+	int numberOfWarps = gridDim.x * blockDim.x / WARP_SIZE;
+	int lane = idx % WARP_SIZE;
+
+	for (int faceId = idx / WARP_SIZE; faceId < numberOfFaces; faceId += numberOfWarps)
+	{
+		int idc, idf;
+		int4 tiles = getBucketFace(input, input.F * input.numberOfViews - 1 - faceId, idc, idf);
+
+		binFaceTiles(input, idc, idf, tiles, lane, (tiles.z - tiles.x + 1) * (tiles.w - tiles.y + 1), WARP_SIZE, countOnly);
+	}
+}
+
+//==============================================================================================//
+
+/*
+Bins the large faces, the tile range of a face is split into bands of whole rows of about blockDim.x tiles and one block handles
+one band. Every face has numberOfTilesV band slots, the blocks of the fixed pool stride over the slots of the large faces counted
+by classifyFacesDevice and skip the slots past the last band of their face.
+*/
+template<bool countOnly>
+__global__ void binLargeFacesDevice(CUDABasedRasterizationInput input)
+{
+	int numberOfBands = input.d_faceBucketSizes[2] * input.numberOfTilesV;
+
+	for (int band = blockIdx.x; band < numberOfBands; band += gridDim.x)
+	{
+		int idc, idf;
+		int4 tiles = getBucketFace(input, input.F * input.numberOfViews + band / input.numberOfTilesV, idc, idf);
+
+		int numberOfColumns = tiles.z - tiles.x + 1;
+		int numberOfRows = tiles.w - tiles.y + 1;
+		int rowsPerBand = max(1, (int)blockDim.x / numberOfColumns);
+
+		int firstRow = (band % input.numberOfTilesV) * rowsPerBand;
+		if (firstRow >= numberOfRows)
+			continue;
+
+		int lastRow = min(numberOfRows, firstRow + rowsPerBand);
+
+		binFaceTiles(input, idc, idf, tiles, firstRow * numberOfColumns + threadIdx.x, lastRow * numberOfColumns, blockDim.x, countOnly);
+	}
+}
+
+//==============================================================================================//
+
+/*
+Face data staged in shared memory by the fine rasterization
+*/
+struct TileFace
+{
+	int			faceId;
+	int4		bbox;
+	FaceSetup	setup;
+};
 
-		float3 vertex0 = input.d_projectedVertices[input.N*idc + indexv0];
-		float3 vertex1 = input.d_projectedVertices[input.N*idc + indexv1];
-		float3 vertex2 = input.d_projectedVertices[input.N*idc + indexv2];
+//==============================================================================================//
 
-		for (int u = input.d_BBoxes[idx].x; u <= input.d_BBoxes[idx].z; u++)
+/*
+Coverage, barycentrics and depth of a face at a pixel. Faces without a triangle setup (see computeFaceSetup) fall back to ray casting.
+*/
+__inline__ __device__ bool rasterizeFaceDevice(const CUDABasedRasterizationInput& input, int idc, int idf, const FaceSetup& setup, int u, int v, float3& abc, float& depth)
+{
+	if (setup.anchor.z == 0.f)
+		return rasterizeFaceSetupPixel(u, v, setup, abc, depth);
+
+	int3 face = input.d_facesVertex[idf];
+	const float3* vertices = input.d_vertices + (idc / input.numberOfCameras) * input.N;
+	float3 projectedDepth = make_float3(input.d_projectedVertices[input.N*idc + face.x].z, input.d_projectedVertices[input.N*idc + face.y].z, input.d_projectedVertices[input.N*idc + face.z].z);
+	float3 rayDirection = getPixelRayDirection(input.d_inverseProjection + 4 * idc, input.d_cameraCenters[idc], u, v);
+	return rasterizeFacePixel(input.d_cameraCenters[idc], rayDirection, vertices[face.x], vertices[face.y], vertices[face.z], projectedDepth, abc, depth);
+}
+
+//==============================================================================================//
+
+/*
+Renders the visibility buffer, one block per view and tile and one thread per pixel.
+The faces of the tile are staged in shared memory in chunks of RASTERIZER_CHUNK_SIZE. Every pixel keeps the minimum of the packed
+(depth, original face id) keys (see Visibility.h), so depth ties are resolved towards the smaller face id.
+With the hierarchical depth test the far depth of the tile is taken after every chunk, and faces whose nearest vertex is
+behind it are not staged.
+If the face list of the tile did not fit into tileFacesCapacity, the tile walks over all visible faces instead and stages those of
+its view that overlap it. The keys do not depend on the order of the faces, so the result is the same, only slower.
+*/
+__global__ void rasterizeTilesDevice(CUDABasedRasterizationInput input)
+{
+	__shared__ TileFace tileFaces[RASTERIZER_CHUNK_SIZE];
+	__shared__ int chunkSize;
+	__shared__ unsigned int tileFarDepthBits;
+
+	int numberOfTilesPerCamera = input.numberOfTilesU * input.numberOfTilesV;
+	int tileId = blockIdx.x;
+	int idc = tileId / numberOfTilesPerCamera;
+	int tileU = (tileId % numberOfTilesPerCamera) % input.numberOfTilesU;
+	int tileV = (tileId % numberOfTilesPerCamera) / input.numberOfTilesU;
+
+	int u = tileU * RASTERIZER_TILE_SIZE + threadIdx.x % RASTERIZER_TILE_SIZE;
+	int v = tileV * RASTERIZER_TILE_SIZE + threadIdx.x / RASTERIZER_TILE_SIZE;
+	bool isPixel = u < input.w && v < input.h;
+
+	int tileStart = input.d_tileFaceOffsets[tileId];
+	int tileEnd = input.d_tileFaceOffsets[tileId + 1];
+
+	//the faces of an overflowed tile come from the visible faces
+	bool overflowed = tileEnd > input.tileFacesCapacity;
+	int facesStart = overflowed ? 0 : tileStart;
+	int facesEnd = overflowed ? *input.d_numberOfVisibleFaces : tileEnd;
+
+	unsigned long long bestKey = VISIBILITY_EMPTY;
+
+	float tileFarDepth = VISIBILITY_EMPTY_DEPTH;
+	int numberOfStagedFaces = 0;
+
+	if (threadIdx.x == 0)
+	{
+		chunkSize = 0;
+		tileFarDepthBits = 0;
+	}
+	__syncthreads();
+
+	for (int chunkStart = facesStart; chunkStart < facesEnd; chunkStart += RASTERIZER_CHUNK_SIZE)
+	{
+		if (threadIdx.x < RASTERIZER_CHUNK_SIZE && chunkStart + threadIdx.x < facesEnd)
 		{
-			for (int v = input.d_BBoxes[idx].y; v <= input.d_BBoxes[idx].w; v++)
+			int idf = -1;
+			if (!overflowed)
+			{
+				idf = input.d_tileFaces[chunkStart + threadIdx.x];
+			}
+			else
 			{
-				float2 pixelCenter1 = make_float2(u + 0.5f, v + 0.5f);
+				int2 visibleFace = input.d_visibleFaces[chunkStart + threadIdx.x];
+				int4 tiles = getFaceTiles(input.d_BBoxes[visibleFace.x * input.F + visibleFace.y]);
 
-				float3 abc = uv2barycentric(pixelCenter1.x, pixelCenter1.y, input.d_vertices[indexv0], input.d_vertices[indexv1], input.d_vertices[indexv2], input.d_inverseExtrinsics + idc * 4, input.d_inverseProjection + idc * 4);
-				
-				float z = FLT_MAX;
-				
-				bool isInsideTriangle = (abc.x >= -0.001f) && (abc.y >= -0.001f) && (abc.z >= -0.001f) && (abc.x <= 1.001f) && (abc.y <= 1.001f) && (abc.z <= 1.001f);
+				if (visibleFace.x == idc && tileU >= tiles.x && tileU <= tiles.z && tileV >= tiles.y && tileV <= tiles.w)
+					idf = visibleFace.y;
+			}
 
-				if (isInsideTriangle)
-				{
-					z = 1.f / (abc.x / vertex0.z + abc.y / vertex1.z + abc.z / vertex2.z); //Perspective-Correct Interpolation
-					z *= 10000.f;
-					int pixelId = idc* input.w* input.h + input.w * v + u;
-					atomicMin(&input.d_depthBuffer[pixelId], z);
-				}
+			FaceSetup setup;
+			if (idf >= 0)
+				setup = input.d_faceSetups[idc * input.F + idf];
+
+			if (idf >= 0 && setup.anchor.w * (1.f - HIZ_DEPTH_TOLERANCE) <= tileFarDepth)
+			{
+				TileFace& tileFace = tileFaces[atomicAdd(&chunkSize, 1)];
+				tileFace.faceId = idf;
+				tileFace.bbox = input.d_BBoxes[idc * input.F + idf];
+				tileFace.setup = setup;
 			}
 		}
+		__syncthreads();
+
+		int numberOfChunkFaces = chunkSize;
+		numberOfStagedFaces += numberOfChunkFaces;
+
+		for (int k = 0; isPixel && k < numberOfChunkFaces; k++)
+		{
+			const TileFace& tileFace = tileFaces[k];
+
+			if (u < tileFace.bbox.x || u > tileFace.bbox.z || v < tileFace.bbox.y || v > tileFace.bbox.w)
+				continue;
+
+			float3 abc;
+			float depth;
+			if (rasterizeFaceDevice(input, idc, tileFace.faceId, tileFace.setup, u, v, abc, depth))
+			{
+				int faceId = input.d_originalFaceIds != NULL ? input.d_originalFaceIds[tileFace.faceId] : tileFace.faceId;
+
+				unsigned long long key = packVisibility(depth, faceId, input.visibilityMode);
+				if (key < bestKey)
+					bestKey = key;
+			}
+		}
+
+		//far depth of the tile, the bits of non negative floats have the same order as the values
+		if (input.hierarchicalZ)
+			atomicMax(&tileFarDepthBits, __float_as_uint(isPixel ? fmaxf(unpackVisibilityFarDepth(bestKey, input.visibilityMode), 0.f) : 0.f));
+		__syncthreads();
+
+		if (input.hierarchicalZ)
+			tileFarDepth = __uint_as_float(tileFarDepthBits);
+		__syncthreads();
+
+		if (threadIdx.x == 0)
+		{
+			chunkSize = 0;
+			tileFarDepthBits = 0;
+		}
+		__syncthreads();
+	}
+
+	if (isPixel)
+		input.d_visibilityBuffer[idc* input.w* input.h + input.w * v + u] = bestKey;
+
+	if (threadIdx.x == 0 && tileEnd > tileStart && isOutputRequested(input, HiZStatisticsOutput))
+	{
+		atomicAdd(&input.d_hiZStatistics[2 * idc + 0], tileEnd - tileStart);
+		atomicAdd(&input.d_hiZStatistics[2 * idc + 1], tileEnd - tileStart - numberOfStagedFaces);
 	}
 }
 
 //==============================================================================================//
 
 /*
-Render the faceId and barycentricCoordinates buffers
+Returns the face id (original ids) of the visibility key of pixel idx, -1 for an empty pixel, and the barycentric coordinates of
+the face at the pixel. The barycentrics of the visible face are evaluated again, which keeps them out of the registers of the
+tile rasterizer. If the evaluation misses the face (at silhouette and precision edges), the pixel is resolved as empty.
 */
-__global__ void renderBuffersDevice(CUDABasedRasterizationInput input)
+__inline__ __device__ int resolvePixelDevice(const CUDABasedRasterizationInput& input, int idx, unsigned long long key, float3& abc)
+{
+	abc = make_float3(0.f, 0.f, 1.f);
+
+	if (key == VISIBILITY_EMPTY)
+	{
+		return -1;
+	}
+
+	int idc = idx / (input.w * input.h);
+	int u = (idx % (input.w * input.h)) % input.w;
+	int v = (idx % (input.w * input.h)) / input.w;
+
+	int faceId = unpackVisibilityFaceId(key);
+	int idf = input.d_reorderedFaceIds != NULL ? input.d_reorderedFaceIds[faceId] : faceId;
+
+	float depth;
+	if (!rasterizeFaceDevice(input, idc, idf, input.d_faceSetups[idc * input.F + idf], u, v, abc, depth))
+	{
+		abc = make_float3(0.f, 0.f, 1.f);
+		return -1;
+	}
+
+	return faceId;
+}
+
+//==============================================================================================//
+
+/*
+Visibility stage: writes the face id (original ids), the barycentric coordinates and the depth of the visible face of every pixel,
+empty pixels get face id -1. Only the requested buffers are written.
+*/
+__global__ void resolveVisibilityDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < input.numberOfCameras * input.F)
+	if (idx < input.w*input.h*input.numberOfViews)
 	{
-		int2 index = index1DTo2D(input.numberOfCameras, input.F, idx);
-		int idc = index.x;
-		int idf = index.y;
+		unsigned long long key = input.d_visibilityBuffer[idx];
 
-		int indexv0 = input.d_facesVertex[idf].x;
-		int indexv1 = input.d_facesVertex[idf].y;
-		int indexv2 = input.d_facesVertex[idf].z;
+		float3 abc;
+		int faceId = resolvePixelDevice(input, idx, key, abc);
 
-		float3 vertex0 = input.d_projectedVertices[input.N*idc + indexv0];
-		float3 vertex1 = input.d_projectedVertices[input.N*idc + indexv1];
-		float3 vertex2 = input.d_projectedVertices[input.N*idc + indexv2];
+		if (isOutputRequested(input, FaceOutput))
+			input.d_faceIDBuffer[idx] = faceId;
 
-		for (int u = input.d_BBoxes[idx].x; u <= input.d_BBoxes[idx].z; u++)
+		if (isOutputRequested(input, BarycentricOutput))
 		{
-			for (int v = input.d_BBoxes[idx].y; v <= input.d_BBoxes[idx].w; v++)
-			{
-				float2 pixelCenter1 = make_float2(u + 0.5f, v + 0.5f);
+			storeBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 0, abc.x, input.barycentricFormat);
+			storeBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 1, abc.y, input.barycentricFormat);
+		}
 
-				float3 abc = uv2barycentric(pixelCenter1.x, pixelCenter1.y, input.d_vertices[indexv0], input.d_vertices[indexv1], input.d_vertices[indexv2], input.d_inverseExtrinsics + idc * 4, input.d_inverseProjection + idc * 4);
+		input.d_depthBuffer[idx] = faceId >= 0 ? unpackVisibilityDepth(key, input.visibilityMode) : INT_MAX;
+	}
+}
 
-				bool isInsideTriangle = (abc.x >= -0.001f) && (abc.y >= -0.001f) && (abc.z >= -0.001f) && (abc.x <= 1.001f) && (abc.y <= 1.001f) && (abc.z <= 1.001f);
-	
-				float z = 1.f / (abc.x / vertex0.z + abc.y / vertex1.z + abc.z / vertex2.z); //Perspective-Correct Interpolation
-				z *= 10000.f;
+//==============================================================================================//
 
-				int pixelId = idc* input.w* input.h + input.w * v + u;
+/*
+Shading stage, one thread per pixel over the outputs of the visibility stage. If the face or the barycentric buffer is not requested
+or the barycentrics are stored in a reduced format, the pixel is resolved from the visibility buffer instead, so the render buffer
+does not depend on the barycentric format. The colors of a block are staged in shared memory, so the block writes its part of the
+render buffer as consecutive values, converted to the render buffer format.
+*/
+__global__ void shadePixelsDevice(CUDABasedRasterizationInput input)
+{
+	__shared__ float colors[3 * THREADS_PER_BLOCK_CUDABASEDRASTERIZER];
 
-				if (isInsideTriangle && (int)z == input.d_depthBuffer[pixelId])
-				{
-					int pixelId1 = 2 * idc* input.w * input.h + 2 * input.w * v + 2 * u;
-					int pixelId2 = 3 * idc* input.w * input.h + 3 * input.w * v + 3 * u;
-
-					//face buffer
-					input.d_faceIDBuffer[pixelId] = idf;
-				
-					//barycentric buffer
-					input.d_barycentricCoordinatesBuffer[pixelId1 + 0] = abc.x;
-					input.d_barycentricCoordinatesBuffer[pixelId1 + 1] = abc.y;
-
-					//get pix normal
-					float3 v0_norm = input.d_vertexNormal[input.N*idc + indexv0];
-					float3 v1_norm = input.d_vertexNormal[input.N*idc + indexv1];
-					float3 v2_norm = input.d_vertexNormal[input.N*idc + indexv2];
-					float3 pixNorm = v0_norm * abc.x + v1_norm * abc.y + v2_norm * abc.z;
-					pixNorm = pixNorm / length(pixNorm);
-
-					//get normal flip
-					float3 o = make_float3(0.f, 0.f, 0.f);
-					float3 d = make_float3(0.f, 0.f, 0.f);
-					getRayCuda2(pixelCenter1, o, d, input.d_inverseExtrinsics + idc * 4, input.d_inverseProjection + idc * 4);
-					if (dot(pixNorm, d) > 0.f) 
-						pixNorm = -pixNorm;
-
-					float3 color = make_float3(0.f,0.f,0.f);
-
-					//albedo
-					if (input.albedoMode == AlbedoMode::Textured)
-					{
-						float2 texCoord0 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 1]);
-						float2 texCoord1 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 1]);
-						float2 texCoord2 = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 1]);
-						float2 finalTexCoord = texCoord0* abc.x + texCoord1* abc.y + texCoord2* abc.z;
-						finalTexCoord.x = finalTexCoord.x * input.texWidth;
-						finalTexCoord.y = finalTexCoord.y * input.texHeight;
-
-						finalTexCoord.x = fmaxf(finalTexCoord.x, 0);
-						finalTexCoord.x = fminf(finalTexCoord.x, input.texWidth - 1);
-						finalTexCoord.y = fmaxf(finalTexCoord.y, 0);
-						finalTexCoord.y = fminf(finalTexCoord.y, input.texHeight - 1);
-						 
-						float U0 = finalTexCoord.x;
-						float V0 = finalTexCoord.y;
-
-						float  LU = int(finalTexCoord.x - 0.5f) + 0.5f;
-						float  HU = int(finalTexCoord.x - 0.5f) + 1.5f;
-
-						float  LV = int(finalTexCoord.y - 0.5f) + 0.5f;
-						float  HV = int(finalTexCoord.y - 0.5f) + 1.5f;
-
-						float3 colorLULV = make_float3(
-							input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)LU + 0],
-							input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)LU + 1],
-							input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)LU + 2]);
-
-						float3 colorLUHV = make_float3(
-							input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)LU + 0],
-							input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)LU + 1],
-							input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)LU + 2]);
-
-						float3 colorHULV = make_float3(
-							input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)HU + 0],
-							input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)HU + 1],
-							input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)HU + 2]);
-
-						float3 colorHUHV = make_float3(
-							input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)HU + 0],
-							input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)HU + 1],
-							input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)HU + 2]);
-
-						float weightLULV = (V0 - LV) * (U0 - LU);
-						float weightLUHV = (HV - V0) * (U0 - LU);
-						float weightHULV = (V0 - LV) * (HU - U0);
-						float weightHUHV = (HV - V0) * (HU - U0);
-						//printf("%f", weightLULV + weightLUHV + weightHULV + weightHUHV);
-						//color = weightLULV * colorLULV + weightHULV * colorHULV + weightLUHV * colorLUHV + weightHUHV * colorHUHV;
-						color = colorLULV;
-					}
-					else if (input.albedoMode == AlbedoMode::VertexColor)
-					{
-						color = make_float3(
-							input.d_vertexColor[indexv0].x * abc.x + input.d_vertexColor[indexv1].x * abc.y + input.d_vertexColor[indexv2].x * abc.z,
-							input.d_vertexColor[indexv0].y * abc.x + input.d_vertexColor[indexv1].y * abc.y + input.d_vertexColor[indexv2].y * abc.z,
-							input.d_vertexColor[indexv0].z * abc.x + input.d_vertexColor[indexv1].z * abc.y + input.d_vertexColor[indexv2].z * abc.z);
-					}
-					else if (input.albedoMode == AlbedoMode::Normal)
-					{
-						color = make_float3((1.f + pixNorm.x) / 2.f,  (1.f + pixNorm.y) / 2.f, (1.f + pixNorm.z) / 2.f);
-					}
-					else if (input.albedoMode == AlbedoMode::Lighting)
-					{
-						color = make_float3(1.f, 1.f, 1.f);
-					}
-					else if (input.albedoMode == AlbedoMode::ForegroundMask)
-					{
-						color = make_float3(1.f, 1.f, 1.f);
-					}
-					
-					//shading
-					if ((input.shadingMode == ShadingMode::Shaded && (input.albedoMode != AlbedoMode::Normal)) || input.albedoMode == AlbedoMode::Lighting)
-					{
-						color = getShading(color, pixNorm, input.d_shCoeff + (idc * 27));
-					}
-
-					input.d_renderBuffer[pixelId2 + 0] = color.x;
-					input.d_renderBuffer[pixelId2 + 1] = color.y;
-					input.d_renderBuffer[pixelId2 + 2] = color.z;
-				}
-			}
+	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+	const int numberOfPixels = input.w*input.h*input.numberOfViews;
+
+	//background
+	float3 color = make_float3(0.f, 1.f, 0.f);
+
+	if (idx < numberOfPixels)
+	{
+		int faceId;
+		float a, b;
+
+		if (isOutputRequested(input, FaceOutput) && isOutputRequested(input, BarycentricOutput) && input.barycentricFormat == BufferFormat::Float32Format)
+		{
+			faceId = input.d_faceIDBuffer[idx];
+			a = loadBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 0, input.barycentricFormat);
+			b = loadBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 1, input.barycentricFormat);
+		}
+		else
+		{
+			float3 abc;
+			faceId = resolvePixelDevice(input, idx, input.d_visibilityBuffer[idx], abc);
+			a = abc.x;
+			b = abc.y;
+		}
+
+		if (faceId >= 0)
+		{
+			int idc = idx / (input.w * input.h);
+			int idf = input.d_reorderedFaceIds != NULL ? input.d_reorderedFaceIds[faceId] : faceId;
+
+			color = shadePixel(input, idc, idf, idx, make_float3(a, b, 1.f - a - b));
 		}
 	}
+
+	colors[3 * threadIdx.x + 0] = color.x;
+	colors[3 * threadIdx.x + 1] = color.y;
+	colors[3 * threadIdx.x + 2] = color.z;
+	__syncthreads();
+
+	int blockStart = blockIdx.x * blockDim.x;
+	int numberOfBlockValues = 3 * min((int)blockDim.x, numberOfPixels - blockStart);
+
+	for (int i = threadIdx.x; i < numberOfBlockValues; i += blockDim.x)
+	{
+		storeBufferValue(input.d_renderBuffer, 3 * blockStart + i, colors[i], input.renderBufferFormat);
+	}
 }
 
 //==============================================================================================//
 
 /*
-Render the normal map buffers
+Render the normal map buffers of every batch element
 */
 __global__ void renderNormalMapDevice(CUDABasedRasterizationInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < input.texHeight * input.texWidth)
+	if (idx < input.numberOfBatches * input.texHeight * input.texWidth)
 	{
-		int2 index = index1DTo2D(input.texHeight, input.texWidth, idx);
-		int pixV = index.x;
-		int pixU = index.y;
+		int3 index = index1DTo3D(input.numberOfBatches, input.texHeight, input.texWidth, idx);
+		int idb = index.x;
+		int pixV = index.y;
+		int pixU = index.z;
 
-		float4 pixInfo = input.d_textureMapIds[pixV * input.texWidth + pixU];
-		int idf = pixInfo.x;
-		float3 abc = make_float3(pixInfo.y, pixInfo.z, pixInfo.w);
+		TextureAtlasTexel texel = input.d_textureMapIds[pixV * input.texWidth + pixU];
+
+		//texels outside of all uv triangles get the zero normal
+		if (texel.x == TEXTURE_ATLAS_EMPTY_TEXEL)
+		{
+			input.d_normalMap[idx] = make_float3(0.5f, 0.5f, 0.5f);
+			return;
+		}
+
+		const float3* vertexNormal = input.d_vertexNormal + idb * getNumberOfVertexNormalCopies(input) * input.N;
+
+		int idf = texel.x;
+		float3 abc = unpackTextureAtlasBarycentric(texel);
 
 		int indexv0 = input.d_facesVertex[idf].x;
 		int indexv1 = input.d_facesVertex[idf].y;
 		int indexv2 = input.d_facesVertex[idf].z;
 
 		//get pix normal
-		float3 v0_norm = input.d_vertexNormal[indexv0];
-		float3 v1_norm = input.d_vertexNormal[indexv1];
-		float3 v2_norm = input.d_vertexNormal[indexv2];
+		float3 v0_norm = vertexNormal[indexv0];
+		float3 v1_norm = vertexNormal[indexv1];
+		float3 v2_norm = vertexNormal[indexv2];
 		float3 pixNorm = v0_norm * abc.x + v1_norm * abc.y + v2_norm * abc.z;
 
 		if (length(pixNorm) != 0.f)
 			pixNorm = pixNorm / length(pixNorm);
 
 		pixNorm = (pixNorm + make_float3(1.f, 1.f, 1.f)) / 2.f;
-		input.d_normalMap[pixV * input.texWidth + pixU] = pixNorm;
+		input.d_normalMap[idx] = pixNorm;
 	}
 }
 
 //==============================================================================================//
 
-extern "C" void renderBuffersGPU(CUDABasedRasterizationInput& input)
+/*
+Launches one pass of the binning over the three size classes and returns the number of kernel launches. The grids are sized for
+the upper bound of F * numberOfViews faces per class and capped at BINNING_MAX_BLOCKS, the kernels read the sizes of their classes
+on the device, so the host does not wait for the classification. If events is not NULL, it receives the start of every class and
+the end of the pass.
+*/
+template<bool countOnly>
+static int binFacesGPU(const CUDABasedRasterizationInput& input, cudaStream_t stream, cudaEvent_t* events)
 {
-	initializeCamerasDevice		<< < 1, 1 >> > (input);
+	int numberOfFaces = input.F * input.numberOfViews;
 
-	initializeDevice			<< <(input.w*input.h*input.numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> > (input);
+	int smallBlocks		= min(BINNING_MAX_BLOCKS, (numberOfFaces + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER);
+	int mediumBlocks	= min(BINNING_MAX_BLOCKS, (numberOfFaces * WARP_SIZE + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER);
+	int largeBlocks		= min(BINNING_MAX_BLOCKS, numberOfFaces * input.numberOfTilesV);
 
-	projectVerticesDevice		<< <(input.N*input.numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >(input);
+	if (events != NULL)
+		cutilSafeCall(cudaEventRecord(events[0], stream));
 
-	projectFacesDevice			<< <(input.F*input.numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >(input);
+	binSmallFacesDevice<countOnly>		<< <smallBlocks, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
 
-	renderFaceNormalDevice		<< <(input.F*input.numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >(input);
+	if (events != NULL)
+		cutilSafeCall(cudaEventRecord(events[1], stream));
 
-	renderVertexNormalDevice	<< <(input.N*input.numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >(input);
+	binMediumFacesDevice<countOnly>		<< <mediumBlocks, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+
+	if (events != NULL)
+		cutilSafeCall(cudaEventRecord(events[2], stream));
+
+	binLargeFacesDevice<countOnly>		<< <largeBlocks, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+
+	if (events != NULL)
+		cutilSafeCall(cudaEventRecord(events[3], stream));
+
+	return NUMBER_OF_FACE_BUCKETS;
+}
+
+//==============================================================================================//
+
+/*
+Geometry stage: initialization, camera independent geometry and either the normal map or the culling and classification of the faces.
+The normal map and the culling are skipped if none of their outputs is requested. Every kernel only takes the input, so the stage
+can be replayed from a launch graph. Returns the number of kernel launches.
+*/
+static int launchGeometryStageGPU(const CUDABasedRasterizationInput& input, cudaStream_t stream)
+{
+	initializeDevice			<< <(input.w*input.h*input.numberOfViews + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+
+	//camera independent geometry, the normals are computed once for all cameras
+	renderFaceNormalDevice		<< <(input.F*input.numberOfBatches + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> >(input);
+
+	renderGeometryDevice		<< <(input.N*input.numberOfBatches + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> >(input);
 
 	if (input.computeNormal)
 	{
-		renderNormalMapDevice << <(input.texWidth*input.texHeight + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> > (input);
+		if (!isOutputRequested(input, NormalMapOutput))
+			return 3;
+
+		renderNormalMapDevice << <(input.texWidth*input.texHeight*input.numberOfBatches + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+		return 4;
 	}
-	else
+
+	if (!isRasterizationRequested(input) && !isOutputRequested(input, CulledFacesOutput))
+		return 3;
+
+	//the face culling only runs for the faces of the meshlets which pass the culling, the binning only for the remaining faces
+	int numberOfMeshletThreads = input.numberOfViews * input.numberOfMeshlets * MESHLET_SIZE;
+
+	computeMeshletBoundsDevice	<< <(input.numberOfMeshlets*input.numberOfBatches + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+
+	cullMeshletsDevice			<< <(input.numberOfMeshlets*input.numberOfViews + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+
+	cullFacesDevice				<< <(numberOfMeshletThreads + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+
+	classifyFacesDevice			<< <(input.F*input.numberOfViews + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+
+	return 7;
+}
+
+//==============================================================================================//
+
+/*
+Raster stage: fine rasterization of the binned tiles, visibility and shading. The visibility stage is only written for the face and
+barycentric buffers and the shading only for the render buffer. Every kernel only takes the input, so the stage can be replayed from
+a launch graph. Returns the number of kernel launches.
+*/
+static int launchRasterStageGPU(const CUDABasedRasterizationInput& input, cudaStream_t stream)
+{
+	int numberOfTiles = input.numberOfViews * input.numberOfTilesU * input.numberOfTilesV;
+
+	//fine pass: one block per tile
+	rasterizeTilesDevice		<< <numberOfTiles, RASTERIZER_TILE_SIZE * RASTERIZER_TILE_SIZE, 0, stream >> > (input);
+
+	int numberOfLaunches = 1;
+
+	//deferred shading: visibility stage, then one shading thread per pixel
+	if (isOutputRequested(input, FaceOutput) || isOutputRequested(input, BarycentricOutput))
 	{
-		renderDepthBufferDevice << <(input.F*input.numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >(input);
+		resolveVisibilityDevice	<< <(input.w*input.h*input.numberOfViews + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+		numberOfLaunches++;
+	}
 
-		renderBuffersDevice << <(input.F*input.numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> > (input);
+	if (isOutputRequested(input, RenderBufferOutput))
+	{
+		shadePixelsDevice		<< <(input.w*input.h*input.numberOfViews + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+		numberOfLaunches++;
 	}
+
+	return numberOfLaunches;
+}
+
+//==============================================================================================//
+
+/*
+Binning followed by the raster stage, both have fixed shapes since the binning reads its size classes on the device, so they are
+captured into one launch graph. Returns the number of kernel launches.
+*/
+static int launchBinnedRasterStageGPU(const CUDABasedRasterizationInput& input, cudaStream_t stream)
+{
+	//coarse pass: bin the faces into screen tiles, first count the faces per tile, then write them into the scanned tile lists
+	int numberOfLaunches = binFacesGPU<true>(input, stream, NULL);
+
+	scanTileFacesDevice			<< <1, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (input);
+	numberOfLaunches++;
+
+	numberOfLaunches += binFacesGPU<false>(input, stream, NULL);
+
+	return numberOfLaunches + launchRasterStageGPU(input, stream);
+}
+
+//==============================================================================================//
+
+/*
+Launches a stage directly or, if launchGraph is not NULL, from its launch graph. The launch configurations of all stages only depend on the shape signature.
+*/
+static int launchStageGPU(CUDABasedRasterizationInput& input, LaunchGraph* launchGraph, int(*launchStage)(const CUDABasedRasterizationInput&, cudaStream_t))
+{
+	if (launchGraph == NULL)
+		return launchStage(input, input.stream);
+
+	std::vector<int> signature = { input.numberOfBatches, input.numberOfViews, input.N, input.F, input.w, input.h, input.texWidth, input.texHeight };
+
+	return launchGraphGPU(*launchGraph, signature, &input, sizeof(CUDABasedRasterizationInput), input.stream, [&](cudaStream_t stream) { return launchStage(input, stream); });
+}
+
+//==============================================================================================//
+
+/*
+Renders all views of all batch elements, every stage is launched once. Returns the number of kernel launches.
+All stages have fixed shapes, the grids of the binning are sized for the upper bound of faces and the kernels read the size classes
+on the device. The geometry stage and the binning together with the raster stage are replayed from launch graphs if enabled, when
+profiling the binning is launched directly between timing events. The binning and the raster stage are skipped if none of the raster
+outputs is requested.
+The host does not wait for the binning: the number of binned faces is copied back asynchronously, tiles that do not fit into the
+face lists are rasterized from the visible faces, and the lists are regrown in a later pass once the copy shows an overflow.
+*/
+extern "C" int renderBuffersGPU(CUDABasedRasterizationInput& input)
+{
+	int numberOfLaunches = launchStageGPU(input, input.geometryGraph, launchGeometryStageGPU);
+
+	if (isRasterizationRequested(input))
+	{
+		//regrow the face lists after an overflow in an earlier pass, cudaFree waits for the device, but only once per overflow
+		if (cudaEventQuery(input.binnedFacesEvent) == cudaSuccess && *input.h_numberOfBinnedFaces > input.tileFacesCapacity)
+		{
+			input.tileFacesCapacity = 2 * *input.h_numberOfBinnedFaces;
+			cutilSafeCall(cudaFree(input.d_tileFaces));
+			cutilSafeCall(cudaMalloc(&input.d_tileFaces, sizeof(int) * input.tileFacesCapacity));
+		}
+
+		//events of the counting and of the writing pass of the binning
+		cudaEvent_t binningEvents[2][NUMBER_OF_FACE_BUCKETS + 1];
+
+		if (!input.profile)
+		{
+			numberOfLaunches += launchStageGPU(input, input.rasterGraph, launchBinnedRasterStageGPU);
+		}
+		else
+		{
+			for (int pass = 0; pass < 2; pass++)
+			{
+				for (int e = 0; e < NUMBER_OF_FACE_BUCKETS + 1; e++)
+					cutilSafeCall(cudaEventCreate(&binningEvents[pass][e]));
+			}
+
+			numberOfLaunches += binFacesGPU<true>(input, input.stream, binningEvents[0]);
+
+			scanTileFacesDevice			<< <1, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, input.stream >> > (input);
+			numberOfLaunches++;
+
+			numberOfLaunches += binFacesGPU<false>(input, input.stream, binningEvents[1]);
+
+			numberOfLaunches += launchStageGPU(input, input.rasterGraph, launchRasterStageGPU);
+		}
+
+		int numberOfTiles = input.numberOfViews * input.numberOfTilesU * input.numberOfTilesV;
+		cutilSafeCall(cudaMemcpyAsync(input.h_numberOfBinnedFaces, input.d_tileFaceOffsets + numberOfTiles, sizeof(int), cudaMemcpyDeviceToHost, input.stream));
+		cutilSafeCall(cudaEventRecord(input.binnedFacesEvent, input.stream));
+
+		if (input.profile)
+		{
+			//the profiling waits for the binning anyway, so it reads the size classes afterwards
+			int bucketSizes[NUMBER_OF_FACE_BUCKETS];
+			cutilSafeCall(cudaMemcpyAsync(bucketSizes, input.d_faceBucketSizes, sizeof(int) * NUMBER_OF_FACE_BUCKETS, cudaMemcpyDeviceToHost, input.stream));
+			cutilSafeCall(cudaStreamSynchronize(input.stream));
+
+			float bucketTimes[NUMBER_OF_FACE_BUCKETS];
+			float binningTime = 0.f;
+			for (int bucket = 0; bucket < NUMBER_OF_FACE_BUCKETS; bucket++)
+			{
+				bucketTimes[bucket] = 0.f;
+				for (int pass = 0; pass < 2; pass++)
+				{
+					float passTime = 0.f;
+					cutilSafeCall(cudaEventElapsedTime(&passTime, binningEvents[pass][bucket], binningEvents[pass][bucket + 1]));
+					bucketTimes[bucket] += passTime;
+				}
+				binningTime += bucketTimes[bucket];
+			}
+
+			const char* bucketNames[NUMBER_OF_FACE_BUCKETS] = { "small", "medium", "large" };
+			std::cout << "Binning " << *input.h_numberOfBinnedFaces << " tile faces in " << binningTime << " ms:";
+			for (int bucket = 0; bucket < NUMBER_OF_FACE_BUCKETS; bucket++)
+			{
+				std::cout << " " << bucketNames[bucket] << " " << bucketSizes[bucket] << " faces " << bucketTimes[bucket] << " ms (" << (binningTime > 0.f ? 100.f * bucketTimes[bucket] / binningTime : 0.f) << "%)";
+			}
+			std::cout << std::endl;
+
+			for (int pass = 0; pass < 2; pass++)
+			{
+				for (int e = 0; e < NUMBER_OF_FACE_BUCKETS + 1; e++)
+					cutilSafeCall(cudaEventDestroy(binningEvents[pass][e]));
+			}
+		}
+	}
+
+	return numberOfLaunches;
 }
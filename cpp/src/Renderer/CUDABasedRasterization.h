@@ -6,6 +6,7 @@
 
 #include <set>
 #include "time.h"
+#include <memory>
 #include <iostream>
 #include "CUDABasedRasterizationInput.h"
 #include <vector>
@@ -14,10 +15,11 @@
 #include "cutil_inline_runtime.h"
 #include "cutil_math.h"
 #include "../Utils/cuda_SimpleMatrixUtil.h"
+#include "MeshTopology.h"
 
 //==============================================================================================//
 
-extern "C" void renderBuffersGPU(CUDABasedRasterizationInput& input);
+extern "C" int renderBuffersGPU(CUDABasedRasterizationInput& input);
 
 //==============================================================================================//
 
@@ -30,21 +32,40 @@ class CUDABasedRasterization
 		//=================================================//
 		//=================================================//
 
-		CUDABasedRasterization(std::vector<int>faces, 
-			std::vector<float>textureCoordinates, 
+		CUDABasedRasterization(const std::vector<int>& faces, 
+			const std::vector<float>& textureCoordinates, 
 			int numberOfVertices,
 			int numberOfCameras,
 			int frameResolutionU, 
 			int frameResolutionV, 
 			std::string albedoMode, 
 			std::string shadingMode,
-			bool computeNormal);
+			bool computeNormal,
+			bool reorderMesh,
+			bool twoSided,
+			bool triangleSetup,
+			std::string visibilityMode,
+			bool hierarchicalZ,
+			bool profile,
+			bool launchGraphs,
+			std::string vertexNormalLayout,
+			int outputs,
+			std::string renderBufferFormat,
+			std::string barycentricFormat,
+			std::string textureFormat,
+			std::string textureSampling,
+			const std::string& topologyCacheDirectory);
 
 		~CUDABasedRasterization();
 
-		void getVertexFaces(int numberOfVertices, std::vector<int> faces, std::vector<int> &vertexFaces, std::vector<int> &vertexFacesId);
 		void renderBuffers();
 
+		/*
+		All batch elements are rendered in one pass, camera c of batch element b is view b * numberOfCameras + c.
+		The per view and per batch element buffers grow with the number of batches.
+		*/
+		void setNumberOfBatches(int numberOfBatches);
+
 		//=================================================//
 		//=================================================//
 
@@ -59,7 +80,7 @@ class CUDABasedRasterization
 
 		//getter for texture
 		inline float*							get_D_textureCoordinates()					{ return input.d_textureCoordinates; };
-		inline const float*						get_D_textureMap()							{ return input.d_textureMap; };
+		inline const void*						get_D_textureMap()							{ return input.d_textureMap; };
 		inline int								getTextureWidth()							{ return input.texWidth; };
 		inline int								getTextureHeight()							{ return input.texHeight; };
 
@@ -69,9 +90,12 @@ class CUDABasedRasterization
 		//getter for misc
 		inline int4*							get_D_BBoxes()								{ return input.d_BBoxes; };
 		inline float3*							get_D_projectedVertices()					{ return input.d_projectedVertices; };
+		inline int								getNumberOfVertexNormalCopies()				{ return ::getNumberOfVertexNormalCopies(input); };
+		inline bool								isOutputRequested(RenderOutput output)		{ return ::isOutputRequested(input, output); };
 	
 		//getter for camera and frame
 		inline int								getNrCameras()								{ return input.numberOfCameras; };
+		inline int								getNumberOfBatches()						{ return input.numberOfBatches; };
 		inline float4*							get_D_cameraExtrinsics()					{ return input.d_cameraExtrinsics; };
 		inline float3*							get_D_cameraIntrinsics()					{ return input.d_cameraIntrinsics; };
 		inline int								getFrameWidth()								{ return input.w; };
@@ -80,8 +104,10 @@ class CUDABasedRasterization
 		//getter for render buffers
 		inline int*							    get_D_faceIDBuffer()						{ return input.d_faceIDBuffer; };
 		inline int*								get_D_depthBuffer()							{ return input.d_depthBuffer; };
-		inline float*							get_D_barycentricCoordinatesBuffer()		{ return input.d_barycentricCoordinatesBuffer; };
-		inline float*							get_D_renderBuffer()						{ return input.d_renderBuffer; };
+		inline void*							get_D_barycentricCoordinatesBuffer()		{ return input.d_barycentricCoordinatesBuffer; };
+		inline void*							get_D_renderBuffer()						{ return input.d_renderBuffer; };
+		inline int*								get_D_culledFaces()							{ return input.d_culledFaces; };
+		inline int*								get_D_hiZStatistics()						{ return input.d_hiZStatistics; };
 
 		//=================================================//
 		//=================================================//
@@ -89,14 +115,17 @@ class CUDABasedRasterization
 		//setter
 		inline void							set_D_vertices(float3* d_inputVertices)							{ input.d_vertices = d_inputVertices; };
 		inline void							set_D_vertexColors(float3* d_inputVertexColors)					{ input.d_vertexColor = d_inputVertexColors; };
-		inline void							set_D_textureMap(const float* newTextureMap)					{ input.d_textureMap = newTextureMap; };
+		inline void							set_D_textureMap(const void* newTextureMap)						{ input.d_textureMap = newTextureMap; };
+		inline void							setTextureChannels(int newTextureChannels)						{ input.textureChannels = newTextureChannels; };
 		inline void							setTextureWidth(int newTextureWidth)							{ input.texWidth = newTextureWidth; };
 		inline void							setTextureHeight(int newTextureHeight)							{ input.texHeight = newTextureHeight; };
 		inline void							set_D_shCoeff(const float* newSHCoeff)							{ input.d_shCoeff = newSHCoeff; };
 
 		inline void							set_D_faceIDBuffer(int* newFaceBuffer)							{ input.d_faceIDBuffer = newFaceBuffer; };
-		inline void							set_D_barycentricCoordinatesBuffer(float* newBarycentricBuffer) { input.d_barycentricCoordinatesBuffer = newBarycentricBuffer; };
-		inline void							set_D_renderBuffer(float* newRenderBuffer)						{ input.d_renderBuffer = newRenderBuffer; };
+		inline void							set_D_barycentricCoordinatesBuffer(void* newBarycentricBuffer)	{ input.d_barycentricCoordinatesBuffer = newBarycentricBuffer; };
+		inline void							set_D_renderBuffer(void* newRenderBuffer)						{ input.d_renderBuffer = newRenderBuffer; };
+		inline void							set_D_culledFaces(int* newCulledFaces)							{ input.d_culledFaces = newCulledFaces; };
+		inline void							set_D_hiZStatistics(int* newHiZStatistics)						{ input.d_hiZStatistics = newHiZStatistics; };
 
 		inline void							set_D_vertexNormal(float3* d_inputvertexNormal)					{ input.d_vertexNormal= d_inputvertexNormal; };
 		inline void							set_D_normalMap(float3* d_inputNormalMap)						{ input.d_normalMap = d_inputNormalMap; };
@@ -104,6 +133,11 @@ class CUDABasedRasterization
 		inline void							set_D_extrinsics(const float* d_inputExtrinsics)				{ input.d_cameraExtrinsics = (float4*)d_inputExtrinsics; };
 		inline void							set_D_intrinsics(const float* d_inputIntrinsics)				{ input.d_cameraIntrinsics = (float3*)d_inputIntrinsics; };
 
+		inline void							setStream(cudaStream_t newStream)								{ input.stream = newStream; };
+
+	private:
+
+		void freeBatchBuffers();
 
 	//variables
 
@@ -111,8 +145,26 @@ class CUDABasedRasterization
 
 		//device memory
 		CUDABasedRasterizationInput input;
-		bool textureMapFaceIdSet;
-		std::vector<float> texCoords;
+		std::shared_ptr<MeshTopology> topology;
+		CameraSetup cameraSetup;
+
+		//mip pyramid of the texture, only built for the trilinear sampling
+		TextureMipmap textureMipmap;
+
+		//replayable launch graphs of the fixed shape stages, only used if enabled
+		LaunchGraph geometryGraph;
+		LaunchGraph rasterGraph;
+
+		//vertex data in the reordered vertex ids, only allocated if the mesh is reordered
+		float3* d_reorderedVertices;
+		float3* d_reorderedVertexColor;
+		float3* d_reorderedVertexNormal;
+
+		//vertex normals of the shading and the normal map, only allocated if the vertex normal output is not requested
+		float3* d_internalVertexNormal;
+
+		//number of batch elements the per view and per batch element buffers are allocated for
+		int numberOfAllocatedBatches;
 };
 
 //==============================================================================================//
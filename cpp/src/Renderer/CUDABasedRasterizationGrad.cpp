@@ -5,8 +5,8 @@
 //==============================================================================================//
 
 CUDABasedRasterizationGrad::CUDABasedRasterizationGrad(
-	std::vector<int>faces, 
-	std::vector<float>textureCoordinates, 
+	const std::vector<int>& faces, 
+	const std::vector<float>& textureCoordinates, 
 	int numberOfVertices, 
 	int numberOfCameras,
 	int frameResolutionU, 
@@ -14,44 +14,36 @@ CUDABasedRasterizationGrad::CUDABasedRasterizationGrad(
 	std::string albedoMode, 
 	std::string shadingMode,
 	int imageFilterSize,
-	int textureFilterSize)
+	int textureFilterSize,
+	bool reorderMesh,
+	bool profile,
+	bool launchGraphs,
+	std::string renderBufferGradFormat,
+	std::string barycentricFormat,
+	std::string textureFormat,
+	std::string textureSampling,
+	const std::string& topologyCacheDirectory)
+	:
+	d_reorderedVertices(NULL),
+	d_reorderedVertexColor(NULL),
+	d_reorderedVertexNormal(NULL),
+	d_reorderedVertexPosGrad(NULL),
+	d_reorderedVertexColorGrad(NULL),
+	numberOfAllocatedBatches(0)
 {
-	//faces
-	if(faces.size() % 3 == 0)
-	{
-		input.F = (faces.size() / 3);
-		cutilSafeCall(cudaMalloc(&input.d_facesVertex, sizeof(int3) * input.F));
-		cutilSafeCall(cudaMemcpy(input.d_facesVertex, faces.data(), sizeof(int3)*input.F, cudaMemcpyHostToDevice));
-
-		// Get the vertexFaces, vertexFacesId
-		std::vector<int> vertexFaces, vertexFacesId;
-		getVertexFaces(numberOfVertices, faces, vertexFaces, vertexFacesId);
-		cutilSafeCall(cudaMalloc(&input.d_vertexFaces, sizeof(int) * vertexFaces.size()));
-		cutilSafeCall(cudaMemcpy(input.d_vertexFaces, vertexFaces.data(), sizeof(int)*vertexFaces.size(), cudaMemcpyHostToDevice));
-		cutilSafeCall(cudaMalloc(&input.d_vertexFacesId, sizeof(int) * vertexFacesId.size()));
-		cutilSafeCall(cudaMemcpy(input.d_vertexFacesId, vertexFacesId.data(), sizeof(int)*vertexFacesId.size(), cudaMemcpyHostToDevice));
-	}
-	else
-	{
-		std::cout << "No triangular faces!" << std::endl;
-	}
+	//shared topology
+	topology = MeshTopology::acquire(faces, textureCoordinates, numberOfVertices, reorderMesh, topologyCacheDirectory);
+
+	input.F						= topology->getNumberOfFaces();
+	input.d_facesVertex			= topology->get_D_facesVertex();
+	input.d_vertexFaces			= topology->get_D_vertexFaces();
+	input.d_vertexFacesId		= topology->get_D_vertexFacesId();
+	input.d_textureCoordinates	= topology->get_D_textureCoordinates();
+	input.d_reorderedFaceIds	= topology->get_D_reorderedFaceIds();
 
-	//texture coordinates
-	if (textureCoordinates.size() % 6 == 0)
-	{
-		cutilSafeCall(cudaMalloc(&input.d_textureCoordinates, sizeof(float) * 6 * input.F));
-		cutilSafeCall(cudaMemcpy(input.d_textureCoordinates, textureCoordinates.data(), sizeof(float)*input.F * 6, cudaMemcpyHostToDevice));
-	}
-	else
-	{
-		std::cout << "Texture coordinates have wrong dimensionality!" << std::endl;
-	}
-	
 	//camera parameters
 	
 	input.numberOfCameras = numberOfCameras;
-	cutilSafeCall(cudaMalloc(&input.d_inverseExtrinsics, sizeof(float4)*input.numberOfCameras * 4));
-	cutilSafeCall(cudaMalloc(&input.d_inverseProjection, sizeof(float4)*input.numberOfCameras * 4));
 
 	//albedo mode
 	if (albedoMode == "vertexColor")
@@ -84,56 +76,162 @@ CUDABasedRasterizationGrad::CUDABasedRasterizationGrad(
 	input.N = numberOfVertices;
 	input.imageFilterSize = imageFilterSize;
 	input.textureFilterSize = textureFilterSize;
+	input.profile = profile;
+
+	//storage formats of the reduced precision forward buffers, read without an upcast
+	input.renderBufferGradFormat	= getBufferFormat(renderBufferGradFormat);
+	input.barycentricFormat			= getBufferFormat(barycentricFormat);
+
+	//8 bit textures hold the image values in 1 / 255 steps, like the float textures loaded from images
+	input.textureFormat				= textureFormat == "uint8" ? BufferFormat::Unorm8Format : getBufferFormat(textureFormat);
+	input.textureChannels			= 3;
+
+	//texture sampling, the mip pyramid is built in every backward pass and its gradient gathered into the texture gradient
+	if (textureSampling == "nearest")
+	{
+		input.textureSampling = TextureSampling::Nearest;
+	}
+	else if (textureSampling == "trilinear")
+	{
+		input.textureSampling = TextureSampling::Trilinear;
+	}
+
+	createTextureMipmap(textureMipmap, true);
+	input.d_textureMipmap			= NULL;
+	input.d_textureMipmapGrad		= NULL;
+	input.textureMipmapLevels		= 1;
+	input.textureMipmapTexels		= 0;
+
+	//the backward pass is captured once per shape and replayed afterwards
+	createLaunchGraph(gradientGraph);
+	input.gradientGraph = launchGraphs ? &gradientGraph : NULL;
+
+	//the default stream until the op sets its own
+	input.stream = 0;
+	input.numberOfVertexNormalCopies = numberOfCameras;
+
+	//the per view and per batch element buffers, they grow with the batch size
+	setNumberOfBatches(1);
 }
 
 //==============================================================================================//
 
-void CUDABasedRasterizationGrad::getVertexFaces(int numberOfVertices, std::vector<int> faces, std::vector<int> &vertexFaces, std::vector<int> &vertexFacesId)
+CUDABasedRasterizationGrad::~CUDABasedRasterizationGrad()
 {
-	int vertexId;
-	int faceId;
-	int startId;
-	int numFacesPerVertex;
-	
-	for (int i = 0; i<numberOfVertices; i++) 
+	freeBatchBuffers();
+	destroyLaunchGraph(gradientGraph);
+	destroyTextureMipmap(textureMipmap);
+}
+
+//==============================================================================================//
+
+void CUDABasedRasterizationGrad::setNumberOfBatches(int numberOfBatches)
+{
+	input.numberOfBatches	= numberOfBatches;
+	input.numberOfViews		= numberOfBatches * input.numberOfCameras;
+
+	if (numberOfBatches <= numberOfAllocatedBatches)
+		return;
+
+	if (numberOfAllocatedBatches > 0)
+		freeBatchBuffers();
+
+	numberOfAllocatedBatches = numberOfBatches;
+
+	//cached camera setup, recomputed only for changed cameras
+	createCameraSetup(cameraSetup, input.numberOfViews, input.stream);
+	input.d_inverseExtrinsics	= cameraSetup.d_inverseExtrinsics;
+	input.d_inverseProjection	= cameraSetup.d_inverseProjection;
+	input.d_cameraCenters		= cameraSetup.d_cameraCenters;
+
+	//reordered mesh, room for the vertex normals in the per camera layout
+	if (topology->isReordered())
 	{
-		vertexId = i;
-		startId = vertexFaces.size();
-		
-		for (int j = 0; j<faces.size(); j += 3)
-		{
-			faceId = int(j / 3);
-			if (vertexId == faces[j] || vertexId == faces[j + 1] || vertexId == faces[j + 2])
-			{
-				vertexFaces.push_back(faceId);
-			}
-		}
-		numFacesPerVertex = vertexFaces.size() - startId;
-		if (numFacesPerVertex>0)
-		{
-			vertexFacesId.push_back(startId);
-			vertexFacesId.push_back(numFacesPerVertex);
-		}
-		else
-			std::cout << "WARNING:: --------- no faces for vertex " << vertexId << " --------- " << std::endl;
+		cutilSafeCall(cudaMalloc(&d_reorderedVertices,			sizeof(float3) * input.N * numberOfBatches));
+		cutilSafeCall(cudaMalloc(&d_reorderedVertexColor,		sizeof(float3) * input.N * numberOfBatches));
+		cutilSafeCall(cudaMalloc(&d_reorderedVertexNormal,		sizeof(float3) * input.N * input.numberOfViews));
+		cutilSafeCall(cudaMalloc(&d_reorderedVertexPosGrad,		sizeof(float3) * input.N * numberOfBatches));
+		cutilSafeCall(cudaMalloc(&d_reorderedVertexColorGrad,	sizeof(float3) * input.N * numberOfBatches));
 	}
 }
 
 //==============================================================================================//
 
-CUDABasedRasterizationGrad::~CUDABasedRasterizationGrad()
+void CUDABasedRasterizationGrad::freeBatchBuffers()
 {
-	cutilSafeCall(cudaFree(input.d_textureCoordinates));
-	cutilSafeCall(cudaFree(input.d_facesVertex));
-	cutilSafeCall(cudaFree(input.d_vertexFaces));
-	cutilSafeCall(cudaFree(input.d_vertexFacesId));
+	destroyCameraSetup(cameraSetup);
+	cutilSafeCall(cudaFree(d_reorderedVertices));
+	cutilSafeCall(cudaFree(d_reorderedVertexColor));
+	cutilSafeCall(cudaFree(d_reorderedVertexNormal));
+	cutilSafeCall(cudaFree(d_reorderedVertexPosGrad));
+	cutilSafeCall(cudaFree(d_reorderedVertexColorGrad));
 }
 
 //==============================================================================================//
 
 void CUDABasedRasterizationGrad::renderBuffersGrad()
 {
-	renderBuffersGradGPU(input);
+	int numberOfLaunches = updateCameraSetupGPU(cameraSetup, input.numberOfViews, input.d_cameraExtrinsics, input.d_cameraIntrinsics, input.stream);
+
+	//the same mip pyramid as in the forward pass, its gradient is zeroed with it
+	bool trilinear = input.albedoMode == AlbedoMode::Textured && input.textureSampling == TextureSampling::Trilinear;
+	if (trilinear)
+	{
+		numberOfLaunches += updateTextureMipmapGPU(textureMipmap, input.d_textureMap, input.textureFormat, input.textureChannels, input.texWidth, input.texHeight, input.numberOfBatches, input.stream);
+
+		input.d_textureMipmap		= textureMipmap.d_levels;
+		input.d_textureMipmapGrad	= textureMipmap.d_levelsGrad;
+		input.textureMipmapLevels	= textureMipmap.numberOfLevels;
+		input.textureMipmapTexels	= textureMipmap.numberOfTexels;
+	}
+
+	if (!topology->isReordered())
+	{
+		numberOfLaunches += renderBuffersGradGPU(input);
+	}
+	else
+	{
+		//the kernels work in the reordered vertex ids, the inputs and gradients of the operator stay in the original ids
+		float3* d_vertices			= input.d_vertices;
+		float3* d_vertexColor		= input.d_vertexColor;
+		float3* d_vertexNormal		= input.d_vertexNormal;
+		float3* d_vertexPosGrad		= input.d_vertexPosGrad;
+		float3* d_vertexColorGrad	= input.d_vertexColorGrad;
+
+		gatherReorderedVerticesGPU(d_vertices,		d_reorderedVertices,		topology->get_D_originalVertexIds(), input.N, input.numberOfBatches, input.stream);
+		gatherReorderedVerticesGPU(d_vertexColor,	d_reorderedVertexColor,		topology->get_D_originalVertexIds(), input.N, input.numberOfBatches, input.stream);
+		gatherReorderedVerticesGPU(d_vertexNormal,	d_reorderedVertexNormal,	topology->get_D_originalVertexIds(), input.N, input.numberOfBatches * input.numberOfVertexNormalCopies, input.stream);
+
+		input.d_vertices			= d_reorderedVertices;
+		input.d_vertexColor			= d_reorderedVertexColor;
+		input.d_vertexNormal		= d_reorderedVertexNormal;
+		input.d_vertexPosGrad		= d_reorderedVertexPosGrad;
+		input.d_vertexColorGrad		= d_reorderedVertexColorGrad;
+
+		numberOfLaunches += renderBuffersGradGPU(input);
+
+		scatterReorderedVerticesGPU(d_reorderedVertexPosGrad,	d_vertexPosGrad,	topology->get_D_originalVertexIds(), input.N, input.numberOfBatches, input.stream);
+		scatterReorderedVerticesGPU(d_reorderedVertexColorGrad, d_vertexColorGrad,	topology->get_D_originalVertexIds(), input.N, input.numberOfBatches, input.stream);
+
+		input.d_vertices			= d_vertices;
+		input.d_vertexColor			= d_vertexColor;
+		input.d_vertexNormal		= d_vertexNormal;
+		input.d_vertexPosGrad		= d_vertexPosGrad;
+		input.d_vertexColorGrad		= d_vertexColorGrad;
+
+		numberOfLaunches += 5;
+	}
+
+	//the gradient of the mip levels ends up in the base level, after the texture gradient of the pass is complete
+	if (trilinear && input.d_textureGrad != NULL)
+	{
+		numberOfLaunches += gatherTextureMipmapGradGPU(textureMipmap, input.d_textureGrad, input.textureChannels, input.numberOfBatches, input.stream);
+	}
+
+	if (input.profile)
+	{
+		std::cout << "Backward pass: " << numberOfLaunches << " kernel launches for " << input.numberOfBatches << " batch elements of " << input.numberOfCameras << " cameras" << std::endl;
+	}
 }
 
 //==============================================================================================//
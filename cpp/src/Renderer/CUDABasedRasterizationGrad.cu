@@ -2,74 +2,38 @@
 //==============================================================================================//
 
 #include <cuda_runtime.h> 
+#include <algorithm>
 #include "../Utils/cudaUtil.h"
 #include "../Utils/cuda_SimpleMatrixUtil.h"
 #include "../Utils/RendererUtil.h"
 #include "CUDABasedRasterizationGradInput.h"
 #include "../Utils/CameraUtil.h"
 #include "../Utils/IndexHelper.h"
+#include "LaunchGraph.h"
 
 //==============================================================================================//
 
 /*
-Initializes camera data
+Initialize all gradients of all batch elements in one pass: mesh pos and color, texture and lighting
 */
-__global__ void initializeCamerasGradDevice(CUDABasedRasterizationGradInput input)
+__global__ void initBuffersGradDevice(CUDABasedRasterizationGradInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < 1)
+	if (idx < input.numberOfBatches * input.N)
 	{
-		for (int idc = 0; idc < input.numberOfCameras; idc++)
-		{
-			float4x4 h_intrinsics;
-			float4x4 h_extrinsics;
-
-			h_extrinsics.setIdentity();
-			h_intrinsics.setIdentity();
-
-			for (int row = 0; row < 3; row++)
-			{
-				h_intrinsics(row, 0) = input.d_cameraIntrinsics[3 * idc + row].x;
-				h_intrinsics(row, 1) = input.d_cameraIntrinsics[3 * idc + row].y;
-				h_intrinsics(row, 2) = input.d_cameraIntrinsics[3 * idc + row].z;
-				h_intrinsics(row, 3) = 0.f;
-
-				h_extrinsics(row, 0) = input.d_cameraExtrinsics[3 * idc + row].x;
-				h_extrinsics(row, 1) = input.d_cameraExtrinsics[3 * idc + row].y;
-				h_extrinsics(row, 2) = input.d_cameraExtrinsics[3 * idc + row].z;
-				h_extrinsics(row, 3) = input.d_cameraExtrinsics[3 * idc + row].w;
-			}
-
-			float4x4 h_inExtrinsics = h_extrinsics.getInverse();
-			float4x4 h_invProjection = (h_intrinsics * h_extrinsics).getInverse();
-
-			for (int row = 0; row < 4; row++)
-			{
-				input.d_inverseExtrinsics[4 * idc + row].x = h_inExtrinsics(row, 0);
-				input.d_inverseExtrinsics[4 * idc + row].y = h_inExtrinsics(row, 1);
-				input.d_inverseExtrinsics[4 * idc + row].z = h_inExtrinsics(row, 2);
-				input.d_inverseExtrinsics[4 * idc + row].w = h_inExtrinsics(row, 3);
-
-				input.d_inverseProjection[4 * idc + row].x = h_invProjection(row, 0);
-				input.d_inverseProjection[4 * idc + row].y = h_invProjection(row, 1);
-				input.d_inverseProjection[4 * idc + row].z = h_invProjection(row, 2);
-				input.d_inverseProjection[4 * idc + row].w = h_invProjection(row, 3);
-			}
-		}
+		input.d_vertexPosGrad[idx]	 = make_float3(0.f, 0.f, 0.f);
+		input.d_vertexColorGrad[idx] = make_float3(0.f, 0.f, 0.f);
 	}
-}
 
-//==============================================================================================//
-
-/*
-Initialize gradients for lighting 
-*/
-__global__ void initBuffersGradDevice2(CUDABasedRasterizationGradInput input)
-{
-	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+	//no texture gradient for 8 bit textures
+	if (idx < input.numberOfBatches * input.texHeight * input.texWidth && input.d_textureGrad != NULL)
+	{
+		for (int channel = 0; channel < input.textureChannels; channel++)
+			input.d_textureGrad[input.textureChannels * idx + channel] = 0.f;
+	}
 
-	if (idx < input.numberOfCameras * 27)
+	if (idx < input.numberOfViews * 27)
 	{
 		input.d_shCoeffGrad[idx] = 0.f;
 	}
@@ -78,44 +42,38 @@ __global__ void initBuffersGradDevice2(CUDABasedRasterizationGradInput input)
 //==============================================================================================//
 
 /*
-Initialize gradients for texture
+Adds the gradient of a sampled color to a tap of a trilinear sample, the base level goes to the texture gradient (textureGrad,
+channels per texel) and the levels above it to the gradient of the levels (levelsGrad)
 */
-__global__ void initBuffersGradDevice1(CUDABasedRasterizationGradInput input)
+__inline__ __device__ void addMipmapTapGradient(const MipmapTap& tap, float3 grad, float* textureGrad, int channels, float4* levelsGrad)
 {
-	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+	if (tap.weight == 0.f)
+		return;
 
-	if (idx < input.texHeight * input.texWidth)
+	if (tap.level == 0)
 	{
-		input.d_textureGrad[idx] = make_float3(0.f,0.f,0.f);
+		atomicAdd(&textureGrad[channels * tap.texel + 0], tap.weight * grad.x);
+		atomicAdd(&textureGrad[channels * tap.texel + 1], tap.weight * grad.y);
+		atomicAdd(&textureGrad[channels * tap.texel + 2], tap.weight * grad.z);
 	}
-}
-
-//==============================================================================================//
-
-/*
-Initialize gradients for mesh pos and color
-*/
-__global__ void initBuffersGradDevice0(CUDABasedRasterizationGradInput input)
-{
-	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
-
-	if (idx < input.N)
+	else
 	{
-		input.d_vertexPosGrad[idx]	 = make_float3(0.f, 0.f, 0.f);
-		input.d_vertexColorGrad[idx] = make_float3(0.f, 0.f, 0.f);
+		atomicAdd(&levelsGrad[tap.texel].x, tap.weight * grad.x);
+		atomicAdd(&levelsGrad[tap.texel].y, tap.weight * grad.y);
+		atomicAdd(&levelsGrad[tap.texel].z, tap.weight * grad.z);
 	}
 }
 
 //==============================================================================================//
 
 /*
-Get gradients for vertex color buffer
+Get gradients for vertex color buffer, one thread per pixel of every view
 */
 __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 {
 	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-	if (idx < input.numberOfCameras * input.w * input.h)
+	if (idx < input.numberOfViews * input.w * input.h)
 	{
 		////////////////////////////////////////////////////////////////////////
 		////////////////////////////////////////////////////////////////////////
@@ -123,12 +81,26 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		////////////////////////////////////////////////////////////////////////
 		////////////////////////////////////////////////////////////////////////
 
-		int3 index = index1DTo3D(input.numberOfCameras, input.h, input.w, idx);
+		int3 index = index1DTo3D(input.numberOfViews, input.h, input.w, idx);
 		int idc = index.x;
 		int idh = index.y;
 		int idw = index.z;
 		int idf = input.d_faceIDBuffer[idx];
 
+		//mesh, texture and their gradients of the batch element of the view
+		int idb = idc / input.numberOfCameras;
+		const float3* vertices		= input.d_vertices + idb * input.N;
+		const float3* vertexColor	= input.d_vertexColor + idb * input.N;
+		const float3* vertexNormal	= input.d_vertexNormal + idb * input.numberOfVertexNormalCopies * input.N;
+		int textureOffset			= idb * input.texHeight * input.texWidth;
+		float3* vertexPosGrad		= input.d_vertexPosGrad + idb * input.N;
+		float3* vertexColorGrad		= input.d_vertexColorGrad + idb * input.N;
+		float* textureGrad			= input.d_textureGrad + textureOffset * input.textureChannels;
+
+		//the face buffer holds the original face ids
+		if (idf >= 0 && input.d_reorderedFaceIds != NULL)
+			idf = input.d_reorderedFaceIds[idf];
+
 		//int T = 20;
 
 		bool outsideModel = false;
@@ -202,26 +174,35 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		////////////////////////////////////////////////////////////////////////
 		////////////////////////////////////////////////////////////////////////
 
-		float3 o = make_float3(0.f, 0.f, 0.f);
-		float3 d = make_float3(0.f, 0.f, 0.f);
-		float2 pixelPos = make_float2(idw + 0.5f, idh + 0.5f);
-		getRayCuda2(pixelPos, o, d, input.d_inverseExtrinsics + idc * 4, input.d_inverseProjection + idc * 4);
+		float3 o = input.d_cameraCenters[idc];
+		float3 d = getPixelRayDirection(input.d_inverseProjection + 4 * idc, o, idw, idh);
 
-		float2 bccTmp	= input.d_barycentricCoordinatesBuffer[idx];
+		float2 bccTmp	= make_float2(loadBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 0, input.barycentricFormat), loadBufferValue(input.d_barycentricCoordinatesBuffer, 2 * idx + 1, input.barycentricFormat));
 		float3 bcc		= make_float3(bccTmp.x, bccTmp.y, 1.f - bccTmp.x - bccTmp.y);
 
+		//no render buffer gradient if the render output was not requested
+		float3 renderBufferGrad = make_float3(0.f, 0.f, 0.f);
+
+		if (input.d_renderBufferGrad != NULL)
+		{
+			renderBufferGrad = make_float3(
+				loadBufferValue(input.d_renderBufferGrad, 3 * idx + 0, input.renderBufferGradFormat),
+				loadBufferValue(input.d_renderBufferGrad, 3 * idx + 1, input.renderBufferGradFormat),
+				loadBufferValue(input.d_renderBufferGrad, 3 * idx + 2, input.renderBufferGradFormat));
+		}
+
 		int3   faceVerticesIds  = input.d_facesVertex[idf];
 		const float* shCoeff	= input.d_shCoeff + idc * 27;
 
-		float3 vertexPos0 = input.d_vertices[faceVerticesIds.x];
-		float3 vertexPos1 = input.d_vertices[faceVerticesIds.y];
-		float3 vertexPos2 = input.d_vertices[faceVerticesIds.z];
-		float3 vertexCol0 = input.d_vertexColor[faceVerticesIds.x];
-		float3 vertexCol1 = input.d_vertexColor[faceVerticesIds.y];
-		float3 vertexCol2 = input.d_vertexColor[faceVerticesIds.z];
-		float3 vertexNor0 = input.d_vertexNormal[idc*input.N + faceVerticesIds.x];
-		float3 vertexNor1 = input.d_vertexNormal[idc*input.N + faceVerticesIds.y];
-		float3 vertexNor2 = input.d_vertexNormal[idc*input.N + faceVerticesIds.z];
+		float3 vertexPos0 = vertices[faceVerticesIds.x];
+		float3 vertexPos1 = vertices[faceVerticesIds.y];
+		float3 vertexPos2 = vertices[faceVerticesIds.z];
+		float3 vertexCol0 = vertexColor[faceVerticesIds.x];
+		float3 vertexCol1 = vertexColor[faceVerticesIds.y];
+		float3 vertexCol2 = vertexColor[faceVerticesIds.z];
+		float3 vertexNor0 = vertexNormal[faceVerticesIds.x];
+		float3 vertexNor1 = vertexNormal[faceVerticesIds.y];
+		float3 vertexNor2 = vertexNormal[faceVerticesIds.z];
 		float2 texCoord0  = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 0 * 2 + 1]);
 		float2 texCoord1  = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 1 * 2 + 1]);
 		float2 texCoord2  = make_float2(input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 0], 1.f - input.d_textureCoordinates[idf * 3 * 2 + 2 * 2 + 1]);
@@ -248,11 +229,21 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		}
 
 		float2 finalTexCoord = make_float2(0.f, 0.f);
+		MipmapTap taps[TRILINEAR_TAPS];
 		if (input.albedoMode == AlbedoMode::Textured)
 		{
 			finalTexCoord = texCoord0* bcc.x + texCoord1* bcc.y + texCoord2* bcc.z;
 			finalTexCoord.x = finalTexCoord.x * input.texWidth;
 			finalTexCoord.y = finalTexCoord.y * input.texHeight;
+
+			//the taps of the forward pass, from the unclamped texture coordinates
+			if (input.textureSampling == TextureSampling::Trilinear)
+			{
+				float2 textureSize = make_float2(input.texWidth, input.texHeight);
+				float lod = getTextureLOD(o, input.d_inverseProjection + 4 * idc, idw, idh, input.w, input.h, vertexPos0, vertexPos1, vertexPos2, texCoord0 * textureSize, texCoord1 * textureSize, texCoord2 * textureSize);
+				getTrilinearTaps(finalTexCoord, lod, input.texWidth, input.texHeight, input.textureMipmapLevels, taps);
+			}
+
 			finalTexCoord.x = fmaxf(finalTexCoord.x, 0);
 			finalTexCoord.x = fminf(finalTexCoord.x, input.texWidth - 1);
 			finalTexCoord.y = fmaxf(finalTexCoord.y, 0);
@@ -277,6 +268,10 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		{
 			pixAlb = bcc.x * vertexCol0 + bcc.y * vertexCol1 + bcc.z * vertexCol2;
 		}
+		else if (input.albedoMode == AlbedoMode::Textured && input.textureSampling == TextureSampling::Trilinear)
+		{
+			pixAlb = sampleMipmapTaps(taps, input.d_textureMap, textureOffset, input.textureChannels, input.textureFormat, input.d_textureMipmap, idb * input.textureMipmapTexels);
+		}
 		else if (input.albedoMode == AlbedoMode::Textured)
 		{
 			float U0 = finalTexCoord.x;
@@ -288,25 +283,13 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 			float  LV = int(finalTexCoord.y - 0.5f) + 0.5f;
 			float  HV = int(finalTexCoord.y - 0.5f) + 1.5f;
 
-			float3 colorLULV = make_float3(
-				input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)LU + 0],
-				input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)LU + 1],
-				input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)LU + 2]);
+			float3 colorLULV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)LV + (int)LU, input.textureChannels, input.textureFormat);
 
-			float3 colorLUHV = make_float3(
-				input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)LU + 0],
-				input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)LU + 1],
-				input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)LU + 2]);
+			float3 colorLUHV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)HV + (int)LU, input.textureChannels, input.textureFormat);
 
-			float3 colorHULV = make_float3(
-				input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)HU + 0],
-				input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)HU + 1],
-				input.d_textureMap[3 * input.texWidth *(int)LV + 3 * (int)HU + 2]);
+			float3 colorHULV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)LV + (int)HU, input.textureChannels, input.textureFormat);
 
-			float3 colorHUHV = make_float3(
-				input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)HU + 0],
-				input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)HU + 1],
-				input.d_textureMap[3 * input.texWidth *(int)HV + 3 * (int)HU + 2]);
+			float3 colorHUHV = loadBufferColor(input.d_textureMap, textureOffset + input.texWidth * (int)HV + (int)HU, input.textureChannels, input.textureFormat);
 
 			pixAlb = (V0 - LV) * (((U0 - LU) * colorLULV) + ((HU - U0) * colorHULV)) +
 				(HV - V0) * (((U0 - LU) * colorLUHV) + ((HU - U0) * colorHUHV));
@@ -327,9 +310,9 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		if (!outsideModel)
 		{
 			mat1x3 GVCBVertexColor;
-			GVCBVertexColor(0, 0) = input.d_renderBufferGrad[idx].x;
-			GVCBVertexColor(0, 1) = input.d_renderBufferGrad[idx].y;
-			GVCBVertexColor(0, 2) = input.d_renderBufferGrad[idx].z;
+			GVCBVertexColor(0, 0) = renderBufferGrad.x;
+			GVCBVertexColor(0, 1) = renderBufferGrad.y;
+			GVCBVertexColor(0, 2) = renderBufferGrad.z;
 
 			if (input.albedoMode == AlbedoMode::VertexColor)
 			{
@@ -338,11 +321,22 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 
 				mat1x9 gradVerCol = GVCBVertexColor * JCoAl * JAlVc;
 
-				addGradients9I(gradVerCol.getTranspose(), input.d_vertexColorGrad, faceVerticesIds);
+				addGradients9I(gradVerCol.getTranspose(), vertexColorGrad, faceVerticesIds);
 			}
 			else if (input.albedoMode == AlbedoMode::Textured)
 			{
-				if (!flippedNormal)
+				//accumulated in float for every texture format, in the channel layout of the texture
+				if (!flippedNormal && input.d_textureGrad != NULL && input.textureSampling == TextureSampling::Trilinear)
+				{
+					mat1x3 gradTexColor = GVCBVertexColor * JCoAl;
+
+					//the mip levels are gathered into the base level after the pass
+					for (int t = 0; t < TRILINEAR_TAPS; t++)
+					{
+						addMipmapTapGradient(taps[t], make_float3(gradTexColor(0, 0), gradTexColor(0, 1), gradTexColor(0, 2)), textureGrad, input.textureChannels, input.d_textureMipmapGrad + idb * input.textureMipmapTexels);
+					}
+				}
+				else if (!flippedNormal && input.d_textureGrad != NULL)
 				{
 					mat1x3 gradTexColor = GVCBVertexColor * JCoAl;
 
@@ -358,30 +352,30 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 					float weighting = 1.f;// fabs(dot(pixNorm, d));
 
 					float weightLULV = (V0 - LV) * (U0 - LU);
-					/*atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].x, weighting * gradTexColor(0, 0) * weightLULV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].y, weighting * gradTexColor(0, 1) * weightLULV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].z, weighting * gradTexColor(0, 2) * weightLULV);
+					/*atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].x, weighting * gradTexColor(0, 0) * weightLULV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].y, weighting * gradTexColor(0, 1) * weightLULV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].z, weighting * gradTexColor(0, 2) * weightLULV);
 
 					float weightLUHV = (HV - V0) * (U0 - LU);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, LU)].x, weighting * gradTexColor(0, 0) * weightLUHV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, LU)].y, weighting * gradTexColor(0, 1) * weightLUHV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, LU)].z, weighting * gradTexColor(0, 2) * weightLUHV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, LU)].x, weighting * gradTexColor(0, 0) * weightLUHV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, LU)].y, weighting * gradTexColor(0, 1) * weightLUHV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, LU)].z, weighting * gradTexColor(0, 2) * weightLUHV);
 
 					float weightHULV = (V0 - LV) * (HU - U0);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, HU)].x, weighting * gradTexColor(0, 0) * weightHULV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, HU)].y, weighting * gradTexColor(0, 1) * weightHULV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, HU)].z, weighting * gradTexColor(0, 2) * weightHULV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, HU)].x, weighting * gradTexColor(0, 0) * weightHULV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, HU)].y, weighting * gradTexColor(0, 1) * weightHULV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, HU)].z, weighting * gradTexColor(0, 2) * weightHULV);
 
 					float weightHUHV = (HV - V0) * (HU - U0);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, HU)].x, weighting * gradTexColor(0, 0) * weightHUHV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, HU)].y, weighting * gradTexColor(0, 1) * weightHUHV);
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, HU)].z, weighting * gradTexColor(0, 2) * weightHUHV);*/
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, HU)].x, weighting * gradTexColor(0, 0) * weightHUHV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, HU)].y, weighting * gradTexColor(0, 1) * weightHUHV);
+					atomicAdd(&textureGrad[index2DTo1D(input.texHeight, input.texWidth, HV, HU)].z, weighting * gradTexColor(0, 2) * weightHUHV);*/
 
 					//printf("%f", weightLULV + weightLUHV + weightHULV + weightHUHV);
 
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].x,  gradTexColor(0, 0) );
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].y,  gradTexColor(0, 1) );
-					atomicAdd(&input.d_textureGrad[index2DTo1D(input.texHeight, input.texWidth, LV, LU)].z,  gradTexColor(0, 2) );
+					atomicAdd(&textureGrad[input.textureChannels * index2DTo1D(input.texHeight, input.texWidth, LV, LU) + 0],  gradTexColor(0, 0) );
+					atomicAdd(&textureGrad[input.textureChannels * index2DTo1D(input.texHeight, input.texWidth, LV, LU) + 1],  gradTexColor(0, 1) );
+					atomicAdd(&textureGrad[input.textureChannels * index2DTo1D(input.texHeight, input.texWidth, LV, LU) + 2],  gradTexColor(0, 2) );
 				}
 			}
 			else if (input.albedoMode == AlbedoMode::ForegroundMask)
@@ -402,9 +396,9 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		if (!outsideModel)
 		{
 			mat1x3 GVCBLight;
-			GVCBLight(0, 0) = input.d_renderBufferGrad[idx].x;
-			GVCBLight(0, 1) = input.d_renderBufferGrad[idx].y;
-			GVCBLight(0, 2) = input.d_renderBufferGrad[idx].z;
+			GVCBLight(0, 0) = renderBufferGrad.x;
+			GVCBLight(0, 1) = renderBufferGrad.y;
+			GVCBLight(0, 2) = renderBufferGrad.z;
 
 			mat3x9 JLiGmR;
 			getJLiGm(JLiGmR, 0, pixNorm);
@@ -442,14 +436,9 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		////////////////////////////////////////////////////////////////////////
 
 		mat1x3 GVCBPosition;
-		GVCBPosition(0, 0) = input.d_renderBufferGrad[idx].x;
-		GVCBPosition(0, 1) = input.d_renderBufferGrad[idx].y;
-		GVCBPosition(0, 2) = input.d_renderBufferGrad[idx].z;
-
-		mat1x3 GVCBPositionTarget;
-		GVCBPositionTarget(0, 0) = input.d_targetBufferGrad[idx].x;
-		GVCBPositionTarget(0, 1) = input.d_targetBufferGrad[idx].y;
-		GVCBPositionTarget(0, 2) = input.d_targetBufferGrad[idx].z;
+		GVCBPosition(0, 0) = renderBufferGrad.x;
+		GVCBPosition(0, 1) = renderBufferGrad.y;
+		GVCBPosition(0, 2) = renderBufferGrad.z;
 
 		////////////////////////////////////////////////////////////////////////
 		//data to model
@@ -468,7 +457,7 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 		}
 		else if (input.albedoMode == AlbedoMode::Textured)
 		{
-			getJAlTexBc(JAlBc, input.d_textureMap, finalTexCoord, texCoord0, texCoord1, texCoord2, input.texWidth, input.texHeight, input.textureFilterSize);
+			getJAlTexBc(JAlBc, textureMap, finalTexCoord, texCoord0, texCoord1, texCoord2, input.texWidth, input.texHeight, input.textureFilterSize);
 		}
 		else if (input.albedoMode == AlbedoMode::ForegroundMask)
 		{
@@ -522,37 +511,46 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 			gradVerPos = gradVerPos + GVCBPosition * JCoLi * JLiNo * JNoNu * JNoBc * JBcVp;
 		}
 
-		addGradients9I(gradVerPos.getTranspose(), input.d_vertexPosGrad, faceVerticesIds);
+		addGradients9I(gradVerPos.getTranspose(), vertexPosGrad, faceVerticesIds);
 
 		////////////////////////////////////////////////////////////////////////
 		//model to data
 		////////////////////////////////////////////////////////////////////////
 
-		// dT 3x2
-		mat3x2 dT = imageGradient(((float3*)input.d_targetImage ) + idc * input.w * input.h , make_float2(idw, idh),input.w, input.h, input.imageFilterSize);
-		 
-		//dProj 2x3
-		mat2x3 dProj;
-		getJProjection(dProj, fragmentPosition, input.d_cameraIntrinsics + 3 * idc, input.d_cameraExtrinsics + 3 * idc);
-
-		//dFrag 
-		mat3x9 dFrag;
-		dFrag.setZero();
-		dFrag(0, 0) = bcc.x;
-		dFrag(1, 1) = bcc.x;
-		dFrag(2, 2) = bcc.x;
-
-		dFrag(0, 3) = bcc.y;
-		dFrag(1, 4) = bcc.y;
-		dFrag(2, 5) = bcc.y;
-
-		dFrag(0, 6) = bcc.z;
-		dFrag(1, 7) = bcc.z;
-		dFrag(2, 8) = bcc.z;
-
-		mat1x9 model2DataGrad = GVCBPositionTarget * dT * dProj * dFrag ;
-
-		addGradients9I(model2DataGrad.getTranspose(), input.d_vertexPosGrad, faceVerticesIds);
+		//no target gradient if the target output was not requested
+		if (input.d_targetBufferGrad != NULL)
+		{
+			mat1x3 GVCBPositionTarget;
+			GVCBPositionTarget(0, 0) = input.d_targetBufferGrad[idx].x;
+			GVCBPositionTarget(0, 1) = input.d_targetBufferGrad[idx].y;
+			GVCBPositionTarget(0, 2) = input.d_targetBufferGrad[idx].z;
+
+			// dT 3x2
+			mat3x2 dT = imageGradient(((float3*)input.d_targetImage ) + idc * input.w * input.h , make_float2(idw, idh),input.w, input.h, input.imageFilterSize);
+			 
+			//dProj 2x3
+			mat2x3 dProj;
+			getJProjection(dProj, fragmentPosition, input.d_cameraIntrinsics + 3 * idc, input.d_cameraExtrinsics + 3 * idc);
+
+			//dFrag 
+			mat3x9 dFrag;
+			dFrag.setZero();
+			dFrag(0, 0) = bcc.x;
+			dFrag(1, 1) = bcc.x;
+			dFrag(2, 2) = bcc.x;
+
+			dFrag(0, 3) = bcc.y;
+			dFrag(1, 4) = bcc.y;
+			dFrag(2, 5) = bcc.y;
+
+			dFrag(0, 6) = bcc.z;
+			dFrag(1, 7) = bcc.z;
+			dFrag(2, 8) = bcc.z;
+
+			mat1x9 model2DataGrad = GVCBPositionTarget * dT * dProj * dFrag ;
+
+			addGradients9I(model2DataGrad.getTranspose(), vertexPosGrad, faceVerticesIds);
+		}
 
 		//////////////////////////////////////////////////////////////////////////////////
 
@@ -590,26 +588,26 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 					int faceId = input.d_vertexFaces[j];
 
 					int3 v_index_inner = input.d_facesVertex[faceId];
-					mat3x1 vi = (mat3x1)input.d_vertices[v_index_inner.x];
-					mat3x1 vj = (mat3x1)input.d_vertices[v_index_inner.y];
-					mat3x1 vk = (mat3x1)input.d_vertices[v_index_inner.z];
+					mat3x1 vi = (mat3x1)vertices[v_index_inner.x];
+					mat3x1 vj = (mat3x1)vertices[v_index_inner.y];
+					mat3x1 vk = (mat3x1)vertices[v_index_inner.z];
 
 					mat3x3 J;
 
 					// gradients vi
 					getJ_vi(J, vk, vj, vi);
 					mat1x3 gradVi = GVCBPosition * JCoLi * JLiNo * JNoNu * JNuNvx * J;
-					addGradients(gradVi, &input.d_vertexPosGrad[v_index_inner.x]);
+					addGradients(gradVi, &vertexPosGrad[v_index_inner.x]);
 
 					// gradients vj
 					getJ_vj(J, vk, vi);
 					mat1x3 gradVj = GVCBPosition * JCoLi * JLiNo * JNoNu * JNuNvx * J;
-					addGradients(gradVj, &input.d_vertexPosGrad[v_index_inner.y]);
+					addGradients(gradVj, &vertexPosGrad[v_index_inner.y]);
 
 					// gradients vk
 					getJ_vk(J, vj, vi);
 					mat1x3 gradVk = GVCBPosition * JCoLi * JLiNo * JNoNu * JNuNvx * J;
-					addGradients(gradVk, &input.d_vertexPosGrad[v_index_inner.z]);
+					addGradients(gradVk, &vertexPosGrad[v_index_inner.z]);
 				}
 			}
 		}
@@ -619,19 +617,33 @@ __global__ void renderBuffersGradDevice(CUDABasedRasterizationGradInput input)
 //==============================================================================================//
 
 /*
-Call to the devices for computing the gradients
+Zeroes all gradients and computes them, both kernels only take the input, so the pass can be replayed from a launch graph
 */
-extern "C" void renderBuffersGradGPU(CUDABasedRasterizationGradInput& input)
+static int launchGradientsGPU(const CUDABasedRasterizationGradInput& input, cudaStream_t stream)
 {
-	initializeCamerasGradDevice << < 1, 1 >> > (input);
+	int numberOfInitThreads = std::max(input.numberOfBatches * std::max(input.N, input.texHeight * input.texWidth), input.numberOfViews * 27);
 
-	initBuffersGradDevice2    << < (input.numberOfCameras * 27 + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >				(input);
+	initBuffersGradDevice     << < (numberOfInitThreads + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> >						(input);
 
-	initBuffersGradDevice1    << < (input.texHeight * input.texWidth + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >		(input);
+	renderBuffersGradDevice   << < (input.numberOfViews*input.w*input.h + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> >	(input);
+
+	return 2;
+}
+
+//==============================================================================================//
+
+/*
+Call to the devices for computing the gradients of all views of all batch elements, returns the number of kernel launches.
+The launch configurations only depend on the shape signature, so the pass is replayed from its launch graph if enabled.
+*/
+extern "C" int renderBuffersGradGPU(CUDABasedRasterizationGradInput& input)
+{
+	if (input.gradientGraph == NULL)
+		return launchGradientsGPU(input, input.stream);
 
-	initBuffersGradDevice0    << < (input.N + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >								(input);
+	std::vector<int> signature = { input.numberOfBatches, input.numberOfViews, input.N, input.w, input.h, input.texWidth, input.texHeight };
 
-	renderBuffersGradDevice   << < (input.numberOfCameras*input.w*input.h + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER >> >	(input);
+	return launchGraphGPU(*input.gradientGraph, signature, &input, sizeof(CUDABasedRasterizationGradInput), input.stream, [&](cudaStream_t stream) { return launchGradientsGPU(input, stream); });
 }
 
 //==============================================================================================//
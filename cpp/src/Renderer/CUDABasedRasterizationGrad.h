@@ -6,6 +6,7 @@
 
 #include <set>
 #include "time.h"
+#include <memory>
 #include <iostream>
 #include "CUDABasedRasterizationGradInput.h"
 #include <vector>
@@ -14,10 +15,11 @@
 #include "cutil_inline_runtime.h"
 #include "cutil_math.h"
 #include "../Utils/cuda_SimpleMatrixUtil.h"
+#include "MeshTopology.h"
 
 //==============================================================================================//
 
-extern "C" void renderBuffersGradGPU(CUDABasedRasterizationGradInput& input);
+extern "C" int renderBuffersGradGPU(CUDABasedRasterizationGradInput& input);
 
 //==============================================================================================//
 
@@ -30,8 +32,8 @@ class CUDABasedRasterizationGrad
 		//=================================================//
 		//=================================================//
 
-		CUDABasedRasterizationGrad( std::vector<int>faces, 
-									std::vector<float>textureCoordinates, 
+		CUDABasedRasterizationGrad( const std::vector<int>& faces, 
+									const std::vector<float>& textureCoordinates, 
 									int numberOfVertices, 
 									int numberOfCameras,
 									int frameResolutionU,		
@@ -39,12 +41,25 @@ class CUDABasedRasterizationGrad
 									std::string albedoMode, 
 									std::string shadingMode, 
 									int imageFilterSize,
-									int textureFilterSize);
+									int textureFilterSize,
+									bool reorderMesh,
+									bool profile,
+									bool launchGraphs,
+									std::string renderBufferGradFormat,
+									std::string barycentricFormat,
+									std::string textureFormat,
+									std::string textureSampling,
+									const std::string& topologyCacheDirectory);
 		~CUDABasedRasterizationGrad();
 
-		void getVertexFaces(int numberOfVertices, std::vector<int> faces, std::vector<int> &vertexFaces, std::vector<int> &vertexFacesId);
 		void renderBuffersGrad();
 
+		/*
+		All batch elements are differentiated in one pass, camera c of batch element b is view b * numberOfCameras + c.
+		The per view and per batch element buffers grow with the number of batches.
+		*/
+		void setNumberOfBatches(int numberOfBatches);
+
 		//=================================================//
 		//=================================================//
 
@@ -59,7 +74,7 @@ class CUDABasedRasterizationGrad
 
 		//getter for texture
 		inline float*							get_D_textureCoordinates()					{ return input.d_textureCoordinates; };
-		inline const float*						get_D_textureMap()							{ return input.d_textureMap; };
+		inline const void*						get_D_textureMap()							{ return input.d_textureMap; };
 		inline int								getTextureWidth()							{ return input.texWidth; };
 		inline int								getTextureHeight()							{ return input.texHeight; };
 
@@ -70,39 +85,47 @@ class CUDABasedRasterizationGrad
 	
 		//getter for camera and frame
 		inline int								getNrCameras()								{ return input.numberOfCameras; };
+		inline int								getNumberOfBatches()						{ return input.numberOfBatches; };
 		inline int								getFrameWidth()								{ return input.w; };
 		inline int								getFrameHeight()							{ return input.h; };
 	
 		//getter for render buffers
 		inline int*								get_D_faceIDBuffer()						{ return input.d_faceIDBuffer; };
-		inline float2*							get_D_barycentricCoordinatesBuffer()		{ return input.d_barycentricCoordinatesBuffer; };
+		inline const void*						get_D_barycentricCoordinatesBuffer()		{ return input.d_barycentricCoordinatesBuffer; };
 
 		//=================================================//
 		//=================================================//
 
 		//setter
-		inline void							set_D_RenderBufferGrad(float3* d_inputVertexColorBufferGrad)			{ input.d_renderBufferGrad				= d_inputVertexColorBufferGrad; };
+		inline void							set_D_RenderBufferGrad(const void* d_inputVertexColorBufferGrad)		{ input.d_renderBufferGrad				= d_inputVertexColorBufferGrad; };
 		inline void							set_D_TargetBufferGrad(float3* d_inputTargetGrad)						{ input.d_targetBufferGrad				= d_inputTargetGrad; };
 		inline void							set_D_vertices(float3* d_inputVertices)									{ input.d_vertices						= d_inputVertices; };
 		inline void							set_D_vertexColors(float3* d_inputVertexColors)							{ input.d_vertexColor					= d_inputVertexColors; };
-		inline void							set_D_textureMap(const float* newTextureMap)							{ input.d_textureMap					= newTextureMap; };
+		inline void							set_D_textureMap(const void* newTextureMap)								{ input.d_textureMap					= newTextureMap; };
+		inline void							setTextureChannels(int newTextureChannels)								{ input.textureChannels					= newTextureChannels; };
 		inline void							setTextureWidth(int newTextureWidth)									{ input.texWidth						= newTextureWidth; };
 		inline void							setTextureHeight(int newTextureHeight)									{ input.texHeight						= newTextureHeight; };
 		inline void							set_D_shCoeff(const float* newSHCoeff)									{ input.d_shCoeff						= newSHCoeff; };
 		inline void							set_D_vertexNormal(float3* newVertexNormal)								{ input.d_vertexNormal					= newVertexNormal; };
+		inline void							setNumberOfVertexNormalCopies(int newNumberOfCopies)					{ input.numberOfVertexNormalCopies		= newNumberOfCopies; };
 		inline void							set_D_targetImage(const float* newTargetImage)							{ input.d_targetImage					= newTargetImage; };
 
 		inline void							set_D_faceIDBuffer(int* newFaceBuffer)									{ input.d_faceIDBuffer					= newFaceBuffer; };
-		inline void							set_D_barycentricCoordinatesBuffer(float2* newBarycentricBuffer)		{ input.d_barycentricCoordinatesBuffer	= newBarycentricBuffer; };
+		inline void							set_D_barycentricCoordinatesBuffer(const void* newBarycentricBuffer)	{ input.d_barycentricCoordinatesBuffer	= newBarycentricBuffer; };
 
 		inline void							set_D_vertexPosGrad(float3* d_outputVertexPosGrad)						{ input.d_vertexPosGrad					= d_outputVertexPosGrad; };
 		inline void							set_D_vertexColorGrad(float3* d_outputVertexColorGrad)					{ input.d_vertexColorGrad				= d_outputVertexColorGrad; };
-		inline void							set_D_textureGrad(float3* d_outputTexGrad)								{ input.d_textureGrad					= d_outputTexGrad; };
+		inline void							set_D_textureGrad(float* d_outputTexGrad)								{ input.d_textureGrad					= d_outputTexGrad; };
 		inline void							set_D_shCoeffGrad(float* d_outputSHCoeffGrad)							{ input.d_shCoeffGrad					= d_outputSHCoeffGrad; };
 
 		inline void							set_D_extrinsics(const float* d_inputExtrinsics)						{ input.d_cameraExtrinsics = (float4*)d_inputExtrinsics; };
 		inline void							set_D_intrinsics(const float* d_inputIntrinsics)						{ input.d_cameraIntrinsics = (float3*)d_inputIntrinsics; };
 
+		inline void							setStream(cudaStream_t newStream)										{ input.stream = newStream; };
+
+	private:
+
+		void freeBatchBuffers();
 		
 	//variables
 
@@ -110,6 +133,24 @@ class CUDABasedRasterizationGrad
 
 		//device memory
 		CUDABasedRasterizationGradInput input;
+		std::shared_ptr<MeshTopology> topology;
+		CameraSetup cameraSetup;
+
+		//mip pyramid of the texture and its gradient, only built for the trilinear sampling
+		TextureMipmap textureMipmap;
+
+		//replayable launch graph of the backward pass, only used if enabled
+		LaunchGraph gradientGraph;
+
+		//vertex data and gradients in the reordered vertex ids, only allocated if the mesh is reordered
+		float3* d_reorderedVertices;
+		float3* d_reorderedVertexColor;
+		float3* d_reorderedVertexNormal;
+		float3* d_reorderedVertexPosGrad;
+		float3* d_reorderedVertexColorGrad;
+
+		//number of batch elements the per view and per batch element buffers are allocated for
+		int numberOfAllocatedBatches;
 };
 
 //==============================================================================================//
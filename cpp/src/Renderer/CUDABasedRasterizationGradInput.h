@@ -30,7 +30,9 @@ struct CUDABasedRasterizationGradInput
 	//////////////////////////
 
 	//camera and frame
-	int					numberOfCameras;						//number of cameras													//INIT IN CONSTRUCTOR
+	int					numberOfCameras;						//number of cameras per batch element								//INIT IN CONSTRUCTOR
+	int					numberOfBatches;						//number of batch elements differentiated in one pass				//SET IN EVERY BACKWARD PASS
+	int					numberOfViews;							//camera c of batch element b is view b * numberOfCameras + c		//SET IN EVERY BACKWARD PASS
 	int					w;										//frame width														//INIT IN CONSTRUCTOR
 	int					h;										//frame height														//INIT IN CONSTRUCTOR
 
@@ -38,6 +40,7 @@ struct CUDABasedRasterizationGradInput
 	int					F;										//number of faces													//INIT IN CONSTRUCTOR			
 	int					N;										//number of vertices												//INIT IN CONSTRUCTOR
 	int3*				d_facesVertex;							//part of face data structure										//INIT IN CONSTRUCTOR
+	int*				d_reorderedFaceIds;						//reordered id of each original face, NULL if not reordered			//INIT IN CONSTRUCTOR
 
 	//texture	
 	float*				d_textureCoordinates;																						//INIT IN CONSTRUCTOR			
@@ -53,27 +56,40 @@ struct CUDABasedRasterizationGradInput
 	ShadingMode			shadingMode;							//which shading is used												//INIT IN CONSTRUCTOR
 	float4*				d_inverseExtrinsics;					//inverse camera extrinsics											//INIT IN CONSTRUCTOR
 	float4*				d_inverseProjection;					//inverse camera projection											//INIT IN CONSTRUCTOR
+	float3*				d_cameraCenters;						//ray origin per camera (see CameraSetup)							//INIT IN CONSTRUCTOR
 	int					imageFilterSize;						//filter size of the sobel operator									//INIT IN CONSTRUCTOR
 	int					textureFilterSize;						//filter size of texture for the sobel operator						//INIT IN CONSTRUCTOR
+	bool				profile;								//flag whether the kernel launches of the backward pass are reported	//INIT IN CONSTRUCTOR
+	LaunchGraph*		gradientGraph;							//launch graph of the backward pass, NULL to launch it directly		//INIT IN CONSTRUCTOR
+	cudaStream_t		stream;									//device stream of the op, all launches and copies are issued on it	//SET IN EVERY BACKWARD PASS
+	BufferFormat		renderBufferGradFormat;					//storage format of the render buffer gradient						//INIT IN CONSTRUCTOR
+	BufferFormat		barycentricFormat;						//storage format of the barycentric buffer							//INIT IN CONSTRUCTOR
+	BufferFormat		textureFormat;							//storage format of the texture										//INIT IN CONSTRUCTOR
+	TextureSampling		textureSampling;						//how the texture is sampled										//INIT IN CONSTRUCTOR
 		
 	//////////////////////////
 	//INPUTS
 	//////////////////////////
 	
-	float3*				d_renderBufferGrad;						//render buffer gradient from later layers
-	float3*				d_targetBufferGrad;						//render buffer gradient from later layers
-
-	float3*				d_vertices;								//vertex positions
-	float3*				d_vertexColor;							//vertex color								
-	const float*		d_textureMap;							//texture map																						
-	const float*		d_shCoeff;								//shading coefficients
-	float3*				d_vertexNormal;							//vertex normals				
-	float2*				d_barycentricCoordinatesBuffer;			//barycentric coordinates per pixel per view														
+	const void*			d_renderBufferGrad;						//render buffer gradient from later layers (renderBufferGradFormat), NULL if render was not requested
+	float3*				d_targetBufferGrad;						//target buffer gradient from later layers, NULL if target was not requested
+
+	float3*				d_vertices;								//vertex positions per batch element
+	float3*				d_vertexColor;							//vertex color per batch element								
+	const void*			d_textureMap;							//texture map per batch element (textureFormat, textureChannels per texel)																					
+	const float*		d_shCoeff;								//shading coefficients per view
+	float3*				d_vertexNormal;							//vertex normals per batch element, only the first copy is read				
+	int					numberOfVertexNormalCopies;				//copies of the vertex normals per batch element (see VertexNormalLayout)
+	const void*			d_barycentricCoordinatesBuffer;			//barycentric coordinates per pixel per view (barycentricFormat)													
 	int*				d_faceIDBuffer;							//face ID per pixel per view and the ids of the 3 vertices
 	const float*		d_targetImage;							//target image used for model to data gradient
 	
 	int					texWidth;								//dimension of texture																				
-	int					texHeight;								//dimension of texture		
+	int					texHeight;								//dimension of texture
+	int					textureChannels;						//3 for RGB, 4 for the RGBA padded layout of aligned vector loads
+	const float4*		d_textureMipmap;						//mip levels above the base level per batch element (TextureMipmap.h), trilinear sampling only
+	int					textureMipmapLevels;					//number of mip levels including the base level
+	int					textureMipmapTexels;					//texels of the mip levels above the base level per batch element
 
 	float4*				d_cameraExtrinsics;						//camera extrinsics													
 	float3*				d_cameraIntrinsics;						//camera intrinsics													
@@ -84,6 +100,7 @@ struct CUDABasedRasterizationGradInput
 
 	float3*				d_vertexPosGrad;
 	float3*				d_vertexColorGrad;
-	float3*				d_textureGrad;
+	float*				d_textureGrad;							//in float for every texture format, textureChannels per texel, NULL for 8 bit textures
+	float4*				d_textureMipmapGrad;					//gradient of the mip levels, gathered into d_textureGrad after the pass
 	float*				d_shCoeffGrad;
 };
@@ -15,11 +15,37 @@
 
 #include <cuda_runtime.h> 
 #include "../Utils/cuda_SimpleMatrixUtil.h"
+#include "Meshlets.h"
+#include "TriangleSetup.h"
+#include "Visibility.h"
+#include "BufferFormat.h"
+#include "CameraSetup.h"
+#include "LaunchGraph.h"
+#include "TextureMipmap.h"
 
 //==============================================================================================//
 
 #define THREADS_PER_BLOCK_CUDABASEDRASTERIZER 256
 
+//edge length of the screen tiles of the binned rasterizer, one thread per pixel of a tile
+#define RASTERIZER_TILE_SIZE 16
+
+//number of faces staged at once by the tile rasterizer, the far depth of the tile is updated after every chunk
+#define RASTERIZER_CHUNK_SIZE 64
+
+//relative depth margin of the hierarchical depth test, covers the barycentric tolerance of the ray casting
+#define HIZ_DEPTH_TOLERANCE 0.002f
+
+//size classes of the binning by the number of overlapped tiles: small faces are binned by one thread, medium faces by one warp,
+//larger faces are split into bands of tile rows distributed across blocks
+#define BINNING_SMALL_FACE_TILES 4
+#define BINNING_MEDIUM_FACE_TILES 64
+#define NUMBER_OF_FACE_BUCKETS 3
+#define WARP_SIZE 32
+
+//grid size limit of the binning kernels, their grids do not depend on the size classes and the threads stride over the faces
+#define BINNING_MAX_BLOCKS 1024
+
 //==============================================================================================//
 
 enum AlbedoMode
@@ -36,6 +62,36 @@ enum ShadingMode
 
 //==============================================================================================//
 
+/*
+PerCamera	: one copy of the vertex normals per camera (C x N), the original layout
+Shared		: the vertex normals once (N), they do not depend on the camera
+*/
+enum VertexNormalLayout
+{
+	PerCamera, Shared
+};
+
+//==============================================================================================//
+
+/*
+Outputs of the forward pass as bit flags. The buffers of unrequested outputs are NULL, they are not written and the kernels
+which only feed them are skipped.
+*/
+enum RenderOutput
+{
+	BarycentricOutput	= 1 << 0,
+	FaceOutput			= 1 << 1,
+	RenderBufferOutput	= 1 << 2,
+	VertexNormalOutput	= 1 << 3,
+	TargetOutput		= 1 << 4,
+	NormalMapOutput		= 1 << 5,
+	CulledFacesOutput	= 1 << 6,
+	HiZStatisticsOutput	= 1 << 7,
+	AllOutputs			= (1 << 8) - 1
+};
+
+//==============================================================================================//
+
 struct CUDABasedRasterizationInput
 {
 	//////////////////////////
@@ -43,7 +99,9 @@ struct CUDABasedRasterizationInput
 	//////////////////////////
 
 	//camera and frame
-	int					numberOfCameras;						//number of cameras													//INIT IN CONSTRUCTOR
+	int					numberOfCameras;						//number of cameras per batch element								//INIT IN CONSTRUCTOR
+	int					numberOfBatches;						//number of batch elements rendered in one pass						//SET IN EVERY FORWARD PASS
+	int					numberOfViews;							//camera c of batch element b is view b * numberOfCameras + c		//SET IN EVERY FORWARD PASS
 	
 	int					w;										//frame width														//INIT IN CONSTRUCTOR
 	int					h;										//frame height														//INIT IN CONSTRUCTOR
@@ -54,13 +112,34 @@ struct CUDABasedRasterizationInput
 	int3*				d_facesVertex;							//part of face data structure										//INIT IN CONSTRUCTOR
 	int*                d_vertexFaces;                          //list of neighbourhood faces for each vertex						//INIT IN CONSTRUCTOR
 	int2*               d_vertexFacesId;                        //list of (index in d_vertexFaces, number of faces) for each vertex	//INIT IN CONSTRUCTOR
+	int*				d_originalFaceIds;						//original id of each reordered face, NULL if not reordered			//INIT IN CONSTRUCTOR
+	int*				d_reorderedFaceIds;						//reordered id of each original face, NULL if not reordered			//INIT IN CONSTRUCTOR
+
+	//meshlets
+	int					numberOfMeshlets;						//number of meshlets												//INIT IN CONSTRUCTOR
+	int*				d_meshletFaces;							//face ids grouped by meshlet										//INIT IN CONSTRUCTOR
+	int2*				d_meshlets;								//(index in d_meshletFaces, number of faces) for each meshlet		//INIT IN CONSTRUCTOR
+	bool				twoSided;								//flag whether meshlets facing away from the camera are rendered	//INIT IN CONSTRUCTOR
 
 	//texture 
 	float*				d_textureCoordinates;																						//INIT IN CONSTRUCTOR
-	float4*				d_textureMapIds;						//per pixel face and barycentric coords								//INIT IN FIRST RUN OF FORWARD PASS
+	int2*				d_textureMapIds;						//per texel packed face and barycentric coords (TextureAtlas.h)		//SET IN EVERY FORWARD PASS
 
 	//computation
 	bool				computeNormal;							//flag whether the normal map or the rendered image is comp			//INIT IN CONSTRUCTOR
+	bool				triangleSetup;							//flag whether faces are rasterized from their triangle setup		//INIT IN CONSTRUCTOR
+	VisibilityMode		visibilityMode;							//which depth is packed into the visibility keys					//INIT IN CONSTRUCTOR
+	bool				hierarchicalZ;							//flag whether faces behind the far depth of a tile are skipped		//INIT IN CONSTRUCTOR
+	bool				profile;								//flag whether the stages of the forward pass are timed				//INIT IN CONSTRUCTOR
+	LaunchGraph*		geometryGraph;							//launch graph of the geometry stage, NULL to launch it directly	//INIT IN CONSTRUCTOR
+	LaunchGraph*		rasterGraph;							//launch graph of the binning and the raster stage, NULL to launch them directly	//INIT IN CONSTRUCTOR
+	cudaStream_t		stream;									//device stream of the op, all launches and copies are issued on it	//SET IN EVERY FORWARD PASS
+	VertexNormalLayout	vertexNormalLayout;						//whether the vertex normals are copied for every camera			//INIT IN CONSTRUCTOR
+	int					outputs;								//requested outputs (RenderOutput flags)							//INIT IN CONSTRUCTOR
+	BufferFormat		renderBufferFormat;						//storage format of the render buffer								//INIT IN CONSTRUCTOR
+	BufferFormat		barycentricFormat;						//storage format of the barycentric buffer							//INIT IN CONSTRUCTOR
+	BufferFormat		textureFormat;							//storage format of the texture										//INIT IN CONSTRUCTOR
+	TextureSampling		textureSampling;						//how the texture is sampled										//INIT IN CONSTRUCTOR
 
 	//////////////////////////
 	//STATES 
@@ -68,25 +147,49 @@ struct CUDABasedRasterizationInput
 
 	//misc
 	int4*				d_BBoxes;								//bbox for each triangle											//INIT IN CONSTRUCTOR
+	FaceSetup*			d_faceSetups;							//triangle setup for each camera and triangle						//INIT IN CONSTRUCTOR
+	unsigned long long*	d_visibilityBuffer;						//packed (depth, face id) of the visible face per pixel per view	//INIT IN CONSTRUCTOR
 	float3*				d_projectedVertices;					//vertex position on image with depth after projection				//INIT IN CONSTRUCTOR
 	float3*				d_faceNormal;							//face normals														//INIT IN CONSTRUCTOR
 	AlbedoMode			albedoMode;								//which albedo is used												//INIT IN CONSTRUCTOR
 	ShadingMode			shadingMode;							//which shading is used												//INIT IN CONSTRUCTOR
 	float4*				d_inverseExtrinsics;					// inverse camera extrinsics										//INIT IN CONSTRUCTOR
 	float4*				d_inverseProjection;					// inverse camera projection										//INIT IN CONSTRUCTOR
+	float3*				d_cameraCenters;						//ray origin per camera (see CameraSetup)							//INIT IN CONSTRUCTOR
+	MeshletBounds*		d_meshletBounds;						//bounding sphere and normal cone for each meshlet					//INIT IN CONSTRUCTOR
+	int2*				d_visibleMeshlets;						//(camera, meshlet) of the meshlets that passed the culling			//INIT IN CONSTRUCTOR
+	int*				d_numberOfVisibleMeshlets;				//number of entries in d_visibleMeshlets							//INIT IN CONSTRUCTOR
+	int2*				d_visibleFaces;							//(camera, face) of the faces that passed the culling				//INIT IN CONSTRUCTOR
+	int*				d_numberOfVisibleFaces;					//number of entries in d_visibleFaces								//INIT IN CONSTRUCTOR
+	int*				d_faceBuckets;							//visible face indices: small ->, <- medium | large ->				//INIT IN CONSTRUCTOR
+	int*				d_faceBucketSizes;						//number of small, medium and large faces							//INIT IN CONSTRUCTOR
+
+	//tile binning
+	int					numberOfTilesU;							//number of screen tiles per row									//INIT IN CONSTRUCTOR
+	int					numberOfTilesV;							//number of screen tiles per column									//INIT IN CONSTRUCTOR
+	int*				d_tileFaceCounts;						//number of faces per camera and tile								//INIT IN CONSTRUCTOR
+	int*				d_tileFaceOffsets;						//start of the faces of each camera and tile in d_tileFaces			//INIT IN CONSTRUCTOR
+	int*				d_tileFaces;							//face ids binned per camera and tile								//INIT IN CONSTRUCTOR
+	int					tileFacesCapacity;						//allocated size of d_tileFaces, tiles whose lists overflow it are rasterized from d_visibleFaces	//INIT IN CONSTRUCTOR
+	int*				h_numberOfBinnedFaces;					//pinned host copy of the binned faces of the last forward pass, regrows d_tileFaces	//INIT IN CONSTRUCTOR
+	cudaEvent_t			binnedFacesEvent;						//recorded after the copy into h_numberOfBinnedFaces				//INIT IN CONSTRUCTOR
 
 	//////////////////////////
 	//INPUTS
 	//////////////////////////
 
-	float3*				d_vertices;								//vertex positions
-	float3*				d_vertexColor;							//vertex color
+	float3*				d_vertices;								//vertex positions per batch element
+	float3*				d_vertexColor;							//vertex color per batch element
 									
 	//texture
 	int					texWidth;								//dimension of texture
 	int					texHeight;								//dimension of texture
-	const float*		d_textureMap;							//texture map
-	const float*		d_shCoeff;								//shading coefficients
+	const void*			d_textureMap;							//texture map per batch element (textureFormat, textureChannels per texel)
+	int					textureChannels;						//3 for RGB, 4 for the RGBA padded layout of aligned vector loads
+	const float4*		d_textureMipmap;						//mip levels above the base level per batch element (TextureMipmap.h), trilinear sampling only
+	int					textureMipmapLevels;					//number of mip levels including the base level
+	int					textureMipmapTexels;					//texels of the mip levels above the base level per batch element
+	const float*		d_shCoeff;								//shading coefficients per view
 
 	float4*				d_cameraExtrinsics;						//camera extrinsics												
 	float3*				d_cameraIntrinsics;						//camera intrinsics													
@@ -98,10 +201,40 @@ struct CUDABasedRasterizationInput
 	//render buffers
 	int*				d_faceIDBuffer;							//face ID per pixel per view and the ids of the 3 vertices
 	int*				d_depthBuffer;							//depth value per pixel per view
-	float*				d_barycentricCoordinatesBuffer;			//barycentric coordinates per pixel per view
-	float*				d_renderBuffer;							//buffer for the final image
+	void*				d_barycentricCoordinatesBuffer;			//barycentric coordinates per pixel per view (barycentricFormat)
+	void*				d_renderBuffer;							//buffer for the final image (renderBufferFormat)
+	int*				d_culledFaces;							//number of culled faces per view, NULL if not requested
+	int*				d_hiZStatistics;						//number of binned and of rejected (tile, face) pairs per view, NULL if not requested
 
-	float3*				d_vertexNormal;							//vertex normals			
-	float3*				d_normalMap;							//normals in normal map space
+	float3*				d_vertexNormal;							//vertex normals per batch element, kernels only read the first copy			
+	float3*				d_normalMap;							//normals in normal map space per batch element
 };
 
+//==============================================================================================//
+
+/*
+Flag whether the output is requested
+*/
+inline __host__ __device__ bool isOutputRequested(const CUDABasedRasterizationInput& input, RenderOutput output)
+{
+	return (input.outputs & output) != 0;
+}
+
+/*
+Flag whether the raster stage runs, it feeds the barycentric, face and render buffers and the hierarchical depth statistics
+*/
+inline __host__ __device__ bool isRasterizationRequested(const CUDABasedRasterizationInput& input)
+{
+	return !input.computeNormal && (input.outputs & (BarycentricOutput | FaceOutput | RenderBufferOutput | HiZStatisticsOutput)) != 0;
+}
+
+//==============================================================================================//
+
+/*
+Number of copies of the vertex normals per batch element
+*/
+inline __host__ __device__ int getNumberOfVertexNormalCopies(const CUDABasedRasterizationInput& input)
+{
+	return input.vertexNormalLayout == VertexNormalLayout::PerCamera ? input.numberOfCameras : 1;
+}
+
@@ -0,0 +1,100 @@
+//==============================================================================================//
+
+#include <cuda_runtime.h>
+#include "../Utils/cudaUtil.h"
+#include "../Utils/CameraUtil.h"
+#include "../Utils/RendererUtil.h"
+#include "CUDABasedRasterizationInput.h"
+#include "CameraSetup.h"
+
+//==============================================================================================//
+//Camera setup
+//==============================================================================================//
+
+/*
+Returns true if the rows differ (NaN rows always differ)
+*/
+__inline__ __device__ bool cameraRowChanged(float4 row, float4 cachedRow)
+{
+	return !(row.x == cachedRow.x && row.y == cachedRow.y && row.z == cachedRow.z && row.w == cachedRow.w);
+}
+
+__inline__ __device__ bool cameraRowChanged(float3 row, float3 cachedRow)
+{
+	return !(row.x == cachedRow.x && row.y == cachedRow.y && row.z == cachedRow.z);
+}
+
+//==============================================================================================//
+
+/*
+Compares the parameters of every camera with the cached ones and recomputes the inverse matrices and the center of the changed cameras
+*/
+__global__ void updateCamerasDevice(CameraSetup setup, int numberOfCameras, const float4* extrinsics, const float3* intrinsics)
+{
+	const unsigned int idc = blockIdx.x * blockDim.x + threadIdx.x;
+
+	if (idc < numberOfCameras)
+	{
+		bool changed = false;
+		for (int row = 0; row < 3; row++)
+		{
+			changed |= cameraRowChanged(extrinsics[3 * idc + row], setup.d_cachedExtrinsics[3 * idc + row]);
+			changed |= cameraRowChanged(intrinsics[3 * idc + row], setup.d_cachedIntrinsics[3 * idc + row]);
+		}
+
+		if (!changed)
+			return;
+
+		for (int row = 0; row < 3; row++)
+		{
+			setup.d_cachedExtrinsics[3 * idc + row] = extrinsics[3 * idc + row];
+			setup.d_cachedIntrinsics[3 * idc + row] = intrinsics[3 * idc + row];
+		}
+
+		computeInverseCameraMatrices(extrinsics + 3 * idc, intrinsics + 3 * idc, setup.d_inverseExtrinsics + 4 * idc, setup.d_inverseProjection + 4 * idc);
+
+		//same origin as getRayCuda2
+		float4 center = make_float4(setup.d_inverseExtrinsics[4 * idc + 0].w, setup.d_inverseExtrinsics[4 * idc + 1].w, setup.d_inverseExtrinsics[4 * idc + 2].w, setup.d_inverseExtrinsics[4 * idc + 3].w);
+		center /= center.w;
+		setup.d_cameraCenters[idc] = make_float3(center.x, center.y, center.z);
+	}
+}
+
+//==============================================================================================//
+
+void createCameraSetup(CameraSetup& setup, int numberOfCameras, cudaStream_t stream)
+{
+	setup.numberOfCameras	= numberOfCameras;
+
+	cutilSafeCall(cudaMalloc(&setup.d_cachedExtrinsics,		sizeof(float4) * numberOfCameras * 3));
+	cutilSafeCall(cudaMalloc(&setup.d_cachedIntrinsics,		sizeof(float3) * numberOfCameras * 3));
+	cutilSafeCall(cudaMalloc(&setup.d_inverseExtrinsics,	sizeof(float4) * numberOfCameras * 4));
+	cutilSafeCall(cudaMalloc(&setup.d_inverseProjection,	sizeof(float4) * numberOfCameras * 4));
+	cutilSafeCall(cudaMalloc(&setup.d_cameraCenters,		sizeof(float3) * numberOfCameras));
+
+	//all bits set is a NaN, so the first update sets up every camera
+	cutilSafeCall(cudaMemsetAsync(setup.d_cachedExtrinsics, 0xFF, sizeof(float4) * numberOfCameras * 3, stream));
+	cutilSafeCall(cudaMemsetAsync(setup.d_cachedIntrinsics, 0xFF, sizeof(float3) * numberOfCameras * 3, stream));
+}
+
+//==============================================================================================//
+
+void destroyCameraSetup(CameraSetup& setup)
+{
+	cutilSafeCall(cudaFree(setup.d_cachedExtrinsics));
+	cutilSafeCall(cudaFree(setup.d_cachedIntrinsics));
+	cutilSafeCall(cudaFree(setup.d_inverseExtrinsics));
+	cutilSafeCall(cudaFree(setup.d_inverseProjection));
+	cutilSafeCall(cudaFree(setup.d_cameraCenters));
+}
+
+//==============================================================================================//
+
+extern "C" int updateCameraSetupGPU(CameraSetup& setup, int numberOfCameras, const float4* d_extrinsics, const float3* d_intrinsics, cudaStream_t stream)
+{
+	updateCamerasDevice		<< <(numberOfCameras + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (setup, numberOfCameras, d_extrinsics, d_intrinsics);
+
+	return 1;
+}
+
+//==============================================================================================//
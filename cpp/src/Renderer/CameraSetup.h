@@ -0,0 +1,65 @@
+//==============================================================================================//
+// Classname:
+//      CameraSetup
+//
+//==============================================================================================//
+// Description:
+//      Derived camera data of a renderer: inverse matrices and camera centers. The data is cached
+//		on the device together with the camera parameters it was computed from and only recomputed
+//		for the cameras whose parameters changed, so static camera rigs pay the setup once. The ray
+//		through a pixel center is built from them in a few FMAs instead of being stored per pixel.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <cuda_runtime.h>
+#include "cutil_math.h"
+
+//==============================================================================================//
+
+struct CameraSetup
+{
+	int			numberOfCameras;							//number of allocated cameras
+
+	float4*		d_cachedExtrinsics;						//extrinsics the cameras were set up with, NaN before the first update
+	float3*		d_cachedIntrinsics;						//intrinsics the cameras were set up with, NaN before the first update
+
+	float4*		d_inverseExtrinsics;					//inverse camera extrinsics (4 rows per camera)
+	float4*		d_inverseProjection;					//inverse camera projection (4 rows per camera)
+	float3*		d_cameraCenters;						//ray origin per camera
+};
+
+//==============================================================================================//
+
+/*
+Allocates the setup of numberOfCameras cameras and resets the cached cameras on stream, so the first update on that stream sets up every camera.
+*/
+void createCameraSetup(CameraSetup& setup, int numberOfCameras, cudaStream_t stream);
+
+void destroyCameraSetup(CameraSetup& setup);
+
+//==============================================================================================//
+
+/*
+Updates those of the first numberOfCameras cameras whose extrinsics (3 rows) or intrinsics (3 rows) differ from the cached ones,
+one thread per camera, launched on stream. Returns the number of kernel launches.
+*/
+extern "C" int updateCameraSetupGPU(CameraSetup& setup, int numberOfCameras, const float4* d_extrinsics, const float3* d_intrinsics, cudaStream_t stream);
+
+//==============================================================================================//
+
+/*
+Normalized direction of the ray from the camera center through the center of pixel (u, v), the same ray as getRayCuda2.
+inverseProjection are the 4 rows of the camera.
+*/
+inline __host__ __device__ float3 getPixelRayDirection(const float4* inverseProjection, float3 cameraCenter, int u, int v)
+{
+	float4 pixel = make_float4((u + 0.5f) * 1000.f, (v + 0.5f) * 1000.f, 1000.f, 1.f);
+	float3 farPoint = make_float3(dot(inverseProjection[0], pixel), dot(inverseProjection[1], pixel), dot(inverseProjection[2], pixel));
+	return normalize(farPoint - cameraCenter);
+}
+
+//==============================================================================================//
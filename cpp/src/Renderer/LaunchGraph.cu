@@ -0,0 +1,177 @@
+//==============================================================================================//
+
+#include <cuda_runtime.h>
+#include <string.h>
+#include <iostream>
+#include "../Utils/cudaUtil.h"
+#include "LaunchGraph.h"
+
+//==============================================================================================//
+//Launch graph
+//==============================================================================================//
+
+void createLaunchGraph(LaunchGraph& launchGraph)
+{
+	launchGraph.capturable			= true;
+	launchGraph.numberOfCaptures	= 0;
+	launchGraph.numberOfLaunches	= 0;
+	launchGraph.graph				= NULL;
+	launchGraph.graphExec			= NULL;
+}
+
+//==============================================================================================//
+
+/*
+Drops the captured sequence, the next launch captures it again
+*/
+static void releaseCapturedSequence(LaunchGraph& launchGraph)
+{
+	if (launchGraph.graphExec != NULL)
+		cutilSafeCall(cudaGraphExecDestroy(launchGraph.graphExec));
+
+	if (launchGraph.graph != NULL)
+		cutilSafeCall(cudaGraphDestroy(launchGraph.graph));
+
+	launchGraph.graph		= NULL;
+	launchGraph.graphExec	= NULL;
+	launchGraph.signature.clear();
+	launchGraph.kernelNodes.clear();
+	launchGraph.kernelNodeParams.clear();
+	launchGraph.argument.clear();
+}
+
+//==============================================================================================//
+
+void destroyLaunchGraph(LaunchGraph& launchGraph)
+{
+	releaseCapturedSequence(launchGraph);
+}
+
+//==============================================================================================//
+
+/*
+Captures the sequence on a private stream (the stream of the caller may be the default stream, which cannot be captured) and instantiates the graph. Returns false if the capture failed.
+*/
+static bool captureSequence(LaunchGraph& launchGraph, const std::vector<int>& signature, const void* argument, size_t argumentSize, const std::function<int(cudaStream_t)>& launchSequence)
+{
+	cudaStream_t captureStream;
+	cutilSafeCall(cudaStreamCreateWithFlags(&captureStream, cudaStreamNonBlocking));
+
+	int numberOfLaunches = 0;
+	cudaGraph_t graph = NULL;
+	cudaError_t status = cudaStreamBeginCapture(captureStream, cudaStreamCaptureModeThreadLocal);
+	if (status == cudaSuccess)
+	{
+		numberOfLaunches = launchSequence(captureStream);
+		status = cudaStreamEndCapture(captureStream, &graph);
+	}
+
+	cutilSafeCall(cudaStreamDestroy(captureStream));
+
+	cudaGraphExec_t graphExec = NULL;
+	if (status == cudaSuccess && graph != NULL)
+		status = cudaGraphInstantiate(&graphExec, graph, NULL, NULL, 0);
+
+	//kernel nodes and their launch configuration, the configuration is kept when the argument is patched
+	size_t numberOfNodes = 0;
+	if (status == cudaSuccess)
+		status = cudaGraphGetNodes(graph, NULL, &numberOfNodes);
+
+	std::vector<cudaGraphNode_t> nodes(numberOfNodes);
+	if (status == cudaSuccess && numberOfNodes > 0)
+		status = cudaGraphGetNodes(graph, nodes.data(), &numberOfNodes);
+
+	for (size_t n = 0; n < numberOfNodes && status == cudaSuccess; n++)
+	{
+		cudaGraphNodeType type;
+		status = cudaGraphNodeGetType(nodes[n], &type);
+		if (status != cudaSuccess || type != cudaGraphNodeTypeKernel)
+			continue;
+
+		cudaKernelNodeParams params;
+		status = cudaGraphKernelNodeGetParams(nodes[n], &params);
+		launchGraph.kernelNodes.push_back(nodes[n]);
+		launchGraph.kernelNodeParams.push_back(params);
+	}
+
+	if (status != cudaSuccess)
+	{
+		//the failed capture leaves an error behind, the launches themselves were never executed
+		cudaGetLastError();
+
+		if (graphExec != NULL)
+			cutilSafeCall(cudaGraphExecDestroy(graphExec));
+		if (graph != NULL)
+			cutilSafeCall(cudaGraphDestroy(graph));
+
+		launchGraph.kernelNodes.clear();
+		launchGraph.kernelNodeParams.clear();
+
+		std::cout << "Launch graph: capture failed (" << cudaGetErrorString(status) << "), launching the kernels directly" << std::endl;
+		return false;
+	}
+
+	launchGraph.graph				= graph;
+	launchGraph.graphExec			= graphExec;
+	launchGraph.signature			= signature;
+	launchGraph.numberOfLaunches	= numberOfLaunches;
+	launchGraph.numberOfCaptures++;
+
+	//the graph was captured with the current argument
+	launchGraph.argument.assign((const char*)argument, (const char*)argument + argumentSize);
+
+	return true;
+}
+
+//==============================================================================================//
+
+/*
+Sets the argument of every kernel node if it differs from the last one
+*/
+static void patchKernelArgument(LaunchGraph& launchGraph, const void* argument, size_t argumentSize)
+{
+	if (launchGraph.argument.size() == argumentSize && memcmp(launchGraph.argument.data(), argument, argumentSize) == 0)
+		return;
+
+	void* kernelParams[1] = { const_cast<void*>(argument) };
+
+	for (size_t n = 0; n < launchGraph.kernelNodes.size(); n++)
+	{
+		cudaKernelNodeParams params = launchGraph.kernelNodeParams[n];
+		params.kernelParams = kernelParams;
+		params.extra = NULL;
+		cutilSafeCall(cudaGraphExecKernelNodeSetParams(launchGraph.graphExec, launchGraph.kernelNodes[n], &params));
+	}
+
+	launchGraph.argument.assign((const char*)argument, (const char*)argument + argumentSize);
+}
+
+//==============================================================================================//
+
+int launchGraphGPU(LaunchGraph& launchGraph, const std::vector<int>& signature, const void* argument, size_t argumentSize, cudaStream_t stream, const std::function<int(cudaStream_t)>& launchSequence)
+{
+	if (!launchGraph.capturable)
+		return launchSequence(stream);
+
+	//a new shape signature changes the launch configurations, the sequence is captured again
+	if (launchGraph.graphExec == NULL || launchGraph.signature != signature)
+	{
+		releaseCapturedSequence(launchGraph);
+
+		if (!captureSequence(launchGraph, signature, argument, argumentSize, launchSequence))
+		{
+			launchGraph.capturable = false;
+			return launchSequence(stream);
+		}
+	}
+	else
+	{
+		patchKernelArgument(launchGraph, argument, argumentSize);
+	}
+
+	cutilSafeCall(cudaGraphLaunch(launchGraph.graphExec, stream));
+
+	return 1;
+}
+
+//==============================================================================================//
@@ -0,0 +1,57 @@
+//==============================================================================================//
+// Classname:
+//      LaunchGraph
+//
+//==============================================================================================//
+// Description:
+//      Replayable launch graph of a fixed shape kernel sequence. The sequence is captured into a
+//		CUDA graph once per shape signature (the values its launch configurations depend on) and
+//		replayed with a single graph launch afterwards. Before a replay only the kernel argument
+//		of the kernel nodes is patched, so all kernels of a sequence take the same argument (the
+//		input struct holding the device pointers) as their only parameter. A changed signature
+//		recaptures the sequence, a failed capture falls back to launching it directly.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <cuda_runtime.h>
+#include <functional>
+#include <vector>
+
+//==============================================================================================//
+
+struct LaunchGraph
+{
+	bool								capturable;			//false once a capture failed, the sequence is then always launched directly
+	int									numberOfCaptures;	//number of captures, one per shape signature change
+
+	std::vector<int>					signature;			//shape signature of the captured sequence, empty if nothing is captured
+	int									numberOfLaunches;	//number of kernel launches of the captured sequence
+
+	cudaGraph_t							graph;
+	cudaGraphExec_t						graphExec;
+	std::vector<cudaGraphNode_t>		kernelNodes;		//kernel nodes of the graph
+	std::vector<cudaKernelNodeParams>	kernelNodeParams;	//launch configuration of every kernel node
+	std::vector<char>					argument;			//kernel argument the kernel nodes were last patched with
+};
+
+//==============================================================================================//
+
+void createLaunchGraph(LaunchGraph& launchGraph);
+
+void destroyLaunchGraph(LaunchGraph& launchGraph);
+
+//==============================================================================================//
+
+/*
+Launches the kernel sequence of launchSequence on stream. launchSequence launches the sequence on the given stream and
+returns its number of kernel launches, every kernel takes argument (argumentSize bytes) as its only parameter.
+The sequence is captured when the signature differs from the captured one and replayed from the graph otherwise.
+Returns the number of launches of the call, 1 for a replay.
+*/
+int launchGraphGPU(LaunchGraph& launchGraph, const std::vector<int>& signature, const void* argument, size_t argumentSize, cudaStream_t stream, const std::function<int(cudaStream_t)>& launchSequence);
+
+//==============================================================================================//
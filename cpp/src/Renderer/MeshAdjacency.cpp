@@ -0,0 +1,192 @@
+//==============================================================================================//
+
+#include "MeshAdjacency.h"
+#include "../Utils/ThreadPool.h"
+#include <iostream>
+#include <algorithm>
+
+//==============================================================================================//
+
+#define FACES_PER_ADJACENCY_CHUNK 16384
+
+//==============================================================================================//
+
+void computeVertexFaces(int numberOfVertices, const std::vector<int>& faces, std::vector<int>& vertexFaces, std::vector<int>& vertexFacesId)
+{
+	ThreadPool& threadPool = ThreadPool::getInstance();
+
+	int F = faces.size() / 3;
+	int N = numberOfVertices;
+
+	//faces are split into consecutive chunks which are processed in order, so within a vertex the faces stay sorted
+	int numberOfChunks = std::max(1, std::min(threadPool.getNumberOfThreads(), (F + FACES_PER_ADJACENCY_CHUNK - 1) / FACES_PER_ADJACENCY_CHUNK));
+	int facesPerChunk  = (F + numberOfChunks - 1) / std::max(numberOfChunks, 1);
+
+	//vertex ranges used for the passes that run over the vertices
+	int numberOfVertexRanges = std::max(1, std::min(threadPool.getNumberOfThreads(), N));
+	int verticesPerRange	 = (N + numberOfVertexRanges - 1) / numberOfVertexRanges;
+
+	//per chunk histogram of the number of faces per vertex
+	std::vector<int> chunkOffsets((size_t)numberOfChunks * N, 0);
+
+	threadPool.parallelFor(numberOfChunks, [&](int c)
+	{
+		int* counts = chunkOffsets.data() + (size_t)c * N;
+		int faceEnd = std::min(F, (c + 1) * facesPerChunk);
+
+		for (int f = c * facesPerChunk; f < faceEnd; f++)
+		{
+			int v0 = faces[3 * f + 0];
+			int v1 = faces[3 * f + 1];
+			int v2 = faces[3 * f + 2];
+
+			//degenerated faces are only listed once per vertex
+			counts[v0]++;
+			if (v1 != v0)
+				counts[v1]++;
+			if (v2 != v0 && v2 != v1)
+				counts[v2]++;
+		}
+	});
+
+	//number of faces per vertex
+	vertexFacesId.assign(2 * N, 0);
+
+	threadPool.parallelFor(numberOfVertexRanges, [&](int r)
+	{
+		int vertexEnd = std::min(N, (r + 1) * verticesPerRange);
+
+		for (int v = r * verticesPerRange; v < vertexEnd; v++)
+		{
+			int numberOfFaces = 0;
+			for (int c = 0; c < numberOfChunks; c++)
+				numberOfFaces += chunkOffsets[(size_t)c * N + v];
+			vertexFacesId[2 * v + 1] = numberOfFaces;
+		}
+	});
+
+	//exclusive prefix sum gives the start index of each vertex
+	int startId = 0;
+	for (int v = 0; v < N; v++)
+	{
+		vertexFacesId[2 * v + 0] = startId;
+		startId += vertexFacesId[2 * v + 1];
+
+		if (vertexFacesId[2 * v + 1] == 0)
+			std::cout << "WARNING:: --------- no faces for vertex " << v << " --------- " << std::endl;
+	}
+
+	//turn the chunk histograms into write offsets
+	threadPool.parallelFor(numberOfVertexRanges, [&](int r)
+	{
+		int vertexEnd = std::min(N, (r + 1) * verticesPerRange);
+
+		for (int v = r * verticesPerRange; v < vertexEnd; v++)
+		{
+			int offset = vertexFacesId[2 * v + 0];
+			for (int c = 0; c < numberOfChunks; c++)
+			{
+				int count = chunkOffsets[(size_t)c * N + v];
+				chunkOffsets[(size_t)c * N + v] = offset;
+				offset += count;
+			}
+		}
+	});
+
+	//scatter the face ids
+	vertexFaces.resize(startId);
+
+	threadPool.parallelFor(numberOfChunks, [&](int c)
+	{
+		int* offsets = chunkOffsets.data() + (size_t)c * N;
+		int faceEnd = std::min(F, (c + 1) * facesPerChunk);
+
+		for (int f = c * facesPerChunk; f < faceEnd; f++)
+		{
+			int v0 = faces[3 * f + 0];
+			int v1 = faces[3 * f + 1];
+			int v2 = faces[3 * f + 2];
+
+			vertexFaces[offsets[v0]++] = f;
+			if (v1 != v0)
+				vertexFaces[offsets[v1]++] = f;
+			if (v2 != v0 && v2 != v1)
+				vertexFaces[offsets[v2]++] = f;
+		}
+	});
+}
+
+//==============================================================================================//
+
+/*
+Collects the distinct vertices of the faces adjacent to v (except v itself) in ascending order
+*/
+static void gatherVertexNeighbours(int v, const std::vector<int>& faces, const std::vector<int>& vertexFaces, const std::vector<int>& vertexFacesId, std::vector<int>& neighbours)
+{
+	neighbours.clear();
+
+	for (int i = vertexFacesId[2 * v + 0]; i < vertexFacesId[2 * v + 0] + vertexFacesId[2 * v + 1]; i++)
+	{
+		int f = vertexFaces[i];
+		for (int k = 0; k < 3; k++)
+		{
+			if (faces[3 * f + k] != v)
+				neighbours.push_back(faces[3 * f + k]);
+		}
+	}
+
+	std::sort(neighbours.begin(), neighbours.end());
+	neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+}
+
+//==============================================================================================//
+
+void computeVertexNeighbours(int numberOfVertices, const std::vector<int>& faces, const std::vector<int>& vertexFaces, const std::vector<int>& vertexFacesId, std::vector<int>& vertexNeighbours, std::vector<int>& vertexNeighboursId)
+{
+	ThreadPool& threadPool = ThreadPool::getInstance();
+
+	int N = numberOfVertices;
+
+	int numberOfVertexRanges = std::max(1, std::min(threadPool.getNumberOfThreads(), N));
+	int verticesPerRange	 = (N + numberOfVertexRanges - 1) / numberOfVertexRanges;
+
+	//number of neighbours per vertex
+	vertexNeighboursId.assign(2 * N, 0);
+
+	threadPool.parallelFor(numberOfVertexRanges, [&](int r)
+	{
+		std::vector<int> neighbours;
+		int vertexEnd = std::min(N, (r + 1) * verticesPerRange);
+
+		for (int v = r * verticesPerRange; v < vertexEnd; v++)
+		{
+			gatherVertexNeighbours(v, faces, vertexFaces, vertexFacesId, neighbours);
+			vertexNeighboursId[2 * v + 1] = neighbours.size();
+		}
+	});
+
+	//exclusive prefix sum gives the start index of each vertex
+	int startId = 0;
+	for (int v = 0; v < N; v++)
+	{
+		vertexNeighboursId[2 * v + 0] = startId;
+		startId += vertexNeighboursId[2 * v + 1];
+	}
+
+	//write the neighbour ids, the neighbour lists are cheap to gather again
+	vertexNeighbours.resize(startId);
+
+	threadPool.parallelFor(numberOfVertexRanges, [&](int r)
+	{
+		std::vector<int> neighbours;
+		int vertexEnd = std::min(N, (r + 1) * verticesPerRange);
+
+		for (int v = r * verticesPerRange; v < vertexEnd; v++)
+		{
+			gatherVertexNeighbours(v, faces, vertexFaces, vertexFacesId, neighbours);
+			std::copy(neighbours.begin(), neighbours.end(), vertexNeighbours.begin() + vertexNeighboursId[2 * v + 0]);
+		}
+	});
+}
+
+//==============================================================================================//
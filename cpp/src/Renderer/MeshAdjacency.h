@@ -0,0 +1,35 @@
+//==============================================================================================//
+// Classname:
+//      MeshAdjacency
+//
+//==============================================================================================//
+// Description:
+//      Builds the vertex to face adjacency (d_vertexFaces / d_vertexFacesId) in CSR layout
+//		with a multithreaded counting sort in O(N + F) and the vertex to vertex adjacency
+//		in the same layout
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+
+//==============================================================================================//
+
+/*
+vertexFaces		: ids of the faces adjacent to each vertex, sorted by vertex and ascending face id
+vertexFacesId	: (index in vertexFaces, number of faces) for each vertex, i.e. 2 * numberOfVertices ints
+*/
+void computeVertexFaces(int numberOfVertices, const std::vector<int>& faces, std::vector<int>& vertexFaces, std::vector<int>& vertexFacesId);
+
+//==============================================================================================//
+
+/*
+vertexNeighbours	: ids of the vertices sharing an edge with each vertex, sorted by vertex and ascending neighbour id
+vertexNeighboursId	: (index in vertexNeighbours, number of neighbours) for each vertex, i.e. 2 * numberOfVertices ints
+*/
+void computeVertexNeighbours(int numberOfVertices, const std::vector<int>& faces, const std::vector<int>& vertexFaces, const std::vector<int>& vertexFacesId, std::vector<int>& vertexNeighbours, std::vector<int>& vertexNeighboursId);
+
+//==============================================================================================//
@@ -0,0 +1,563 @@
+//==============================================================================================//
+
+#include "MeshLoader.h"
+#include "MeshAdjacency.h"
+#include "../Utils/MemoryMappedFile.h"
+#include "../Utils/ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+//==============================================================================================//
+
+#define OBJ_BYTES_PER_CHUNK (1 << 20)
+
+//==============================================================================================//
+
+struct OBJChunk
+{
+	//whole lines [begin, end) of the file
+	const char*		begin;
+	const char*		end;
+
+	int				numberOfVertices;
+	int				numberOfTextureCoordinates;
+	int				numberOfFaces;
+
+	//index of the first element of the chunk in the whole file
+	int				vertexOffset;
+	int				textureCoordinateOffset;
+	int				faceOffset;
+
+	std::string		materialLibrary;
+	std::string		error;
+};
+
+//==============================================================================================//
+
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+//==============================================================================================//
+
+static inline void skipBlanks(const char*& p, const char* end)
+{
+	while (p < end && isBlank(*p))
+		p++;
+}
+
+//==============================================================================================//
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+//==============================================================================================//
+
+/*
+Parses a decimal float. Numbers with an exactly representable mantissa and a decimal exponent up to 22
+are converted with a single correctly rounded division / multiplication, everything else with strtod,
+so the result always equals the (correctly rounded) double of the text cast to float.
+*/
+static bool parseFloat(const char*& p, const char* end, float& value)
+{
+	static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	skipBlanks(p, end);
+	const char* start = p;
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int numberOfDigits = 0;
+	int exponent = 0;
+	bool exact = true;
+
+	while (p < end && isDigit(*p))
+	{
+		if (mantissa < (1ull << 53) / 10)
+			mantissa = mantissa * 10 + (*p - '0');
+		else
+			exact = false;
+		numberOfDigits++;
+		p++;
+	}
+
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && isDigit(*p))
+		{
+			if (mantissa < (1ull << 53) / 10)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				exponent--;
+			}
+			else
+			{
+				exact = false;
+			}
+			numberOfDigits++;
+			p++;
+		}
+	}
+
+	if (numberOfDigits == 0)
+	{
+		p = start;
+		return false;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* exponentStart = p;
+		p++;
+
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negativeExponent = *p == '-';
+			p++;
+		}
+
+		if (p < end && isDigit(*p))
+		{
+			int explicitExponent = 0;
+			while (p < end && isDigit(*p))
+			{
+				explicitExponent = std::min(explicitExponent * 10 + (*p - '0'), 100000);
+				p++;
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		}
+		else
+		{
+			p = exponentStart;
+		}
+	}
+
+	if (exact && exponent >= -22 && exponent <= 22)
+	{
+		double result = (double)mantissa;
+		result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+		value = (float)(negative ? -result : result);
+		return true;
+	}
+
+	//rare slow path, the mapped file is not null terminated
+	std::string text(start, p);
+	value = (float)strtod(text.c_str(), NULL);
+	return true;
+}
+
+//==============================================================================================//
+
+static bool parseInt(const char*& p, const char* end, int& value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	if (p >= end || !isDigit(*p))
+		return false;
+
+	long long result = 0;
+	while (p < end && isDigit(*p))
+	{
+		result = std::min(result * 10 + (*p - '0'), (long long)INT32_MAX);
+		p++;
+	}
+
+	value = (int)(negative ? -result : result);
+	return true;
+}
+
+//==============================================================================================//
+
+/*
+Parses one "v/vt/vn" reference of a face, missing texture coordinates are returned as 0
+*/
+static bool parseFaceReference(const char*& p, const char* end, int& vertexId, int& textureCoordinateId)
+{
+	textureCoordinateId = 0;
+
+	if (!parseInt(p, end, vertexId))
+		return false;
+
+	if (p < end && *p == '/')
+	{
+		p++;
+		if (p < end && *p != '/')
+		{
+			if (!parseInt(p, end, textureCoordinateId))
+				return false;
+		}
+
+		if (p < end && *p == '/')
+		{
+			p++;
+			int normalId;
+			parseInt(p, end, normalId);
+		}
+	}
+
+	return p >= end || isBlank(*p);
+}
+
+//==============================================================================================//
+
+/*
+OBJ ids are 1 based, negative ids are relative to the elements read so far
+*/
+static inline int resolveId(int id, int numberOfPreviousElements)
+{
+	return id > 0 ? id - 1 : numberOfPreviousElements + id;
+}
+
+//==============================================================================================//
+
+static inline bool matchKeyword(const char* p, const char* end, const char* keyword)
+{
+	while (*keyword != 0)
+	{
+		if (p >= end || *p != *keyword)
+			return false;
+		p++;
+		keyword++;
+	}
+
+	return p >= end || isBlank(*p);
+}
+
+//==============================================================================================//
+
+/*
+First pass: counts the elements of a chunk and finds the material library
+*/
+static void countChunk(OBJChunk& chunk)
+{
+	const char* p = chunk.begin;
+
+	while (p < chunk.end)
+	{
+		const char* lineEnd = std::find(p, chunk.end, '\n');
+		skipBlanks(p, lineEnd);
+
+		if (matchKeyword(p, lineEnd, "v"))
+		{
+			chunk.numberOfVertices++;
+		}
+		else if (matchKeyword(p, lineEnd, "vt"))
+		{
+			chunk.numberOfTextureCoordinates++;
+		}
+		else if (matchKeyword(p, lineEnd, "f"))
+		{
+			//count the references, a polygon with k corners gives k - 2 triangles
+			int numberOfCorners = 0;
+			const char* q = p + 1;
+			while (q < lineEnd)
+			{
+				skipBlanks(q, lineEnd);
+				if (q >= lineEnd)
+					break;
+				numberOfCorners++;
+				while (q < lineEnd && !isBlank(*q))
+					q++;
+			}
+			chunk.numberOfFaces += std::max(0, numberOfCorners - 2);
+		}
+		else if (matchKeyword(p, lineEnd, "mtllib"))
+		{
+			const char* nameStart = p + 6;
+			skipBlanks(nameStart, lineEnd);
+			const char* nameEnd = lineEnd;
+			while (nameEnd > nameStart && isBlank(nameEnd[-1]))
+				nameEnd--;
+			chunk.materialLibrary = std::string(nameStart, nameEnd);
+		}
+
+		p = lineEnd + 1;
+	}
+}
+
+//==============================================================================================//
+
+/*
+Second pass: parses a chunk into the preallocated arrays at the offsets of the chunk
+*/
+static void parseChunk(OBJChunk& chunk, OBJMesh& mesh, std::vector<float>& textureCoordinatePool, std::vector<int>& faceTextureCoordinateIds)
+{
+	int vertexId = chunk.vertexOffset;
+	int textureCoordinateId = chunk.textureCoordinateOffset;
+	int faceId = chunk.faceOffset;
+
+	const char* p = chunk.begin;
+
+	while (p < chunk.end && chunk.error.empty())
+	{
+		const char* lineEnd = std::find(p, chunk.end, '\n');
+		skipBlanks(p, lineEnd);
+
+		if (matchKeyword(p, lineEnd, "v"))
+		{
+			p += 1;
+
+			float values[6];
+			int numberOfValues = 0;
+			while (numberOfValues < 6 && parseFloat(p, lineEnd, values[numberOfValues]))
+				numberOfValues++;
+
+			if (numberOfValues < 3)
+			{
+				chunk.error = "Invalid vertex " + std::to_string(vertexId + 1);
+				break;
+			}
+
+			for (int i = 0; i < 3; i++)
+			{
+				mesh.vertexCoordinates[3 * vertexId + i] = values[i];
+				mesh.vertexColors[3 * vertexId + i] = numberOfValues == 6 ? values[3 + i] : 1.f;
+			}
+			vertexId++;
+		}
+		else if (matchKeyword(p, lineEnd, "vt"))
+		{
+			p += 2;
+
+			float u, v;
+			if (!parseFloat(p, lineEnd, u) || !parseFloat(p, lineEnd, v))
+			{
+				chunk.error = "Invalid texture coordinate " + std::to_string(textureCoordinateId + 1);
+				break;
+			}
+
+			textureCoordinatePool[2 * textureCoordinateId + 0] = u;
+			textureCoordinatePool[2 * textureCoordinateId + 1] = v;
+			textureCoordinateId++;
+		}
+		else if (matchKeyword(p, lineEnd, "f"))
+		{
+			p += 1;
+
+			int firstVertex = 0, firstTextureCoordinate = 0, previousVertex = 0, previousTextureCoordinate = 0;
+			int numberOfCorners = 0;
+
+			while (true)
+			{
+				skipBlanks(p, lineEnd);
+				if (p >= lineEnd)
+					break;
+
+				int v, t;
+				if (!parseFaceReference(p, lineEnd, v, t))
+				{
+					chunk.error = "Invalid face " + std::to_string(faceId + 1);
+					break;
+				}
+
+				v = resolveId(v, vertexId);
+				t = t == 0 ? -1 : resolveId(t, textureCoordinateId);
+
+				if (numberOfCorners == 0)
+				{
+					firstVertex = v;
+					firstTextureCoordinate = t;
+				}
+				else if (numberOfCorners >= 2)
+				{
+					mesh.faces[3 * faceId + 0] = firstVertex;
+					mesh.faces[3 * faceId + 1] = previousVertex;
+					mesh.faces[3 * faceId + 2] = v;
+					faceTextureCoordinateIds[3 * faceId + 0] = firstTextureCoordinate;
+					faceTextureCoordinateIds[3 * faceId + 1] = previousTextureCoordinate;
+					faceTextureCoordinateIds[3 * faceId + 2] = t;
+					faceId++;
+				}
+
+				previousVertex = v;
+				previousTextureCoordinate = t;
+				numberOfCorners++;
+			}
+		}
+
+		p = lineEnd + 1;
+	}
+}
+
+//==============================================================================================//
+
+/*
+Reads the diffuse texture map (map_Kd) of a material library, the last one wins
+*/
+static std::string loadTextureMapPath(const std::string& materialLibraryPath, const std::string& folderPath)
+{
+	std::ifstream materialFile(materialLibraryPath);
+	if (!materialFile.is_open())
+	{
+		std::cout << "Could not open material library " << materialLibraryPath << std::endl;
+		return "";
+	}
+
+	std::string textureMapPath;
+	std::string line;
+	while (std::getline(materialFile, line))
+	{
+		std::istringstream tokens(line);
+		std::string keyword, textureMapName;
+		if ((tokens >> keyword) && keyword == "map_Kd")
+		{
+			//the file name is the last token, options may come before it
+			while (tokens >> textureMapName)
+				textureMapPath = folderPath + textureMapName;
+		}
+	}
+
+	return textureMapPath;
+}
+
+//==============================================================================================//
+
+bool loadOBJ(const std::string& filename, OBJMesh& mesh)
+{
+	ThreadPool& threadPool = ThreadPool::getInstance();
+
+	MemoryMappedFile file;
+	if (!file.open(filename))
+	{
+		std::cout << "Could not open OBJ file " << filename << std::endl;
+		return false;
+	}
+
+	const char* data = file.getData();
+	size_t size = file.getSize();
+
+	//split the file into chunks of whole lines
+	int numberOfChunks = (int)std::max((size_t)1, std::min((size_t)threadPool.getNumberOfThreads() * 4, (size + OBJ_BYTES_PER_CHUNK - 1) / OBJ_BYTES_PER_CHUNK));
+	std::vector<OBJChunk> chunks(numberOfChunks);
+
+	const char* chunkBegin = data;
+	for (int c = 0; c < numberOfChunks; c++)
+	{
+		const char* chunkEnd = data + size;
+		if (c + 1 < numberOfChunks)
+		{
+			chunkEnd = std::max(chunkBegin, data + size * (c + 1) / numberOfChunks);
+			chunkEnd = std::min(data + size, std::find(chunkEnd, data + size, '\n') + 1);
+		}
+
+		chunks[c].begin = chunkBegin;
+		chunks[c].end = chunkEnd;
+		chunks[c].numberOfVertices = 0;
+		chunks[c].numberOfTextureCoordinates = 0;
+		chunks[c].numberOfFaces = 0;
+		chunkBegin = chunkEnd;
+	}
+
+	threadPool.parallelFor(numberOfChunks, [&](int c)
+	{
+		countChunk(chunks[c]);
+	});
+
+	//element offsets of the chunks
+	int numberOfTextureCoordinates = 0;
+	std::string materialLibrary;
+
+	mesh.numberOfVertices = 0;
+	mesh.numberOfFaces = 0;
+
+	for (int c = 0; c < numberOfChunks; c++)
+	{
+		chunks[c].vertexOffset = mesh.numberOfVertices;
+		chunks[c].textureCoordinateOffset = numberOfTextureCoordinates;
+		chunks[c].faceOffset = mesh.numberOfFaces;
+
+		mesh.numberOfVertices += chunks[c].numberOfVertices;
+		numberOfTextureCoordinates += chunks[c].numberOfTextureCoordinates;
+		mesh.numberOfFaces += chunks[c].numberOfFaces;
+
+		if (!chunks[c].materialLibrary.empty())
+			materialLibrary = chunks[c].materialLibrary;
+	}
+
+	//parse
+	std::vector<float> textureCoordinatePool(2 * numberOfTextureCoordinates);
+	std::vector<int> faceTextureCoordinateIds(3 * mesh.numberOfFaces);
+
+	mesh.vertexCoordinates.resize(3 * mesh.numberOfVertices);
+	mesh.vertexColors.resize(3 * mesh.numberOfVertices);
+	mesh.faces.resize(3 * mesh.numberOfFaces);
+
+	threadPool.parallelFor(numberOfChunks, [&](int c)
+	{
+		parseChunk(chunks[c], mesh, textureCoordinatePool, faceTextureCoordinateIds);
+	});
+
+	for (int c = 0; c < numberOfChunks; c++)
+	{
+		if (!chunks[c].error.empty())
+		{
+			std::cout << "Could not parse OBJ file " << filename << ": " << chunks[c].error << std::endl;
+			return false;
+		}
+	}
+
+	//per face texture coordinates and range check of the ids
+	mesh.textureCoordinates.resize(6 * mesh.numberOfFaces);
+	std::vector<char> chunkValid(numberOfChunks, 1);
+
+	threadPool.parallelFor(numberOfChunks, [&](int c)
+	{
+		for (int i = 3 * chunks[c].faceOffset; i < 3 * (chunks[c].faceOffset + chunks[c].numberOfFaces); i++)
+		{
+			int v = mesh.faces[i];
+			int t = faceTextureCoordinateIds[i];
+
+			if (v < 0 || v >= mesh.numberOfVertices || t >= numberOfTextureCoordinates)
+				chunkValid[c] = 0;
+
+			mesh.textureCoordinates[2 * i + 0] = t >= 0 && t < numberOfTextureCoordinates ? textureCoordinatePool[2 * t + 0] : 0.f;
+			mesh.textureCoordinates[2 * i + 1] = t >= 0 && t < numberOfTextureCoordinates ? textureCoordinatePool[2 * t + 1] : 0.f;
+		}
+	});
+
+	if (std::find(chunkValid.begin(), chunkValid.end(), 0) != chunkValid.end())
+	{
+		std::cout << "Could not parse OBJ file " << filename << ": face references a missing vertex or texture coordinate" << std::endl;
+		return false;
+	}
+
+	//sparse adjacency
+	std::vector<int> vertexFaces, vertexFacesId;
+	computeVertexFaces(mesh.numberOfVertices, mesh.faces, vertexFaces, vertexFacesId);
+	computeVertexNeighbours(mesh.numberOfVertices, mesh.faces, vertexFaces, vertexFacesId, mesh.vertexNeighbours, mesh.vertexNeighboursId);
+
+	//material library, relative to the obj file
+	std::string folderPath = filename.substr(0, filename.find_last_of("/\\") + 1);
+
+	mesh.textureMapPath.clear();
+	if (!materialLibrary.empty())
+	{
+		if (materialLibrary.compare(0, 2, "./") == 0 || materialLibrary.compare(0, 2, ".\\") == 0)
+			materialLibrary = materialLibrary.substr(2);
+		mesh.textureMapPath = loadTextureMapPath(folderPath + materialLibrary, folderPath);
+	}
+
+	return true;
+}
+
+//==============================================================================================//
@@ -0,0 +1,45 @@
+//==============================================================================================//
+// Classname:
+//      MeshLoader
+//
+//==============================================================================================//
+// Description:
+//      Native OBJ / MTL loader. The OBJ file is memory mapped and parsed in parallel chunks
+//		of whole lines. The output is directly in the layout of CUDABasedRasterization.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include <string>
+
+//==============================================================================================//
+
+struct OBJMesh
+{
+	int					numberOfVertices;
+	int					numberOfFaces;
+
+	std::vector<float>	vertexCoordinates;						//3 floats per vertex
+	std::vector<float>	vertexColors;							//3 floats per vertex ("v x y z r g b"), white if the file has no colors
+	std::vector<int>	faces;									//3 vertex ids per face, polygons are triangulated as fans
+	std::vector<float>	textureCoordinates;						//3 x (u, v) per face, zero for corners without texture coordinate
+
+	//vertex to vertex adjacency in CSR layout (see MeshAdjacency)
+	std::vector<int>	vertexNeighbours;
+	std::vector<int>	vertexNeighboursId;
+
+	std::string			textureMapPath;							//map_Kd of the material library, empty if there is none
+};
+
+//==============================================================================================//
+
+/*
+Returns false if the file cannot be opened or is malformed
+*/
+bool loadOBJ(const std::string& filename, OBJMesh& mesh);
+
+//==============================================================================================//
@@ -0,0 +1,231 @@
+//==============================================================================================//
+
+#include "MeshReordering.h"
+
+//==============================================================================================//
+
+/*
+Returns the next vertex with remaining faces from the dead end stack or, if there is none, from the input order
+*/
+static int skipDeadEnd(const std::vector<int>& liveFaces, std::vector<int>& deadEndStack, int& cursor, int numberOfVertices)
+{
+	while (!deadEndStack.empty())
+	{
+		int vertex = deadEndStack.back();
+		deadEndStack.pop_back();
+
+		if (liveFaces[vertex] > 0)
+			return vertex;
+	}
+
+	while (cursor < numberOfVertices)
+	{
+		if (liveFaces[cursor] > 0)
+			return cursor;
+
+		cursor++;
+	}
+
+	return -1;
+}
+
+//==============================================================================================//
+
+void computeMeshReordering(int numberOfVertices, const std::vector<int>& faces, const std::vector<int>& vertexFaces, const std::vector<int>& vertexFacesId, std::vector<int>& faceOrder, std::vector<int>& vertexOrder)
+{
+	int F = faces.size() / 3;
+	int N = numberOfVertices;
+
+	//number of not yet emitted faces per vertex
+	std::vector<int> liveFaces(N);
+	for (int v = 0; v < N; v++)
+	{
+		liveFaces[v] = vertexFacesId[2 * v + 1];
+	}
+
+	std::vector<int>  cacheTime(N, 0);
+	std::vector<bool> emitted(F, false);
+	std::vector<int>  deadEndStack;
+	std::vector<int>  candidates;
+
+	faceOrder.clear();
+	faceOrder.reserve(F);
+
+	int time	= MESH_REORDERING_CACHE_SIZE + 1;
+	int cursor	= 0;
+	int fanning = skipDeadEnd(liveFaces, deadEndStack, cursor, N);
+
+	while (fanning >= 0)
+	{
+		candidates.clear();
+
+		//emit all remaining faces around the fanning vertex
+		for (int i = vertexFacesId[2 * fanning]; i < vertexFacesId[2 * fanning] + vertexFacesId[2 * fanning + 1]; i++)
+		{
+			int f = vertexFaces[i];
+
+			if (emitted[f])
+				continue;
+
+			emitted[f] = true;
+			faceOrder.push_back(f);
+
+			for (int k = 0; k < 3; k++)
+			{
+				int v = faces[3 * f + k];
+
+				//degenerated faces list a vertex only once in the adjacency
+				if ((k > 0 && v == faces[3 * f]) || (k > 1 && v == faces[3 * f + 1]))
+					continue;
+
+				deadEndStack.push_back(v);
+				candidates.push_back(v);
+				liveFaces[v]--;
+
+				if (time - cacheTime[v] > MESH_REORDERING_CACHE_SIZE)
+				{
+					cacheTime[v] = time;
+					time++;
+				}
+			}
+		}
+
+		//continue with the candidate which is most likely still in the cache after its remaining faces are emitted
+		int next = -1;
+		int bestPriority = -1;
+
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			int v = candidates[c];
+
+			if (liveFaces[v] <= 0)
+				continue;
+
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * liveFaces[v] <= MESH_REORDERING_CACHE_SIZE)
+				priority = time - cacheTime[v];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		if (next == -1)
+			next = skipDeadEnd(liveFaces, deadEndStack, cursor, N);
+
+		fanning = next;
+	}
+
+	//faces which are not part of the adjacency (invalid vertex ids) keep their relative order at the end
+	for (int f = 0; f < F; f++)
+	{
+		if (!emitted[f])
+			faceOrder.push_back(f);
+	}
+
+	//vertices in the order of their first use
+	std::vector<bool> used(N, false);
+	vertexOrder.clear();
+	vertexOrder.reserve(N);
+
+	for (int i = 0; i < F; i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			int v = faces[3 * faceOrder[i] + k];
+
+			if (v >= 0 && v < N && !used[v])
+			{
+				used[v] = true;
+				vertexOrder.push_back(v);
+			}
+		}
+	}
+
+	for (int v = 0; v < N; v++)
+	{
+		if (!used[v])
+			vertexOrder.push_back(v);
+	}
+}
+
+//==============================================================================================//
+
+void reorderFaces(const std::vector<int>& faceOrder, const std::vector<int>& vertexOrder, std::vector<int>& faces, std::vector<float>& textureCoordinates)
+{
+	int F = faceOrder.size();
+	std::vector<int> reorderedVertexIds = invertOrder(vertexOrder);
+
+	std::vector<int> reorderedFaces(3 * F);
+	for (int f = 0; f < F; f++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			reorderedFaces[3 * f + k] = reorderedVertexIds[faces[3 * faceOrder[f] + k]];
+		}
+	}
+	faces.swap(reorderedFaces);
+
+	//texture coordinates are only given if there are 3 x 2 per face
+	if (textureCoordinates.size() == 6 * (size_t)F)
+	{
+		std::vector<float> reorderedTextureCoordinates(6 * F);
+		for (int f = 0; f < F; f++)
+		{
+			for (int k = 0; k < 6; k++)
+			{
+				reorderedTextureCoordinates[6 * f + k] = textureCoordinates[6 * faceOrder[f] + k];
+			}
+		}
+		textureCoordinates.swap(reorderedTextureCoordinates);
+	}
+}
+
+//==============================================================================================//
+
+void reorderVertexFaces(const std::vector<int>& faceOrder, const std::vector<int>& vertexOrder, std::vector<int>& vertexFaces, std::vector<int>& vertexFacesId)
+{
+	int N = vertexOrder.size();
+	std::vector<int> reorderedFaceIds = invertOrder(faceOrder);
+
+	std::vector<int> reorderedVertexFaces(vertexFaces.size());
+	std::vector<int> reorderedVertexFacesId(2 * N);
+
+	int offset = 0;
+	for (int v = 0; v < N; v++)
+	{
+		int start = vertexFacesId[2 * vertexOrder[v] + 0];
+		int count = vertexFacesId[2 * vertexOrder[v] + 1];
+
+		reorderedVertexFacesId[2 * v + 0] = offset;
+		reorderedVertexFacesId[2 * v + 1] = count;
+
+		for (int i = 0; i < count; i++)
+		{
+			reorderedVertexFaces[offset + i] = reorderedFaceIds[vertexFaces[start + i]];
+		}
+
+		offset += count;
+	}
+
+	vertexFaces.swap(reorderedVertexFaces);
+	vertexFacesId.swap(reorderedVertexFacesId);
+}
+
+//==============================================================================================//
+
+std::vector<int> invertOrder(const std::vector<int>& order)
+{
+	std::vector<int> inverse(order.size());
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		inverse[order[i]] = i;
+	}
+
+	return inverse;
+}
+
+//==============================================================================================//
@@ -0,0 +1,60 @@
+//==============================================================================================//
+
+#include <cuda_runtime.h> 
+#include "../Utils/cudaUtil.h"
+#include "CUDABasedRasterizationInput.h"
+#include "MeshReordering.h"
+
+//==============================================================================================//
+//Vertex id remapping
+//==============================================================================================//
+
+/*
+Copies per vertex data from the original into the reordered vertex ids
+*/
+__global__ void gatherReorderedVerticesDevice(const float3* d_src, float3* d_dst, const int* d_originalVertexIds, int N, int numberOfCopies)
+{
+	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+	if (idx < numberOfCopies * N)
+	{
+		int copy	= idx / N;
+		int idv		= idx % N;
+
+		d_dst[idx] = d_src[copy * N + d_originalVertexIds[idv]];
+	}
+}
+
+//==============================================================================================//
+
+/*
+Copies per vertex data from the reordered back into the original vertex ids
+*/
+__global__ void scatterReorderedVerticesDevice(const float3* d_src, float3* d_dst, const int* d_originalVertexIds, int N, int numberOfCopies)
+{
+	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+	if (idx < numberOfCopies * N)
+	{
+		int copy	= idx / N;
+		int idv		= idx % N;
+
+		d_dst[copy * N + d_originalVertexIds[idv]] = d_src[idx];
+	}
+}
+
+//==============================================================================================//
+
+extern "C" void gatherReorderedVerticesGPU(const float3* d_src, float3* d_dst, const int* d_originalVertexIds, int N, int numberOfCopies, cudaStream_t stream)
+{
+	gatherReorderedVerticesDevice	<< <(N*numberOfCopies + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (d_src, d_dst, d_originalVertexIds, N, numberOfCopies);
+}
+
+//==============================================================================================//
+
+extern "C" void scatterReorderedVerticesGPU(const float3* d_src, float3* d_dst, const int* d_originalVertexIds, int N, int numberOfCopies, cudaStream_t stream)
+{
+	scatterReorderedVerticesDevice	<< <(N*numberOfCopies + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (d_src, d_dst, d_originalVertexIds, N, numberOfCopies);
+}
+
+//==============================================================================================//
@@ -0,0 +1,68 @@
+//==============================================================================================//
+// Classname:
+//      MeshReordering
+//
+//==============================================================================================//
+// Description:
+//      Computes a locality optimized order of the faces and vertices of a mesh. Faces are
+//		sorted with the linear time vertex cache optimization "Tipsify" (Sander et al. 2007)
+//		and vertices are renumbered in the order of their first use, so neighbouring threads
+//		of the face kernels gather neighbouring vertices.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include <stddef.h>
+#include <cuda_runtime.h>
+
+//==============================================================================================//
+
+//simulated vertex cache size used by the face ordering
+#define MESH_REORDERING_CACHE_SIZE 16
+
+//==============================================================================================//
+
+/*
+vertexFaces / vertexFacesId	: adjacency of the original mesh (see MeshAdjacency)
+faceOrder					: original id of every reordered face
+vertexOrder					: original id of every reordered vertex, unreferenced vertices are kept at the end
+*/
+void computeMeshReordering(int numberOfVertices, const std::vector<int>& faces, const std::vector<int>& vertexFaces, const std::vector<int>& vertexFacesId, std::vector<int>& faceOrder, std::vector<int>& vertexOrder);
+
+//==============================================================================================//
+
+/*
+Renumbers the faces (3 vertex ids per face) and the texture coordinates (3 x 2 per face) into the reordered ids
+*/
+void reorderFaces(const std::vector<int>& faceOrder, const std::vector<int>& vertexOrder, std::vector<int>& faces, std::vector<float>& textureCoordinates);
+
+//==============================================================================================//
+
+/*
+Renumbers the vertex to face adjacency into the reordered ids.
+Within every vertex the adjacent faces keep their original order, so sums over them do not change.
+*/
+void reorderVertexFaces(const std::vector<int>& faceOrder, const std::vector<int>& vertexOrder, std::vector<int>& vertexFaces, std::vector<int>& vertexFacesId);
+
+//==============================================================================================//
+
+/*
+Returns the inverse of a permutation, i.e. the reordered id for every original id
+*/
+std::vector<int> invertOrder(const std::vector<int>& order);
+
+//==============================================================================================//
+
+/*
+Device remapping of per vertex data (numberOfCopies consecutive blocks of N vertices, e.g. one per camera), launched on stream
+gather	: d_dst[reordered id] = d_src[original id]
+scatter	: d_dst[original id] = d_src[reordered id]
+*/
+extern "C" void gatherReorderedVerticesGPU(const float3* d_src, float3* d_dst, const int* d_originalVertexIds, int N, int numberOfCopies, cudaStream_t stream);
+extern "C" void scatterReorderedVerticesGPU(const float3* d_src, float3* d_dst, const int* d_originalVertexIds, int N, int numberOfCopies, cudaStream_t stream);
+
+//==============================================================================================//
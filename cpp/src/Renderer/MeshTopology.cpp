@@ -0,0 +1,275 @@
+//==============================================================================================//
+
+#include "MeshTopology.h"
+
+//==============================================================================================//
+
+std::mutex MeshTopology::registryMutex;
+std::multimap<MeshTopology::RegistryKey, std::weak_ptr<MeshTopology>> MeshTopology::registry;
+
+//==============================================================================================//
+
+uint64_t MeshTopology::hashMesh(const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices, bool reorder)
+{
+	//64 bit FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+
+	auto hashBytes = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	};
+
+	uint64_t numberOfFaceIds			= faces.size();
+	uint64_t numberOfTextureCoordinates = textureCoordinates.size();
+
+	hashBytes(&numberOfVertices,			sizeof(int));
+	hashBytes(&numberOfFaceIds,				sizeof(uint64_t));
+	hashBytes(&numberOfTextureCoordinates,	sizeof(uint64_t));
+	hashBytes(faces.data(),					sizeof(int)   * faces.size());
+	hashBytes(textureCoordinates.data(),	sizeof(float) * textureCoordinates.size());
+
+	//reordered meshes have different artifacts, the hash of the original order stays the same
+	if (reorder)
+	{
+		char reorderFlag = 1;
+		hashBytes(&reorderFlag, sizeof(char));
+	}
+
+	return hash;
+}
+
+//==============================================================================================//
+
+std::shared_ptr<MeshTopology> MeshTopology::acquire(const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices, bool reorder, const std::string& cacheDirectory)
+{
+	RegistryKey key;
+	key.hash = hashMesh(faces, textureCoordinates, numberOfVertices, reorder);
+	cutilSafeCall(cudaGetDevice(&key.device));
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+
+	//look for a living topology of the same mesh and drop expired entries on the way
+	auto range = registry.equal_range(key);
+	for (auto it = range.first; it != range.second;)
+	{
+		std::shared_ptr<MeshTopology> topology = it->second.lock();
+
+		if (!topology)
+		{
+			it = registry.erase(it);
+		}
+		else if (topology->isSameMesh(faces, textureCoordinates, numberOfVertices, reorder))
+		{
+			return topology;
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	std::shared_ptr<MeshTopology> topology = std::make_shared<MeshTopology>(faces, textureCoordinates, numberOfVertices, reorder, key.hash, cacheDirectory);
+	registry.insert(std::make_pair(key, std::weak_ptr<MeshTopology>(topology)));
+	return topology;
+}
+
+//==============================================================================================//
+
+MeshTopology::MeshTopology(const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices, bool reorder, uint64_t meshHash, const std::string& cacheDirectory)
+	:
+	faces(faces),
+	textureCoordinates(textureCoordinates),
+	cache(cacheDirectory, meshHash, this->faces, this->textureCoordinates, numberOfVertices),
+	F(0),
+	N(numberOfVertices),
+	reordered(false),
+	d_facesVertex(NULL),
+	d_textureCoordinates(NULL),
+	d_vertexFaces(NULL),
+	d_vertexFacesId(NULL),
+	d_originalFaceIds(NULL),
+	d_reorderedFaceIds(NULL),
+	d_originalVertexIds(NULL),
+	numberOfMeshlets(0),
+	d_meshletFaces(NULL),
+	d_meshlets(NULL)
+{
+	//faces and texture coordinates in the order used by the kernels
+	std::vector<int> kernelFaces = faces;
+	std::vector<float> kernelTextureCoordinates = textureCoordinates;
+
+	//faces
+	if (faces.size() % 3 == 0)
+	{
+		F = (faces.size() / 3);
+		reordered = reorder && F > 0;
+
+		// Get the vertexFaces, vertexFacesId and the optional reordering
+		MemoryMappedFile cacheFile;
+		const int* cachedVertexFaces = NULL;
+		const int* cachedVertexFacesId = NULL;
+		const int* cachedFaceOrder = NULL;
+		const int* cachedVertexOrder = NULL;
+		size_t numberOfVertexFaces = 0;
+
+		std::vector<int> vertexFaces, vertexFacesId, faceOrder, vertexOrder;
+
+		if (cache.loadVertexFaces(cacheFile, cachedVertexFaces, numberOfVertexFaces, cachedVertexFacesId, cachedFaceOrder, cachedVertexOrder) && (!reordered || cachedFaceOrder != NULL))
+		{
+			if (reordered)
+			{
+				faceOrder.assign(cachedFaceOrder, cachedFaceOrder + F);
+				vertexOrder.assign(cachedVertexOrder, cachedVertexOrder + N);
+			}
+		}
+		else
+		{
+			cacheFile.close();
+			cachedVertexFaces = NULL;
+
+			computeVertexFaces(numberOfVertices, faces, vertexFaces, vertexFacesId);
+
+			if (reordered)
+			{
+				computeMeshReordering(numberOfVertices, faces, vertexFaces, vertexFacesId, faceOrder, vertexOrder);
+				reorderVertexFaces(faceOrder, vertexOrder, vertexFaces, vertexFacesId);
+			}
+
+			cache.storeVertexFaces(vertexFaces, vertexFacesId, faceOrder, vertexOrder);
+
+			cachedVertexFaces	= vertexFaces.data();
+			cachedVertexFacesId = vertexFacesId.data();
+			numberOfVertexFaces = vertexFaces.size();
+		}
+
+		//upload straight from the mapping or the computed adjacency
+		cutilSafeCall(cudaMalloc(&d_vertexFaces, sizeof(int) * numberOfVertexFaces));
+		cutilSafeCall(cudaMemcpy(d_vertexFaces, cachedVertexFaces, sizeof(int)*numberOfVertexFaces, cudaMemcpyHostToDevice));
+		cutilSafeCall(cudaMalloc(&d_vertexFacesId, sizeof(int2) * numberOfVertices));
+		cutilSafeCall(cudaMemcpy(d_vertexFacesId, cachedVertexFacesId, sizeof(int2)*numberOfVertices, cudaMemcpyHostToDevice));
+
+		//id maps between the original and the reordered mesh
+		if (reordered)
+		{
+			reorderFaces(faceOrder, vertexOrder, kernelFaces, kernelTextureCoordinates);
+			reorderedFaceIds = invertOrder(faceOrder);
+
+			cutilSafeCall(cudaMalloc(&d_originalFaceIds, sizeof(int) * F));
+			cutilSafeCall(cudaMemcpy(d_originalFaceIds, faceOrder.data(), sizeof(int)*F, cudaMemcpyHostToDevice));
+			cutilSafeCall(cudaMalloc(&d_reorderedFaceIds, sizeof(int) * F));
+			cutilSafeCall(cudaMemcpy(d_reorderedFaceIds, reorderedFaceIds.data(), sizeof(int)*F, cudaMemcpyHostToDevice));
+			cutilSafeCall(cudaMalloc(&d_originalVertexIds, sizeof(int) * N));
+			cutilSafeCall(cudaMemcpy(d_originalVertexIds, vertexOrder.data(), sizeof(int)*N, cudaMemcpyHostToDevice));
+		}
+
+		cutilSafeCall(cudaMalloc(&d_facesVertex, sizeof(int3) * F));
+		cutilSafeCall(cudaMemcpy(d_facesVertex, kernelFaces.data(), sizeof(int3)*F, cudaMemcpyHostToDevice));
+
+		//meshlets of the faces in kernel order
+		std::vector<int> meshletFaces, meshlets;
+		buildMeshlets(numberOfVertices, F, kernelFaces.data(), cachedVertexFaces, cachedVertexFacesId, meshletFaces, meshlets);
+		numberOfMeshlets = meshlets.size() / 2;
+
+		cutilSafeCall(cudaMalloc(&d_meshletFaces, sizeof(int) * F));
+		cutilSafeCall(cudaMemcpy(d_meshletFaces, meshletFaces.data(), sizeof(int)*F, cudaMemcpyHostToDevice));
+		cutilSafeCall(cudaMalloc(&d_meshlets, sizeof(int2) * numberOfMeshlets));
+		cutilSafeCall(cudaMemcpy(d_meshlets, meshlets.data(), sizeof(int2)*numberOfMeshlets, cudaMemcpyHostToDevice));
+	}
+	else
+	{
+		std::cout << "No triangular faces!" << std::endl;
+	}
+
+	//texture coordinates
+	if (textureCoordinates.size() % 6 == 0)
+	{
+		cutilSafeCall(cudaMalloc(&d_textureCoordinates, sizeof(float) * 6 * F));
+		cutilSafeCall(cudaMemcpy(d_textureCoordinates, kernelTextureCoordinates.data(), sizeof(float)*F * 6, cudaMemcpyHostToDevice));
+	}
+	else
+	{
+		std::cout << "Texture coordinates have wrong dimensionality!" << std::endl;
+	}
+}
+
+//==============================================================================================//
+
+MeshTopology::~MeshTopology()
+{
+	cutilSafeCall(cudaFree(d_facesVertex));
+	cutilSafeCall(cudaFree(d_textureCoordinates));
+	cutilSafeCall(cudaFree(d_vertexFaces));
+	cutilSafeCall(cudaFree(d_vertexFacesId));
+	cutilSafeCall(cudaFree(d_originalFaceIds));
+	cutilSafeCall(cudaFree(d_reorderedFaceIds));
+	cutilSafeCall(cudaFree(d_originalVertexIds));
+	cutilSafeCall(cudaFree(d_meshletFaces));
+	cutilSafeCall(cudaFree(d_meshlets));
+
+	for (auto it = d_textureMapIds.begin(); it != d_textureMapIds.end(); it++)
+	{
+		cutilSafeCall(cudaFree(it->second));
+	}
+}
+
+//==============================================================================================//
+
+bool MeshTopology::isSameMesh(const std::vector<int>& otherFaces, const std::vector<float>& otherTextureCoordinates, int otherNumberOfVertices, bool otherReorder)
+{
+	return N == otherNumberOfVertices && reordered == (otherReorder && F > 0) && faces == otherFaces && textureCoordinates == otherTextureCoordinates;
+}
+
+//==============================================================================================//
+
+TextureAtlasTexel* MeshTopology::get_D_textureMapIds(int texWidth, int texHeight, cudaStream_t stream)
+{
+	//the atlas depends on the texture resolution which is only known in the forward pass
+	//hence, it is built once per resolution and kept until the topology is released
+	std::lock_guard<std::mutex> lock(textureMapMutex);
+
+	std::pair<int, int> resolution(texWidth, texHeight);
+	auto it = d_textureMapIds.find(resolution);
+
+	if (it != d_textureMapIds.end())
+	{
+		return it->second;
+	}
+
+	TextureAtlasTexel* d_textureMap = NULL;
+	cutilSafeCall(cudaMalloc(&d_textureMap, sizeof(TextureAtlasTexel) * texHeight * texWidth));
+
+	//upload straight from the mapping of the on-disk cache
+	MemoryMappedFile cacheFile;
+	const TextureAtlasTexel* cachedTextureMap = NULL;
+
+	if (cache.loadTextureAtlas(cacheFile, texWidth, texHeight, cachedTextureMap))
+	{
+		//the mapping is closed on return and the atlas is shared with renderers on other streams, so wait for the upload
+		cutilSafeCall(cudaMemcpyAsync(d_textureMap, cachedTextureMap, sizeof(TextureAtlasTexel) * texHeight * texWidth, cudaMemcpyHostToDevice, stream));
+		cutilSafeCall(cudaStreamSynchronize(stream));
+
+		d_textureMapIds[resolution] = d_textureMap;
+		return d_textureMap;
+	}
+
+	//rasterize the uv triangles
+	std::vector<TextureAtlasTexel> h_textureMapIds(texHeight * texWidth);
+
+	//the atlas is built in the original face order, so overlaps are resolved as without reordering
+	computeTextureMapFaceIds(textureCoordinates, F, texWidth, texHeight, h_textureMapIds.data(), reordered ? reorderedFaceIds.data() : NULL);
+
+	cutilSafeCall(cudaMemcpyAsync(d_textureMap, h_textureMapIds.data(), sizeof(TextureAtlasTexel) * texHeight * texWidth, cudaMemcpyHostToDevice, stream));
+	cutilSafeCall(cudaStreamSynchronize(stream));
+
+	cache.storeTextureAtlas(texWidth, texHeight, h_textureMapIds.data());
+
+	d_textureMapIds[resolution] = d_textureMap;
+	return d_textureMap;
+}
+
+//==============================================================================================//
@@ -0,0 +1,128 @@
+//==============================================================================================//
+// Classname:
+//      MeshTopology
+//
+//==============================================================================================//
+// Description:
+//      Immutable device copy of the mesh topology (faces, texture coordinates, vertex faces
+//		and the texture atlas of every requested texture resolution). Instances are shared through a process wide registry keyed by a
+//		hash of the faces / texture_coordinates attributes and the device, so all forward and
+//		gradient kernels of the same mesh use one set of buffers. The buffers are released
+//		once the last user is destroyed. Vertex faces and texture atlases are optionally
+//		loaded from / stored to an on-disk cache (see MeshTopologyCache).
+//		Optionally, faces and vertices are reordered for memory locality (see MeshReordering).
+//		All device buffers are then in the reordered ids and the id maps are used to convert
+//		the inputs and outputs of the kernels from / to the original ids.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <iostream>
+#include <cuda_runtime.h>
+#include "cutil.h"
+#include "cutil_inline_runtime.h"
+#include "cutil_math.h"
+#include "MeshAdjacency.h"
+#include "TextureAtlas.h"
+#include "MeshTopologyCache.h"
+#include "MeshReordering.h"
+#include "Meshlets.h"
+
+//==============================================================================================//
+
+class MeshTopology
+{
+	//functions
+
+	public:
+
+		//returns the topology for the given mesh on the current device and creates it if needed
+		//an empty cacheDirectory disables the on-disk cache
+		static std::shared_ptr<MeshTopology> acquire(const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices, bool reorder, const std::string& cacheDirectory);
+
+		static uint64_t hashMesh(const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices, bool reorder);
+
+		MeshTopology(const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices, bool reorder, uint64_t meshHash, const std::string& cacheDirectory);
+		~MeshTopology();
+
+		//packed per texel face id and barycentric coordinates, built on the first request of each texture resolution and uploaded on stream
+		TextureAtlasTexel*						get_D_textureMapIds(int texWidth, int texHeight, cudaStream_t stream);
+
+		//getter
+		inline int								getNumberOfFaces()							{ return F; };
+		inline int								getNumberOfVertices()						{ return N; };
+		inline int3*							get_D_facesVertex()							{ return d_facesVertex; };
+		inline float*							get_D_textureCoordinates()					{ return d_textureCoordinates; };
+		inline int*								get_D_vertexFaces()							{ return d_vertexFaces; };
+		inline int2*							get_D_vertexFacesId()						{ return d_vertexFacesId; };
+
+		//id maps of the reordered mesh, NULL if the mesh is not reordered
+		inline bool								isReordered()								{ return reordered; };
+		inline int*								get_D_originalFaceIds()						{ return d_originalFaceIds; };
+		inline int*								get_D_reorderedFaceIds()					{ return d_reorderedFaceIds; };
+		inline int*								get_D_originalVertexIds()					{ return d_originalVertexIds; };
+
+		//meshlets in the kernel face ids (see Meshlets)
+		inline int								getNumberOfMeshlets()						{ return numberOfMeshlets; };
+		inline int*								get_D_meshletFaces()						{ return d_meshletFaces; };
+		inline int2*							get_D_meshlets()							{ return d_meshlets; };
+
+	private:
+
+		bool									isSameMesh(const std::vector<int>& otherFaces, const std::vector<float>& otherTextureCoordinates, int otherNumberOfVertices, bool otherReorder);
+
+	//variables
+
+	private:
+
+		struct RegistryKey
+		{
+			uint64_t	hash;
+			int			device;
+
+			bool operator<(const RegistryKey& other) const { return hash < other.hash || (hash == other.hash && device < other.device); };
+		};
+
+		static std::mutex											registryMutex;
+		static std::multimap<RegistryKey, std::weak_ptr<MeshTopology>>	registry;
+
+		//host copies in the original order, used for the collision check and the texture atlas
+		std::vector<int>						faces;
+		std::vector<float>						textureCoordinates;
+
+		MeshTopologyCache						cache;
+
+		int										F;
+		int										N;
+
+		bool									reordered;
+		std::vector<int>						reorderedFaceIds;
+
+		//device memory
+		int3*									d_facesVertex;
+		float*									d_textureCoordinates;
+		int*									d_vertexFaces;
+		int2*									d_vertexFacesId;
+
+		int*									d_originalFaceIds;				//reordered face id -> original face id
+		int*									d_reorderedFaceIds;				//original face id -> reordered face id
+		int*									d_originalVertexIds;			//reordered vertex id -> original vertex id
+
+		int										numberOfMeshlets;
+		int*									d_meshletFaces;
+		int2*									d_meshlets;
+
+		//texture atlas per (texWidth, texHeight)
+		std::mutex													textureMapMutex;
+		std::map<std::pair<int, int>, TextureAtlasTexel*>			d_textureMapIds;
+};
+
+//==============================================================================================//
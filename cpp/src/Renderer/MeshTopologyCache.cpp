@@ -0,0 +1,344 @@
+//==============================================================================================//
+
+#include "MeshTopologyCache.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+
+//==============================================================================================//
+
+#define MESH_TOPOLOGY_CACHE_ALIGNMENT 64
+
+static const char meshTopologyCacheMagic[8] = { 'G', 'V', 'V', 'T', 'O', 'P', 'O', '\0' };
+
+//==============================================================================================//
+
+/*
+True if every id of ids lies in [0, size)
+*/
+static bool isInRange(const int* ids, size_t numberOfIds, int size)
+{
+	for (size_t i = 0; i < numberOfIds; i++)
+	{
+		if (ids[i] < 0 || ids[i] >= size)
+			return false;
+	}
+	return true;
+}
+
+//==============================================================================================//
+
+/*
+True if order holds every id of [0, size) exactly once
+*/
+static bool isPermutation(const int* order, int size)
+{
+	std::vector<char> used(size, 0);
+	for (int i = 0; i < size; i++)
+	{
+		if (order[i] < 0 || order[i] >= size || used[order[i]])
+			return false;
+		used[order[i]] = 1;
+	}
+	return true;
+}
+
+//==============================================================================================//
+
+MeshTopologyCache::MeshTopologyCache(const std::string& directory, uint64_t meshHash, const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices)
+	:
+	directory(directory),
+	meshHash(meshHash),
+	faces(faces),
+	textureCoordinates(textureCoordinates),
+	numberOfVertices(numberOfVertices)
+{
+}
+
+//==============================================================================================//
+
+std::string MeshTopologyCache::getPath(const std::string& artifact)
+{
+	std::stringstream path;
+	path << directory;
+
+	if (directory[directory.size() - 1] != '/' && directory[directory.size() - 1] != '\\')
+		path << "/";
+
+	path << std::hex << std::setw(16) << std::setfill('0') << meshHash << "_" << artifact << ".topology";
+	return path.str();
+}
+
+//==============================================================================================//
+
+bool MeshTopologyCache::openFile(MemoryMappedFile& file, const std::string& path)
+{
+	if (!file.open(path))
+	{
+		return false;
+	}
+
+	bool valid = file.getSize() >= sizeof(MeshTopologyCacheHeader);
+
+	if (valid)
+	{
+		const MeshTopologyCacheHeader* header = (const MeshTopologyCacheHeader*)file.getData();
+
+		valid = memcmp(header->magic, meshTopologyCacheMagic, sizeof(meshTopologyCacheMagic)) == 0
+			&& header->version == MESH_TOPOLOGY_CACHE_VERSION
+			&& header->meshHash == meshHash
+			&& header->numberOfVertices == numberOfVertices
+			&& sizeof(MeshTopologyCacheHeader) + header->numberOfSections * sizeof(MeshTopologyCacheSection) <= file.getSize();
+	}
+
+	//sections have to lie inside of the file
+	if (valid)
+	{
+		const MeshTopologyCacheHeader* header = (const MeshTopologyCacheHeader*)file.getData();
+		const MeshTopologyCacheSection* sections = (const MeshTopologyCacheSection*)(file.getData() + sizeof(MeshTopologyCacheHeader));
+
+		for (uint32_t s = 0; s < header->numberOfSections && valid; s++)
+		{
+			valid = sections[s].offset <= file.getSize() && sections[s].size <= file.getSize() - sections[s].offset;
+		}
+	}
+
+	//hash collisions are resolved by comparing the mesh itself
+	if (valid)
+	{
+		size_t facesSize = 0;
+		size_t textureCoordinatesSize = 0;
+		const void* cachedFaces					= getSection(file, FacesSection, 0, 0, facesSize);
+		const void* cachedTextureCoordinates	= getSection(file, TextureCoordinatesSection, 0, 0, textureCoordinatesSize);
+
+		valid = cachedFaces != NULL && cachedTextureCoordinates != NULL
+			&& facesSize == sizeof(int) * faces.size()
+			&& textureCoordinatesSize == sizeof(float) * textureCoordinates.size()
+			&& memcmp(cachedFaces, faces.data(), facesSize) == 0
+			&& memcmp(cachedTextureCoordinates, textureCoordinates.data(), textureCoordinatesSize) == 0;
+	}
+
+	if (!valid)
+	{
+		std::cout << "Ignore outdated or invalid topology cache file " << path << std::endl;
+		file.close();
+	}
+
+	return valid;
+}
+
+//==============================================================================================//
+
+const void* MeshTopologyCache::getSection(MemoryMappedFile& file, MeshTopologyCacheSectionType type, int width, int height, size_t& size)
+{
+	const MeshTopologyCacheHeader* header = (const MeshTopologyCacheHeader*)file.getData();
+	const MeshTopologyCacheSection* sections = (const MeshTopologyCacheSection*)(file.getData() + sizeof(MeshTopologyCacheHeader));
+
+	for (uint32_t s = 0; s < header->numberOfSections; s++)
+	{
+		if (sections[s].type == (uint32_t)type && sections[s].width == width && sections[s].height == height)
+		{
+			size = sections[s].size;
+			return file.getData() + sections[s].offset;
+		}
+	}
+
+	size = 0;
+	return NULL;
+}
+
+//==============================================================================================//
+
+void MeshTopologyCache::writeFile(const std::string& path, std::vector<SectionData> sections)
+{
+	SectionData facesSection				= { FacesSection,				0, 0, faces.data(),					sizeof(int)   * faces.size() };
+	SectionData textureCoordinatesSection	= { TextureCoordinatesSection,	0, 0, textureCoordinates.data(),	sizeof(float) * textureCoordinates.size() };
+	sections.insert(sections.begin(), textureCoordinatesSection);
+	sections.insert(sections.begin(), facesSection);
+
+	MeshTopologyCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, meshTopologyCacheMagic, sizeof(meshTopologyCacheMagic));
+	header.version			= MESH_TOPOLOGY_CACHE_VERSION;
+	header.numberOfSections = (uint32_t)sections.size();
+	header.meshHash			= meshHash;
+	header.numberOfVertices = numberOfVertices;
+
+	//section data starts aligned behind the section table
+	std::vector<MeshTopologyCacheSection> table(sections.size());
+	uint64_t offset = sizeof(MeshTopologyCacheHeader) + sizeof(MeshTopologyCacheSection) * sections.size();
+
+	for (size_t s = 0; s < sections.size(); s++)
+	{
+		offset = (offset + MESH_TOPOLOGY_CACHE_ALIGNMENT - 1) / MESH_TOPOLOGY_CACHE_ALIGNMENT * MESH_TOPOLOGY_CACHE_ALIGNMENT;
+
+		memset(&table[s], 0, sizeof(MeshTopologyCacheSection));
+		table[s].type	= sections[s].type;
+		table[s].width	= sections[s].width;
+		table[s].height = sections[s].height;
+		table[s].offset = offset;
+		table[s].size	= sections[s].size;
+
+		offset += sections[s].size;
+	}
+
+	//write to a temporary file which is renamed afterwards
+	std::stringstream temporaryPath;
+	temporaryPath << path << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << "_" << std::chrono::steady_clock::now().time_since_epoch().count() << ".tmp";
+
+	std::ofstream stream(temporaryPath.str().c_str(), std::ios::binary);
+	const char padding[MESH_TOPOLOGY_CACHE_ALIGNMENT] = { 0 };
+
+	stream.write((const char*)&header, sizeof(MeshTopologyCacheHeader));
+	stream.write((const char*)table.data(), sizeof(MeshTopologyCacheSection) * table.size());
+
+	uint64_t position = sizeof(MeshTopologyCacheHeader) + sizeof(MeshTopologyCacheSection) * table.size();
+	for (size_t s = 0; s < sections.size(); s++)
+	{
+		stream.write(padding, table[s].offset - position);
+		stream.write((const char*)sections[s].data, sections[s].size);
+		position = table[s].offset + table[s].size;
+	}
+
+	stream.close();
+
+	if (stream.fail())
+	{
+		std::cout << "Could not write topology cache file " << temporaryPath.str() << std::endl;
+		std::remove(temporaryPath.str().c_str());
+		return;
+	}
+
+	//fails on windows if another job stored the same file in the meantime, which is fine
+	if (std::rename(temporaryPath.str().c_str(), path.c_str()) != 0)
+	{
+		std::remove(temporaryPath.str().c_str());
+	}
+}
+
+//==============================================================================================//
+
+bool MeshTopologyCache::loadVertexFaces(MemoryMappedFile& file, const int*& vertexFaces, size_t& numberOfVertexFaces, const int*& vertexFacesId, const int*& faceOrder, const int*& vertexOrder)
+{
+	if (!isEnabled() || !openFile(file, getPath("vertexFaces")))
+	{
+		return false;
+	}
+
+	size_t vertexFacesSize = 0;
+	size_t vertexFacesIdSize = 0;
+	vertexFaces		= (const int*)getSection(file, VertexFacesSection, 0, 0, vertexFacesSize);
+	vertexFacesId	= (const int*)getSection(file, VertexFacesIdSection, 0, 0, vertexFacesIdSize);
+
+	int numberOfFaces = faces.size() / 3;
+	bool valid = vertexFaces != NULL && vertexFacesId != NULL
+		&& vertexFacesSize % sizeof(int) == 0
+		&& vertexFacesIdSize == sizeof(int) * 2 * numberOfVertices
+		&& isInRange(vertexFaces, vertexFacesSize / sizeof(int), numberOfFaces);
+
+	//the range of every vertex has to lie inside of vertexFaces
+	for (int v = 0; v < numberOfVertices && valid; v++)
+	{
+		int64_t start = vertexFacesId[2 * v + 0];
+		int64_t count = vertexFacesId[2 * v + 1];
+		valid = start >= 0 && count >= 0 && start + count <= (int64_t)(vertexFacesSize / sizeof(int));
+	}
+
+	if (!valid)
+	{
+		std::cout << "Ignore invalid vertex faces of topology cache file " << getPath("vertexFaces") << std::endl;
+		file.close();
+		return false;
+	}
+
+	size_t faceOrderSize = 0;
+	size_t vertexOrderSize = 0;
+	faceOrder	= (const int*)getSection(file, FaceOrderSection, 0, 0, faceOrderSize);
+	vertexOrder = (const int*)getSection(file, VertexOrderSection, 0, 0, vertexOrderSize);
+
+	//the orders are inverted and used as ids, so they have to be permutations of the faces and vertices
+	if (faceOrder == NULL || vertexOrder == NULL
+		|| faceOrderSize != sizeof(int) * numberOfFaces || vertexOrderSize != sizeof(int) * numberOfVertices
+		|| !isPermutation(faceOrder, numberOfFaces) || !isPermutation(vertexOrder, numberOfVertices))
+	{
+		faceOrder	= NULL;
+		vertexOrder = NULL;
+	}
+
+	numberOfVertexFaces = vertexFacesSize / sizeof(int);
+	return true;
+}
+
+//==============================================================================================//
+
+void MeshTopologyCache::storeVertexFaces(const std::vector<int>& vertexFaces, const std::vector<int>& vertexFacesId, const std::vector<int>& faceOrder, const std::vector<int>& vertexOrder)
+{
+	if (!isEnabled())
+	{
+		return;
+	}
+
+	std::vector<SectionData> sections(2);
+	sections[0] = { VertexFacesSection,		0, 0, vertexFaces.data(),	sizeof(int) * vertexFaces.size() };
+	sections[1] = { VertexFacesIdSection,	0, 0, vertexFacesId.data(), sizeof(int) * vertexFacesId.size() };
+
+	if (!faceOrder.empty() && !vertexOrder.empty())
+	{
+		sections.push_back({ FaceOrderSection,		0, 0, faceOrder.data(),		sizeof(int) * faceOrder.size() });
+		sections.push_back({ VertexOrderSection,	0, 0, vertexOrder.data(),	sizeof(int) * vertexOrder.size() });
+	}
+
+	writeFile(getPath("vertexFaces"), sections);
+}
+
+//==============================================================================================//
+
+bool MeshTopologyCache::loadTextureAtlas(MemoryMappedFile& file, int texWidth, int texHeight, const TextureAtlasTexel*& textureMap)
+{
+	if (!isEnabled() || !openFile(file, getPath("atlas" + std::to_string(texWidth) + "x" + std::to_string(texHeight))))
+	{
+		return false;
+	}
+
+	size_t textureMapSize = 0;
+	textureMap = (const TextureAtlasTexel*)getSection(file, TextureAtlasSection, texWidth, texHeight, textureMapSize);
+
+	bool valid = textureMap != NULL && textureMapSize == sizeof(TextureAtlasTexel) * texWidth * texHeight;
+
+	//texels are either empty or hold a face id of the mesh
+	int numberOfFaces = faces.size() / 3;
+	for (size_t t = 0; valid && t < (size_t)texWidth * texHeight; t++)
+	{
+		valid = textureMap[t].x == TEXTURE_ATLAS_EMPTY_TEXEL || (textureMap[t].x >= 0 && textureMap[t].x < numberOfFaces);
+	}
+
+	if (!valid)
+	{
+		file.close();
+		return false;
+	}
+
+	return true;
+}
+
+//==============================================================================================//
+
+void MeshTopologyCache::storeTextureAtlas(int texWidth, int texHeight, const TextureAtlasTexel* textureMap)
+{
+	if (!isEnabled())
+	{
+		return;
+	}
+
+	std::vector<SectionData> sections(1);
+	sections[0] = { TextureAtlasSection, texWidth, texHeight, textureMap, sizeof(TextureAtlasTexel) * texWidth * texHeight };
+
+	writeFile(getPath("atlas" + std::to_string(texWidth) + "x" + std::to_string(texHeight)), sections);
+}
+
+//==============================================================================================//
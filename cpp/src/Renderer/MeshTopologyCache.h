@@ -0,0 +1,115 @@
+//==============================================================================================//
+// Classname:
+//      MeshTopologyCache
+//
+//==============================================================================================//
+// Description:
+//      On-disk cache of the preprocessed mesh topology (vertex faces, the optional locality
+//		reordering and texture atlases).
+//		Every artifact is stored in a versioned binary container named after the mesh hash,
+//		which also holds the faces and texture coordinates it was built from. Containers are
+//		memory mapped on load and only used if version, hash and mesh match exactly and all ids
+//		of the sections lie inside of the mesh, otherwise the topology is rebuilt. Files
+//		are written to a temporary name and renamed, so concurrent jobs never see partial files.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "TextureAtlas.h"
+#include "../Utils/MemoryMappedFile.h"
+
+//==============================================================================================//
+
+//increase whenever the layout or the content of a section changes
+#define MESH_TOPOLOGY_CACHE_VERSION 1
+
+//==============================================================================================//
+
+enum MeshTopologyCacheSectionType
+{
+	FacesSection, TextureCoordinatesSection, VertexFacesSection, VertexFacesIdSection, TextureAtlasSection, FaceOrderSection, VertexOrderSection
+};
+
+//==============================================================================================//
+
+struct MeshTopologyCacheHeader
+{
+	char		magic[8];				//"GVVTOPO"
+	uint32_t	version;				//MESH_TOPOLOGY_CACHE_VERSION
+	uint32_t	numberOfSections;
+	uint64_t	meshHash;				//MeshTopology::hashMesh
+	int32_t		numberOfVertices;
+	int32_t		reserved;
+};
+
+//==============================================================================================//
+
+struct MeshTopologyCacheSection
+{
+	uint32_t	type;					//MeshTopologyCacheSectionType
+	int32_t		width;					//texture resolution of atlas sections
+	int32_t		height;
+	uint32_t	reserved;
+	uint64_t	offset;					//in bytes from the start of the file
+	uint64_t	size;					//in bytes
+};
+
+//==============================================================================================//
+
+class MeshTopologyCache
+{
+	//functions
+
+	public:
+
+		//an empty directory disables the cache
+		MeshTopologyCache(const std::string& directory, uint64_t meshHash, const std::vector<int>& faces, const std::vector<float>& textureCoordinates, int numberOfVertices);
+
+		inline bool		isEnabled()		{ return !directory.empty(); };
+
+		//the returned pointers point into file and stay valid as long as it is open
+		//faceOrder / vertexOrder are NULL (when loading) or empty (when storing) for meshes which are not reordered
+		bool			loadVertexFaces(MemoryMappedFile& file, const int*& vertexFaces, size_t& numberOfVertexFaces, const int*& vertexFacesId, const int*& faceOrder, const int*& vertexOrder);
+		void			storeVertexFaces(const std::vector<int>& vertexFaces, const std::vector<int>& vertexFacesId, const std::vector<int>& faceOrder, const std::vector<int>& vertexOrder);
+
+		bool			loadTextureAtlas(MemoryMappedFile& file, int texWidth, int texHeight, const TextureAtlasTexel*& textureMap);
+		void			storeTextureAtlas(int texWidth, int texHeight, const TextureAtlasTexel* textureMap);
+
+	private:
+
+		struct SectionData
+		{
+			MeshTopologyCacheSectionType	type;
+			int								width;
+			int								height;
+			const void*						data;
+			size_t							size;
+		};
+
+		std::string		getPath(const std::string& artifact);
+
+		//maps the file and checks version, hash and mesh
+		bool			openFile(MemoryMappedFile& file, const std::string& path);
+		const void*		getSection(MemoryMappedFile& file, MeshTopologyCacheSectionType type, int width, int height, size_t& size);
+
+		//faces and texture coordinates are added to every file
+		void			writeFile(const std::string& path, std::vector<SectionData> sections);
+
+	//variables
+
+	private:
+
+		std::string					directory;
+		uint64_t					meshHash;
+		const std::vector<int>&		faces;
+		const std::vector<float>&	textureCoordinates;
+		int							numberOfVertices;
+};
+
+//==============================================================================================//
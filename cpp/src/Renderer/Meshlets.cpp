@@ -0,0 +1,70 @@
+//==============================================================================================//
+
+#include "Meshlets.h"
+#include <algorithm>
+
+//==============================================================================================//
+
+/*
+Greedy breadth first growing over faces that share a vertex. Seeds are taken in face order, so for a
+locality ordered mesh (see MeshReordering) consecutive meshlets are also close to each other.
+*/
+void buildMeshlets(int numberOfVertices, int numberOfFaces, const int* faces, const int* vertexFaces, const int* vertexFacesId, std::vector<int>& meshletFaces, std::vector<int>& meshlets)
+{
+	meshletFaces.clear();
+	meshletFaces.reserve(numberOfFaces);
+	meshlets.clear();
+
+	//0: free, 1: queued for the current meshlet, 2: assigned
+	std::vector<char> faceState(numberOfFaces, 0);
+	std::vector<int> queue;
+	queue.reserve(4 * MESHLET_SIZE);
+
+	for (int seed = 0; seed < numberOfFaces; seed++)
+	{
+		if (faceState[seed] == 2)
+			continue;
+
+		int meshletStart = meshletFaces.size();
+
+		queue.clear();
+		queue.push_back(seed);
+		faceState[seed] = 1;
+
+		for (size_t q = 0; q < queue.size() && (int)meshletFaces.size() - meshletStart < MESHLET_SIZE; q++)
+		{
+			int f = queue[q];
+			faceState[f] = 2;
+			meshletFaces.push_back(f);
+
+			for (int k = 0; k < 3; k++)
+			{
+				int v = faces[3 * f + k];
+				if (v < 0 || v >= numberOfVertices)
+					continue;
+
+				for (int i = vertexFacesId[2 * v + 0]; i < vertexFacesId[2 * v + 0] + vertexFacesId[2 * v + 1]; i++)
+				{
+					int neighbour = vertexFaces[i];
+					if (faceState[neighbour] == 0)
+					{
+						faceState[neighbour] = 1;
+						queue.push_back(neighbour);
+					}
+				}
+			}
+		}
+
+		//release the faces which were queued but did not fit
+		for (size_t q = 0; q < queue.size(); q++)
+		{
+			if (faceState[queue[q]] == 1)
+				faceState[queue[q]] = 0;
+		}
+
+		meshlets.push_back(meshletStart);
+		meshlets.push_back(meshletFaces.size() - meshletStart);
+	}
+}
+
+//==============================================================================================//
@@ -0,0 +1,166 @@
+//==============================================================================================//
+// Classname:
+//      Meshlets
+//
+//==============================================================================================//
+// Description:
+//      Partitions the faces into meshlets of at most MESHLET_SIZE connected faces. Every frame
+//		the meshlets get a bounding sphere and a normal cone, which allow to reject whole
+//		meshlets per camera before rasterization. The bounds and the culling test are shared
+//		between host and device, so the culling can be validated on the CPU.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include <math.h>
+#include <cuda_runtime.h>
+#include "cutil_math.h"
+
+//==============================================================================================//
+
+//maximum number of faces per meshlet (a multiple of the warp size)
+#define MESHLET_SIZE 64
+
+//relative padding of the bounding sphere which covers the barycentric tolerance of the rasterizer
+#define MESHLET_SPHERE_PADDING 1.01f
+
+//pixels outside the image in which a meshlet is still considered visible
+#define MESHLET_FRUSTUM_MARGIN 1.f
+
+//cone cutoff of meshlets whose normals do not allow back-face rejection
+#define MESHLET_CONE_DISABLED 2.f
+
+//==============================================================================================//
+
+struct MeshletBounds
+{
+	float3	center;
+	float	radius;
+	float3	coneAxis;
+	float	coneCutoff;		//sine of the cone opening angle, MESHLET_CONE_DISABLED if the normals span a half space or more
+};
+
+//==============================================================================================//
+
+/*
+meshletFaces	: face ids grouped by meshlet, every face is in exactly one meshlet
+meshlets		: (index in meshletFaces, number of faces) for each meshlet
+*/
+void buildMeshlets(int numberOfVertices, int numberOfFaces, const int* faces, const int* vertexFaces, const int* vertexFacesId, std::vector<int>& meshletFaces, std::vector<int>& meshlets);
+
+//==============================================================================================//
+
+/*
+Bounding sphere (around the center of the bounding box) and normal cone of a meshlet for the current vertex positions
+*/
+inline __host__ __device__ MeshletBounds computeMeshletBounds(int2 meshlet, const int* meshletFaces, const int3* facesVertex, const float3* vertices)
+{
+	MeshletBounds bounds;
+
+	float3 minCorner = make_float3( 1e30f,  1e30f,  1e30f);
+	float3 maxCorner = make_float3(-1e30f, -1e30f, -1e30f);
+	float3 normalSum = make_float3(0.f, 0.f, 0.f);
+
+	for (int i = meshlet.x; i < meshlet.x + meshlet.y; i++)
+	{
+		int3 face = facesVertex[meshletFaces[i]];
+		float3 v0 = vertices[face.x];
+		float3 v1 = vertices[face.y];
+		float3 v2 = vertices[face.z];
+
+		minCorner = fminf(minCorner, fminf(v0, fminf(v1, v2)));
+		maxCorner = fmaxf(maxCorner, fmaxf(v0, fmaxf(v1, v2)));
+
+		float3 normal = cross(v1 - v0, v2 - v0);
+		float normalLength = length(normal);
+		if (normalLength > 0.f)
+			normalSum += normal / normalLength;
+	}
+
+	bounds.center = 0.5f * (minCorner + maxCorner);
+	bounds.radius = 0.f;
+
+	for (int i = meshlet.x; i < meshlet.x + meshlet.y; i++)
+	{
+		int3 face = facesVertex[meshletFaces[i]];
+		bounds.radius = fmaxf(bounds.radius, length(vertices[face.x] - bounds.center));
+		bounds.radius = fmaxf(bounds.radius, length(vertices[face.y] - bounds.center));
+		bounds.radius = fmaxf(bounds.radius, length(vertices[face.z] - bounds.center));
+	}
+	bounds.radius *= MESHLET_SPHERE_PADDING;
+
+	//the cone is only usable if all (non degenerated) normals are within 90 degrees of the axis
+	float axisLength = length(normalSum);
+	bounds.coneAxis = axisLength > 0.f ? normalSum / axisLength : make_float3(0.f, 0.f, 1.f);
+	float minCosine = axisLength > 0.f ? 1.f : -1.f;
+
+	for (int i = meshlet.x; i < meshlet.x + meshlet.y; i++)
+	{
+		int3 face = facesVertex[meshletFaces[i]];
+		float3 v0 = vertices[face.x];
+		float3 normal = cross(vertices[face.y] - v0, vertices[face.z] - v0);
+		float normalLength = length(normal);
+		if (normalLength > 0.f)
+			minCosine = fminf(minCosine, dot(normal, bounds.coneAxis) / normalLength);
+	}
+
+	bounds.coneCutoff = minCosine > 0.f ? sqrtf(fmaxf(0.f, 1.f - minCosine * minCosine)) : MESHLET_CONE_DISABLED;
+
+	return bounds;
+}
+
+//==============================================================================================//
+
+/*
+Returns false if the padded bounding sphere is completely in front of the camera and outside the image,
+or (for one sided rendering) if all faces of the meshlet face away from the camera.
+extrinsics / intrinsics are the 3 rows of the camera matrices, cameraPosition the camera center in world space.
+*/
+inline __host__ __device__ bool isMeshletVisible(const MeshletBounds& bounds, const float4* extrinsics, const float3* intrinsics, float3 cameraPosition, int w, int h, bool twoSided)
+{
+	//rows of the projection matrix intrinsics * extrinsics
+	float4 projection[3];
+	for (int row = 0; row < 3; row++)
+	{
+		projection[row] = intrinsics[row].x * extrinsics[0] + intrinsics[row].y * extrinsics[1] + intrinsics[row].z * extrinsics[2];
+	}
+
+	float4 center = make_float4(bounds.center.x, bounds.center.y, bounds.center.z, 1.f);
+
+	//the image plane test is only valid if the whole sphere is in front of the camera
+	float depth = dot(projection[2], center);
+	float depthScale = length(make_float3(projection[2].x, projection[2].y, projection[2].z));
+
+	if (depth > bounds.radius * depthScale)
+	{
+		//u >= -margin, u <= w + margin, v >= -margin, v <= h + margin
+		float4 planes[4];
+		planes[0] = projection[0] + MESHLET_FRUSTUM_MARGIN * projection[2];
+		planes[1] = (w + MESHLET_FRUSTUM_MARGIN) * projection[2] - projection[0];
+		planes[2] = projection[1] + MESHLET_FRUSTUM_MARGIN * projection[2];
+		planes[3] = (h + MESHLET_FRUSTUM_MARGIN) * projection[2] - projection[1];
+
+		for (int p = 0; p < 4; p++)
+		{
+			float planeScale = length(make_float3(planes[p].x, planes[p].y, planes[p].z));
+			if (dot(planes[p], center) < -bounds.radius * planeScale)
+				return false;
+		}
+	}
+
+	//normal cone test: every face normal n and every point x of the meshlet fulfill dot(n, x - cameraPosition) > 0
+	if (!twoSided && bounds.coneCutoff < 1.f)
+	{
+		float3 toCenter = bounds.center - cameraPosition;
+		if (dot(toCenter, bounds.coneAxis) > bounds.coneCutoff * length(toCenter) + bounds.radius * (1.f + bounds.coneCutoff))
+			return false;
+	}
+
+	return true;
+}
+
+//==============================================================================================//
@@ -0,0 +1,80 @@
+//==============================================================================================//
+
+#include "RasterizationReference.h"
+#include "../Utils/RendererUtil.h"
+#include "TriangleSetup.h"
+
+//==============================================================================================//
+
+void rasterizeReference(const std::vector<int>& faces, int numberOfVertices, int numberOfCameras, int w, int h, const float* vertices, const float* extrinsics, const float* intrinsics, bool triangleSetup, VisibilityMode visibilityMode, int* faceIDBuffer, float* barycentricCoordinatesBuffer)
+{
+	int F = faces.size() / 3;
+	const float3* vertexPositions = (const float3*)vertices;
+
+	std::vector<float3> projectedVertices(numberOfVertices);
+	std::vector<unsigned long long> visibilityBuffer(w * h);
+
+	for (int idc = 0; idc < numberOfCameras; idc++)
+	{
+		float4* cameraExtrinsics = (float4*)(extrinsics + 12 * idc);
+		float3* cameraIntrinsics = (float3*)(intrinsics + 9 * idc);
+
+		float4 inverseExtrinsics[4];
+		float4 inverseProjection[4];
+		computeInverseCameraMatrices(cameraExtrinsics, cameraIntrinsics, inverseExtrinsics, inverseProjection);
+
+		for (int idv = 0; idv < numberOfVertices; idv++)
+		{
+			projectedVertices[idv] = projectPointFloat3(cameraIntrinsics, getCamSpacePoint(cameraExtrinsics, vertexPositions[idv]));
+		}
+
+		std::fill(visibilityBuffer.begin(), visibilityBuffer.end(), VISIBILITY_EMPTY);
+
+		int* cameraFaceIDBuffer = faceIDBuffer + idc * w * h;
+		float* cameraBarycentricCoordinatesBuffer = barycentricCoordinatesBuffer + 2 * idc * w * h;
+
+		std::fill(cameraFaceIDBuffer, cameraFaceIDBuffer + w * h, -1);
+		std::fill(cameraBarycentricCoordinatesBuffer, cameraBarycentricCoordinatesBuffer + 2 * w * h, 0.f);
+
+		for (int idf = 0; idf < F; idf++)
+		{
+			int indexv0 = faces[3 * idf + 0];
+			int indexv1 = faces[3 * idf + 1];
+			int indexv2 = faces[3 * idf + 2];
+
+			float3 projectedDepth = make_float3(projectedVertices[indexv0].z, projectedVertices[indexv1].z, projectedVertices[indexv2].z);
+			int4 bbox = computeFaceBoundingBox(projectedVertices[indexv0], projectedVertices[indexv1], projectedVertices[indexv2], w, h);
+			FaceSetup setup = computeFaceSetup(projectedVertices[indexv0], projectedVertices[indexv1], projectedVertices[indexv2], triangleSetup);
+
+			for (int v = bbox.y; v <= bbox.w; v++)
+			{
+				for (int u = bbox.x; u <= bbox.z; u++)
+				{
+					float3 abc;
+					float depth;
+					bool isCovered;
+					if (setup.anchor.z == 0.f)
+						isCovered = rasterizeFaceSetupPixel(u, v, setup, abc, depth);
+					else
+						isCovered = rasterizeFacePixel(u, v, vertexPositions[indexv0], vertexPositions[indexv1], vertexPositions[indexv2], projectedDepth, inverseExtrinsics, inverseProjection, abc, depth);
+
+					if (!isCovered)
+						continue;
+
+					int pixelId = w * v + u;
+
+					unsigned long long key = packVisibility(depth, idf, visibilityMode);
+					if (key < visibilityBuffer[pixelId])
+					{
+						visibilityBuffer[pixelId] = key;
+						cameraFaceIDBuffer[pixelId] = idf;
+						cameraBarycentricCoordinatesBuffer[2 * pixelId + 0] = abc.x;
+						cameraBarycentricCoordinatesBuffer[2 * pixelId + 1] = abc.y;
+					}
+				}
+			}
+		}
+	}
+}
+
+//==============================================================================================//
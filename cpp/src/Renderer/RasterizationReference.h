@@ -0,0 +1,36 @@
+//==============================================================================================//
+// Classname:
+//      RasterizationReference
+//
+//==============================================================================================//
+// Description:
+//      CPU reference of the faceId and barycentricCoordinates buffers of
+//		CUDABasedRasterization. Every face loops over its pixel bounding box like the original
+//		per face GPU kernels, using the same host / device helpers as the tile rasterizer (which
+//		is why the implementation is a .cu file).
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include "Visibility.h"
+
+//==============================================================================================//
+
+/*
+faces						: 3 vertex ids per face
+vertices					: 3 floats per vertex
+extrinsics / intrinsics		: 12 / 9 floats per camera
+faceIDBuffer				: numberOfCameras x h x w, -1 for background
+triangleSetup				: rasterize from the triangle setup (see TriangleSetup.h) or cast a ray per pixel
+visibilityMode				: depth of the visibility keys (see Visibility.h)
+barycentricCoordinatesBuffer: numberOfCameras x h x w x 2
+
+Depth ties are resolved towards the smaller face id like on the GPU.
+*/
+void rasterizeReference(const std::vector<int>& faces, int numberOfVertices, int numberOfCameras, int w, int h, const float* vertices, const float* extrinsics, const float* intrinsics, bool triangleSetup, VisibilityMode visibilityMode, int* faceIDBuffer, float* barycentricCoordinatesBuffer);
+
+//==============================================================================================//
@@ -0,0 +1,221 @@
+//==============================================================================================//
+
+#include "TextureAtlas.h"
+#include "cutil_math.h"
+#include "../Utils/ThreadPool.h"
+#include <cmath>
+#include <algorithm>
+
+//==============================================================================================//
+
+#define TEXTURE_ATLAS_BAND_HEIGHT 32
+
+//distance (in texels) by which the scanline spans are widened before the exact texel test
+#define TEXTURE_ATLAS_SPAN_TOLERANCE 0.01
+
+//==============================================================================================//
+
+struct UVTriangleSetup
+{
+	//texture space vertices and the padded bounding box of the original ray casting version
+	float3	texCoord[3];
+	int		xMin, xMax, yMin, yMax;
+
+	//the same quantities as in the ray triangle intersection, scaled by 1 / 1000
+	float3	scaled[3];
+	float3	normal;
+	float	rayZ;
+	float	denom;
+	bool	valid;
+};
+
+//==============================================================================================//
+
+static void setupUVTriangle(UVTriangleSetup& setup, const std::vector<float>& textureCoordinates, int f, int texWidth, int texHeight)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		setup.texCoord[i]	= make_float3(texWidth * textureCoordinates[f * 3 * 2 + i * 2 + 0], texHeight * (1.f - textureCoordinates[f * 3 * 2 + i * 2 + 1]), 0.f);
+		setup.scaled[i]		= make_float3(setup.texCoord[i].x / 1000.f, setup.texCoord[i].y / 1000.f, 0.f);
+	}
+
+	float minX = std::min(setup.texCoord[0].x, std::min(setup.texCoord[1].x, setup.texCoord[2].x));
+	float maxX = std::max(setup.texCoord[0].x, std::max(setup.texCoord[1].x, setup.texCoord[2].x));
+	float minY = std::min(setup.texCoord[0].y, std::min(setup.texCoord[1].y, setup.texCoord[2].y));
+	float maxY = std::max(setup.texCoord[0].y, std::max(setup.texCoord[1].y, setup.texCoord[2].y));
+
+	setup.xMin = std::max((double)minX - 2.0, 0.0);
+	setup.xMax = std::min((double)maxX + 2.0, (double)texWidth);
+	setup.yMin = std::max((double)minY - 2.0, 0.0);
+	setup.yMax = std::min((double)maxY + 2.0, (double)texHeight);
+
+	//(unnormalized) plane normal
+	float3 v0v1 = setup.scaled[1] - setup.scaled[0];
+	float3 v0v2 = setup.scaled[2] - setup.scaled[0];
+	setup.normal	= cross(v0v1, v0v2);
+	setup.denom		= dot(setup.normal, setup.normal);
+
+	//ray and plane are parallel for degenerated uv triangles
+	float3 direction = make_float3(0.f, 0.f, -1.f);
+	float normalDotDirection = dot(direction, setup.normal);
+	setup.valid = std::fabs(normalDotDirection) >= 0.0000001f;
+
+	//the ray parameter only depends on the z component of the ray origin, so it is the same for all texels
+	float3 origin = make_float3(0.5f, 0.5f, 1.f) / 1000.f;
+	float t = (dot(setup.scaled[0], setup.normal) - dot(origin, setup.normal)) / normalDotDirection;
+	setup.valid = setup.valid && !(t < 0);
+	setup.rayZ = origin.z + t * direction.z;
+}
+
+//==============================================================================================//
+
+/*
+Inside test and barycentric coordinates of a texel center.
+Evaluates exactly the same float expressions as the former per texel ray triangle intersection,
+so the atlas content does not change.
+*/
+static inline bool getUVBarycentric(const UVTriangleSetup& setup, int x, int y, float& a, float& b)
+{
+	//intersection point of the texel ray, x and y are not changed by the ray parameter
+	float3 P = make_float3((x + 0.5f) / 1000.f, (y + 0.5f) / 1000.f, setup.rayZ);
+
+	const float3& v0 = setup.scaled[0];
+	const float3& v1 = setup.scaled[1];
+	const float3& v2 = setup.scaled[2];
+
+	// edge 0
+	if (dot(setup.normal, cross(v1 - v0, P - v0)) < 0)
+		return false;
+
+	// edge 1
+	if ((a = dot(setup.normal, cross(v2 - v1, P - v1))) < 0)
+		return false;
+
+	// edge 2
+	if ((b = dot(setup.normal, cross(v0 - v2, P - v2))) < 0)
+		return false;
+
+	a /= setup.denom;
+	b /= setup.denom;
+
+	return true;
+}
+
+//==============================================================================================//
+
+/*
+Computes the conservative span [xStart, xEnd) of texel centers in row y which lie inside the triangle
+*/
+static void getUVTriangleSpan(const UVTriangleSetup& setup, int y, int& xStart, int& xEnd)
+{
+	double lower = setup.xMin;
+	double upper = setup.xMax - 1;
+
+	double py	 = y + 0.5;
+	double area	 = ((double)setup.texCoord[1].x - setup.texCoord[0].x) * ((double)setup.texCoord[2].y - setup.texCoord[0].y)
+				 - ((double)setup.texCoord[1].y - setup.texCoord[0].y) * ((double)setup.texCoord[2].x - setup.texCoord[0].x);
+	double orientation = area >= 0.0 ? 1.0 : -1.0;
+
+	for (int e = 0; e < 3 && lower <= upper; e++)
+	{
+		const float3& start = setup.texCoord[e];
+		const float3& end	= setup.texCoord[(e + 1) % 3];
+
+		double edgeX = (double)end.x - start.x;
+		double edgeY = (double)end.y - start.y;
+		double edgeLength = std::sqrt(edgeX * edgeX + edgeY * edgeY);
+
+		//edge function E(px) = orientation * (edgeX * (py - start.y) - edgeY * (px - start.x)) >= -tolerance * |edge|
+		double slope	= -orientation * edgeY;
+		double offset	=  orientation * (edgeX * (py - start.y) + edgeY * start.x) + TEXTURE_ATLAS_SPAN_TOLERANCE * edgeLength;
+
+		//texel centers are at px = x + 0.5
+		if (slope > 0.0)
+		{
+			lower = std::max(lower, -offset / slope - 0.5);
+		}
+		else if (slope < 0.0)
+		{
+			upper = std::min(upper, -offset / slope - 0.5);
+		}
+		else if (offset < 0.0)
+		{
+			upper = lower - 1.0;
+		}
+	}
+
+	xStart	= (int)std::ceil(lower);
+	xEnd	= (int)std::floor(upper) + 1;
+}
+
+//==============================================================================================//
+
+void computeTextureMapFaceIds(const std::vector<float>& textureCoordinates, int F, int texWidth, int texHeight, TextureAtlasTexel* h_textureMap, const int* faceIds)
+{
+	ThreadPool& threadPool = ThreadPool::getInstance();
+
+	std::vector<UVTriangleSetup> setups(F);
+	threadPool.parallelFor((F + 4095) / 4096, [&](int chunk)
+	{
+		int faceEnd = std::min(F, (chunk + 1) * 4096);
+		for (int f = chunk * 4096; f < faceEnd; f++)
+			setupUVTriangle(setups[f], textureCoordinates, f, texWidth, texHeight);
+	});
+
+	//bin the faces into horizontal bands, in ascending face order
+	int numberOfBands = (texHeight + TEXTURE_ATLAS_BAND_HEIGHT - 1) / TEXTURE_ATLAS_BAND_HEIGHT;
+	std::vector<std::vector<int>> bandFaces(numberOfBands);
+
+	for (int f = 0; f < F; f++)
+	{
+		const UVTriangleSetup& setup = setups[f];
+
+		if (!setup.valid || setup.yMin >= setup.yMax || setup.xMin >= setup.xMax)
+			continue;
+
+		for (int band = setup.yMin / TEXTURE_ATLAS_BAND_HEIGHT; band <= (setup.yMax - 1) / TEXTURE_ATLAS_BAND_HEIGHT; band++)
+			bandFaces[band].push_back(f);
+	}
+
+	//every band is written by exactly one task and faces are drawn in ascending order, hence the last (highest) face wins
+	threadPool.parallelFor(numberOfBands, [&](int band)
+	{
+		int bandStart	= band * TEXTURE_ATLAS_BAND_HEIGHT;
+		int bandEnd		= std::min(texHeight, bandStart + TEXTURE_ATLAS_BAND_HEIGHT);
+
+		for (int y = bandStart; y < bandEnd; y++)
+		{
+			for (int x = 0; x < texWidth; x++)
+			{
+				h_textureMap[y * texWidth + x] = make_int2(TEXTURE_ATLAS_EMPTY_TEXEL, 0);
+			}
+		}
+
+		for (int i = 0; i < (int)bandFaces[band].size(); i++)
+		{
+			int f = bandFaces[band][i];
+			int faceId = faceIds != NULL ? faceIds[f] : f;
+			const UVTriangleSetup& setup = setups[f];
+
+			int yStart	= std::max(bandStart, setup.yMin);
+			int yEnd	= std::min(bandEnd, setup.yMax);
+
+			for (int y = yStart; y < yEnd; y++)
+			{
+				int xStart, xEnd;
+				getUVTriangleSpan(setup, y, xStart, xEnd);
+
+				for (int x = xStart; x < xEnd; x++)
+				{
+					float a, b;
+					if (getUVBarycentric(setup, x, y, a, b))
+					{
+						h_textureMap[y * texWidth + x] = packTextureAtlasTexel(faceId, a, b);
+					}
+				}
+			}
+		}
+	});
+}
+
+//==============================================================================================//
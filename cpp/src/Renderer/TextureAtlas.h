@@ -0,0 +1,63 @@
+//==============================================================================================//
+// Classname:
+//      TextureAtlas
+//
+//==============================================================================================//
+// Description:
+//      Rasterizes the UV triangles of a mesh into a per texel (face id, barycentric coords)
+//		map in a packed 8 byte format. Uses edge function scanlines over horizontal texture bands which are processed
+//		in parallel on the host thread pool. Overlapping charts are resolved deterministically,
+//		the face with the highest id wins.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include <math.h>
+#include <cuda_runtime.h>
+
+//==============================================================================================//
+
+/*
+Packed texel of the atlas:
+x : face id, TEXTURE_ATLAS_EMPTY_TEXEL for texels which are not covered by any face
+y : barycentric coords a (low 16 bits) and b (high 16 bits) as unorm16, c = 1 - a - b
+*/
+typedef int2 TextureAtlasTexel;
+
+#define TEXTURE_ATLAS_EMPTY_TEXEL -1
+
+//==============================================================================================//
+
+inline __host__ __device__ TextureAtlasTexel packTextureAtlasTexel(int faceId, float a, float b)
+{
+	unsigned int packedA = (unsigned int)(fminf(fmaxf(a, 0.f), 1.f) * 65535.f + 0.5f);
+	unsigned int packedB = (unsigned int)(fminf(fmaxf(b, 0.f), 1.f) * 65535.f + 0.5f);
+	return make_int2(faceId, (int)(packedA | (packedB << 16)));
+}
+
+//==============================================================================================//
+
+/*
+Returns (a, b, c) of a packed texel
+*/
+inline __host__ __device__ float3 unpackTextureAtlasBarycentric(TextureAtlasTexel texel)
+{
+	float a = ((unsigned int)texel.y & 0xFFFF) / 65535.f;
+	float b = ((unsigned int)texel.y >> 16) / 65535.f;
+	return make_float3(a, b, 1.f - a - b);
+}
+
+//==============================================================================================//
+
+/*
+textureCoordinates		: 3 x 2 texture coordinates per face
+h_textureMap			: texWidth x texHeight packed output texels
+faceIds					: optional id stored for each face instead of its index, overlaps are still resolved by the index
+*/
+void computeTextureMapFaceIds(const std::vector<float>& textureCoordinates, int F, int texWidth, int texHeight, TextureAtlasTexel* h_textureMap, const int* faceIds = NULL);
+
+//==============================================================================================//
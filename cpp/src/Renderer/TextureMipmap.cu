@@ -0,0 +1,173 @@
+//==============================================================================================//
+
+#include <cuda_runtime.h>
+#include "../Utils/cudaUtil.h"
+#include "CUDABasedRasterizationInput.h"
+#include "TextureMipmap.h"
+
+//==============================================================================================//
+//Texture mipmap
+//==============================================================================================//
+
+/*
+Texel (x, y) of a level, the base level is read from the texture of batch element idb in its format
+*/
+__inline__ __device__ float3 loadMipmapTexel(const TextureMipmap& mipmap, const void* texture, BufferFormat format, int channels, int idb, int level, int x, int y)
+{
+	int2 size = getMipmapLevelSize(mipmap.texWidth, mipmap.texHeight, level);
+
+	if (level == 0)
+		return loadBufferColor(texture, idb * mipmap.texWidth * mipmap.texHeight + y * size.x + x, channels, format);
+
+	float4 texel = mipmap.d_levels[idb * mipmap.numberOfTexels + getMipmapLevelOffset(mipmap.texWidth, mipmap.texHeight, level) + y * size.x + x];
+	return make_float3(texel.x, texel.y, texel.z);
+}
+
+//==============================================================================================//
+
+/*
+Computes level from the level below with a 2 x 2 box filter, one thread per texel of the level of every batch element.
+The filter footprint is clamped to the level below, so odd sizes drop their last row or column.
+*/
+__global__ void downsampleTextureMipmapDevice(TextureMipmap mipmap, const void* texture, BufferFormat format, int channels, int numberOfBatches, int level)
+{
+	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+	int2 size = getMipmapLevelSize(mipmap.texWidth, mipmap.texHeight, level);
+	int2 lowerSize = getMipmapLevelSize(mipmap.texWidth, mipmap.texHeight, level - 1);
+
+	if (idx < numberOfBatches * size.x * size.y)
+	{
+		int idb = idx / (size.x * size.y);
+		int x = (idx % (size.x * size.y)) % size.x;
+		int y = (idx % (size.x * size.y)) / size.x;
+
+		int lowX	= min(2 * x, lowerSize.x - 1);
+		int highX	= min(2 * x + 1, lowerSize.x - 1);
+		int lowY	= min(2 * y, lowerSize.y - 1);
+		int highY	= min(2 * y + 1, lowerSize.y - 1);
+
+		float3 color =	loadMipmapTexel(mipmap, texture, format, channels, idb, level - 1, lowX, lowY) +
+						loadMipmapTexel(mipmap, texture, format, channels, idb, level - 1, highX, lowY) +
+						loadMipmapTexel(mipmap, texture, format, channels, idb, level - 1, lowX, highY) +
+						loadMipmapTexel(mipmap, texture, format, channels, idb, level - 1, highX, highY);
+
+		mipmap.d_levels[idb * mipmap.numberOfTexels + getMipmapLevelOffset(mipmap.texWidth, mipmap.texHeight, level) + y * size.x + x] = make_float4(0.25f * color, 0.f);
+	}
+}
+
+//==============================================================================================//
+
+/*
+Adds the gradient of level to the level below with the transpose of the box filter, one thread per texel of the level below of
+every batch element. Every texel of the level below gathers from its parent, so no atomics are needed. A level below of size 1
+is read twice by the clamped filter footprint.
+*/
+__global__ void gatherTextureMipmapGradDevice(TextureMipmap mipmap, float* textureGrad, int channels, int numberOfBatches, int level)
+{
+	const unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+	int2 size = getMipmapLevelSize(mipmap.texWidth, mipmap.texHeight, level);
+	int2 lowerSize = getMipmapLevelSize(mipmap.texWidth, mipmap.texHeight, level - 1);
+
+	if (idx < numberOfBatches * lowerSize.x * lowerSize.y)
+	{
+		int idb = idx / (lowerSize.x * lowerSize.y);
+		int texel = idx % (lowerSize.x * lowerSize.y);
+		int x = texel % lowerSize.x;
+		int y = texel / lowerSize.x;
+
+		//the last row or column of an odd level is not filtered
+		if (x / 2 >= size.x || y / 2 >= size.y)
+			return;
+
+		float weight = 0.25f * (lowerSize.x == 1 ? 2.f : 1.f) * (lowerSize.y == 1 ? 2.f : 1.f);
+		float4 grad = weight * mipmap.d_levelsGrad[idb * mipmap.numberOfTexels + getMipmapLevelOffset(mipmap.texWidth, mipmap.texHeight, level) + (y / 2) * size.x + x / 2];
+
+		if (level - 1 == 0)
+		{
+			float* texelGrad = textureGrad + channels * (idb * mipmap.texWidth * mipmap.texHeight + texel);
+			texelGrad[0] += grad.x;
+			texelGrad[1] += grad.y;
+			texelGrad[2] += grad.z;
+		}
+		else
+		{
+			mipmap.d_levelsGrad[idb * mipmap.numberOfTexels + getMipmapLevelOffset(mipmap.texWidth, mipmap.texHeight, level - 1) + texel] += grad;
+		}
+	}
+}
+
+//==============================================================================================//
+
+void createTextureMipmap(TextureMipmap& mipmap, bool gradient)
+{
+	mipmap.texWidth			= 0;
+	mipmap.texHeight		= 0;
+	mipmap.numberOfLevels	= 1;
+	mipmap.numberOfTexels	= 0;
+	mipmap.capacity			= 0;
+	mipmap.gradient			= gradient;
+	mipmap.d_levels			= NULL;
+	mipmap.d_levelsGrad		= NULL;
+}
+
+//==============================================================================================//
+
+void destroyTextureMipmap(TextureMipmap& mipmap)
+{
+	cutilSafeCall(cudaFree(mipmap.d_levels));
+	cutilSafeCall(cudaFree(mipmap.d_levelsGrad));
+	mipmap.d_levels		= NULL;
+	mipmap.d_levelsGrad = NULL;
+	mipmap.capacity		= 0;
+}
+
+//==============================================================================================//
+
+extern "C" int updateTextureMipmapGPU(TextureMipmap& mipmap, const void* d_texture, BufferFormat format, int channels, int texWidth, int texHeight, int numberOfBatches, cudaStream_t stream)
+{
+	mipmap.texWidth			= texWidth;
+	mipmap.texHeight		= texHeight;
+	mipmap.numberOfLevels	= getNumberOfMipmapLevels(texWidth, texHeight);
+	mipmap.numberOfTexels	= getMipmapLevelOffset(texWidth, texHeight, mipmap.numberOfLevels);
+
+	if (numberOfBatches * mipmap.numberOfTexels > mipmap.capacity)
+	{
+		bool gradient = mipmap.gradient;
+		destroyTextureMipmap(mipmap);
+
+		mipmap.capacity = numberOfBatches * mipmap.numberOfTexels;
+		cutilSafeCall(cudaMalloc(&mipmap.d_levels, sizeof(float4) * mipmap.capacity));
+		if (gradient)
+			cutilSafeCall(cudaMalloc(&mipmap.d_levelsGrad, sizeof(float4) * mipmap.capacity));
+	}
+
+	if (mipmap.d_levelsGrad != NULL)
+		cutilSafeCall(cudaMemsetAsync(mipmap.d_levelsGrad, 0, sizeof(float4) * numberOfBatches * mipmap.numberOfTexels, stream));
+
+	//every level is computed from the one below, so the levels are launched in order
+	for (int level = 1; level < mipmap.numberOfLevels; level++)
+	{
+		int2 size = getMipmapLevelSize(texWidth, texHeight, level);
+		downsampleTextureMipmapDevice << <(numberOfBatches * size.x * size.y + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (mipmap, d_texture, format, channels, numberOfBatches, level);
+	}
+
+	return mipmap.numberOfLevels - 1;
+}
+
+//==============================================================================================//
+
+extern "C" int gatherTextureMipmapGradGPU(const TextureMipmap& mipmap, float* d_textureGrad, int channels, int numberOfBatches, cudaStream_t stream)
+{
+	//the gradient of every level has to be complete before it is passed down
+	for (int level = mipmap.numberOfLevels - 1; level > 0; level--)
+	{
+		int2 lowerSize = getMipmapLevelSize(mipmap.texWidth, mipmap.texHeight, level - 1);
+		gatherTextureMipmapGradDevice << <(numberOfBatches * lowerSize.x * lowerSize.y + THREADS_PER_BLOCK_CUDABASEDRASTERIZER - 1) / THREADS_PER_BLOCK_CUDABASEDRASTERIZER, THREADS_PER_BLOCK_CUDABASEDRASTERIZER, 0, stream >> > (mipmap, d_textureGrad, channels, numberOfBatches, level);
+	}
+
+	return mipmap.numberOfLevels - 1;
+}
+
+//==============================================================================================//
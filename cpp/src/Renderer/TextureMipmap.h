@@ -0,0 +1,265 @@
+//==============================================================================================//
+// Classname:
+//      TextureMipmap
+//
+//==============================================================================================//
+// Description:
+//      Mip pyramid of the texture input for the trilinear texture sampling. Every level halves
+//		the previous one with a 2 x 2 box filter down to a single texel. The base level is the
+//		texture itself in its storage format, the levels above it are kept in float. The level
+//		of detail of a pixel is chosen from the screen space derivatives of its texture
+//		coordinates, so minified views read a level whose texels match the pixel footprint
+//		instead of scattering over the full resolution texture. The gradient of the levels is
+//		gathered back into the base level with the transpose of the box filter.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <math.h>
+#include <cuda_runtime.h>
+#include "cutil_math.h"
+#include "BufferFormat.h"
+#include "CameraSetup.h"
+
+//==============================================================================================//
+
+/*
+Nearest		: the texel at the texture coordinates of the full resolution texture, the original sampling
+Trilinear	: bilinear samples of the two mip levels around the level of detail of the pixel, blended linearly
+*/
+enum TextureSampling
+{
+	Nearest, Trilinear
+};
+
+//==============================================================================================//
+
+#define TRILINEAR_TAPS 8
+
+//==============================================================================================//
+
+struct TextureMipmap
+{
+	int			texWidth;								//base level the pyramid is allocated for
+	int			texHeight;
+	int			numberOfLevels;							//number of levels including the base level
+	int			numberOfTexels;							//texels of the levels above the base level per batch element
+	int			capacity;								//allocated texels of the levels (and of their gradient)
+	bool		gradient;								//whether the gradient of the levels is allocated
+
+	float4*		d_levels;								//levels 1, ..., numberOfLevels - 1 of every batch element, RGB in xyz
+	float4*		d_levelsGrad;							//gradient of the levels in the same layout, NULL without gradient
+};
+
+//==============================================================================================//
+
+/*
+Texel of a level read by a sample. The texel index is relative to the texture of the batch element for the base level and
+relative to the levels of the batch element (see getMipmapLevelOffset) otherwise.
+*/
+struct MipmapTap
+{
+	int			level;
+	int			texel;
+	float		weight;
+};
+
+//==============================================================================================//
+
+void createTextureMipmap(TextureMipmap& mipmap, bool gradient);
+
+void destroyTextureMipmap(TextureMipmap& mipmap);
+
+//==============================================================================================//
+
+/*
+Builds the levels above the base level for numberOfBatches textures (channels per texel in format), one launch per level on
+stream. The levels grow with the texture and the batch size, the gradient of the levels is zeroed. Returns the number of launches.
+*/
+extern "C" int updateTextureMipmapGPU(TextureMipmap& mipmap, const void* d_texture, BufferFormat format, int channels, int texWidth, int texHeight, int numberOfBatches, cudaStream_t stream);
+
+/*
+Adds the gradient of the levels to the texture gradient d_textureGrad (float, channels per texel), one launch per level from the
+coarsest to the base level on stream. Returns the number of launches.
+*/
+extern "C" int gatherTextureMipmapGradGPU(const TextureMipmap& mipmap, float* d_textureGrad, int channels, int numberOfBatches, cudaStream_t stream);
+
+//==============================================================================================//
+
+/*
+Size of a level, every level halves the previous one down to one texel per dimension
+*/
+inline __host__ __device__ int2 getMipmapLevelSize(int texWidth, int texHeight, int level)
+{
+	int levelWidth	= texWidth >> level;
+	int levelHeight = texHeight >> level;
+	return make_int2(levelWidth > 1 ? levelWidth : 1, levelHeight > 1 ? levelHeight : 1);
+}
+
+//==============================================================================================//
+
+/*
+Number of levels including the base level, the last level has a single texel
+*/
+inline __host__ __device__ int getNumberOfMipmapLevels(int texWidth, int texHeight)
+{
+	int size = texWidth > texHeight ? texWidth : texHeight;
+
+	int numberOfLevels = 1;
+	while ((size >> numberOfLevels) > 0)
+		numberOfLevels++;
+
+	return numberOfLevels;
+}
+
+//==============================================================================================//
+
+/*
+First texel of a level above the base level within the levels of a batch element, for level numberOfLevels it is the number
+of texels of the levels of a batch element
+*/
+inline __host__ __device__ int getMipmapLevelOffset(int texWidth, int texHeight, int level)
+{
+	int offset = 0;
+	for (int l = 1; l < level; l++)
+	{
+		int2 size = getMipmapLevelSize(texWidth, texHeight, l);
+		offset += size.x * size.y;
+	}
+	return offset;
+}
+
+//==============================================================================================//
+
+/*
+Barycentric coordinates of the intersection of a ray with the plane of a triangle, also outside of the triangle.
+Returns false if the ray is parallel to the plane.
+*/
+inline __host__ __device__ bool rayPlaneBarycentrics(float3 o, float3 d, float3 v0, float3 v1, float3 v2, float3& abc)
+{
+	float3 N = cross(v1 - v0, v2 - v0);
+
+	float NdotRayDirection = dot(N, d);
+	float NdotN = dot(N, N);
+	if (fabsf(NdotRayDirection) <= 1e-12f * NdotN || NdotN <= 0.f)
+		return false;
+
+	float3 P = o + (dot(N, v0 - o) / NdotRayDirection) * d;
+
+	//same convention as rayTriangleIntersect (RendererUtil.h)
+	abc.x = dot(N, cross(v2 - v1, P - v1)) / NdotN;
+	abc.y = dot(N, cross(v0 - v2, P - v2)) / NdotN;
+	abc.z = 1.f - abc.x - abc.y;
+	return true;
+}
+
+//==============================================================================================//
+
+/*
+Level of detail of pixel (u, v) of the camera (rayOrigin, inverseProjection) covered by the face (v0, v1, v2) with the texture
+coordinates tc0, tc1, tc2 in texels of the base level. The derivatives of the texture coordinates along u and v are the
+differences to the texture coordinates where the rays through the neighbouring pixels hit the plane of the face, so the
+face alone gives them. The level is log2 of the longer derivative, a ray parallel to the face gives the coarsest level.
+*/
+inline __host__ __device__ float getTextureLOD(float3 rayOrigin, const float4* inverseProjection, int u, int v, int w, int h, float3 v0, float3 v1, float3 v2, float2 tc0, float2 tc1, float2 tc2)
+{
+	//the neighbour on the other side at the last column and row
+	int neighbourU = u + 1 < w ? u + 1 : u - 1;
+	int neighbourV = v + 1 < h ? v + 1 : v - 1;
+
+	float3 abc, abcU, abcV;
+	if (!rayPlaneBarycentrics(rayOrigin, getPixelRayDirection(inverseProjection, rayOrigin, u, v), v0, v1, v2, abc)
+		|| !rayPlaneBarycentrics(rayOrigin, getPixelRayDirection(inverseProjection, rayOrigin, neighbourU, v), v0, v1, v2, abcU)
+		|| !rayPlaneBarycentrics(rayOrigin, getPixelRayDirection(inverseProjection, rayOrigin, u, neighbourV), v0, v1, v2, abcV))
+	{
+		return 1e10f;
+	}
+
+	float2 texCoord		= abc.x * tc0 + abc.y * tc1 + abc.z * tc2;
+	float2 derivativeU	= abcU.x * tc0 + abcU.y * tc1 + abcU.z * tc2 - texCoord;
+	float2 derivativeV	= abcV.x * tc0 + abcV.y * tc1 + abcV.z * tc2 - texCoord;
+
+	return 0.5f * log2f(fmaxf(dot(derivativeU, derivativeU), dot(derivativeV, derivativeV)));
+}
+
+//==============================================================================================//
+
+/*
+Taps of a trilinear sample at texCoord (in texels of the base level): the 2 x 2 bilinear taps of the level below and above
+the level of detail lod, which is clamped to the pyramid. Texel centers are at half texels, the taps are clamped to the level.
+*/
+inline __host__ __device__ void getTrilinearTaps(float2 texCoord, float lod, int texWidth, int texHeight, int numberOfLevels, MipmapTap* taps)
+{
+	lod = fminf(fmaxf(lod, 0.f), (float)(numberOfLevels - 1));
+
+	int lowerLevel = (int)lod;
+	int upperLevel = lowerLevel + 1 < numberOfLevels ? lowerLevel + 1 : lowerLevel;
+	float levelWeight = lod - lowerLevel;
+
+	for (int l = 0; l < 2; l++)
+	{
+		int level = l == 0 ? lowerLevel : upperLevel;
+		int2 size = getMipmapLevelSize(texWidth, texHeight, level);
+		int offset = level == 0 ? 0 : getMipmapLevelOffset(texWidth, texHeight, level);
+
+		float x = texCoord.x * size.x / texWidth - 0.5f;
+		float y = texCoord.y * size.y / texHeight - 0.5f;
+		float x0 = floorf(x);
+		float y0 = floorf(y);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		int lowX	= (int)fminf(fmaxf(x0, 0.f), (float)(size.x - 1));
+		int highX	= (int)fminf(fmaxf(x0 + 1.f, 0.f), (float)(size.x - 1));
+		int lowY	= (int)fminf(fmaxf(y0, 0.f), (float)(size.y - 1));
+		int highY	= (int)fminf(fmaxf(y0 + 1.f, 0.f), (float)(size.y - 1));
+
+		float weight = l == 0 ? 1.f - levelWeight : levelWeight;
+
+		taps[4 * l + 0] = { level, offset + lowY  * size.x + lowX,  weight * (1.f - fx) * (1.f - fy) };
+		taps[4 * l + 1] = { level, offset + lowY  * size.x + highX, weight * fx * (1.f - fy) };
+		taps[4 * l + 2] = { level, offset + highY * size.x + lowX,  weight * (1.f - fx) * fy };
+		taps[4 * l + 3] = { level, offset + highY * size.x + highX, weight * fx * fy };
+	}
+}
+
+//==============================================================================================//
+
+//the base level is loaded with the device only loads of BufferFormat.h
+#ifdef __CUDACC__
+
+/*
+Weighted sum of the taps, the base level is read from the texture of the batch element (textureOffset) in its format and the
+levels above it from the levels of the batch element (levelsOffset)
+*/
+inline __device__ float3 sampleMipmapTaps(const MipmapTap* taps, const void* texture, int textureOffset, int channels, BufferFormat format, const float4* levels, int levelsOffset)
+{
+	float3 color = make_float3(0.f, 0.f, 0.f);
+
+	for (int t = 0; t < TRILINEAR_TAPS; t++)
+	{
+		if (taps[t].weight == 0.f)
+			continue;
+
+		if (taps[t].level == 0)
+		{
+			color += taps[t].weight * loadBufferColor(texture, textureOffset + taps[t].texel, channels, format);
+		}
+		else
+		{
+			float4 texel = levels[levelsOffset + taps[t].texel];
+			color += taps[t].weight * make_float3(texel.x, texel.y, texel.z);
+		}
+	}
+
+	return color;
+}
+
+//==============================================================================================//
+
+#endif
+
+//==============================================================================================//
@@ -0,0 +1,97 @@
+//==============================================================================================//
+// Classname:
+//      TriangleSetup
+//
+//==============================================================================================//
+// Description:
+//      Per camera and face setup of the rasterizer. The perspective correct barycentrics and
+//		the depth of a projected face are evaluated from screen space planes instead of casting
+//		a ray per pixel. Shared between host and device, so the reference rasterizer uses the
+//		exact same arithmetic.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <math.h>
+#include <cuda_runtime.h>
+#include "cutil_math.h"
+
+//==============================================================================================//
+
+/*
+Per camera and face triangle setup. The perspective correct barycentrics and the depth are ratios of functions which are
+linear in screen space: (b0 * s, b1 * s, s, s / z) with s = sum_i lambda_i / z_i for the screen space barycentrics lambda_i.
+The linear functions are stored relative to the first vertex.
+*/
+struct FaceSetup
+{
+	float4 dU;			//derivatives along u
+	float4 dV;			//derivatives along v
+	float4 origin;		//values at the first vertex
+	float4 anchor;		//(u, v) of the first vertex, z is 1 if the face has to be rasterized with ray casting, w is the nearest vertex depth
+};
+
+//==============================================================================================//
+
+/*
+Computes the triangle setup of a projected face. Faces which touch the near plane (their projection is clamped) or are
+degenerated in screen space are marked for ray casting, as is every face if triangleSetup is false.
+*/
+inline __host__ __device__ FaceSetup computeFaceSetup(float3 i_v0, float3 i_v1, float3 i_v2, bool triangleSetup)
+{
+	FaceSetup setup;
+
+	float area = (i_v1.x - i_v0.x) * (i_v2.y - i_v0.y) - (i_v2.x - i_v0.x) * (i_v1.y - i_v0.y);
+
+	bool rayCasting = !triangleSetup || !(fabsf(area) > 0.f) || i_v0.z <= 0.00001f || i_v1.z <= 0.00001f || i_v2.z <= 0.00001f;
+
+	setup.anchor = make_float4(i_v0.x, i_v0.y, rayCasting ? 1.f : 0.f, fminf(i_v0.z, fminf(i_v1.z, i_v2.z)));
+
+	if (rayCasting)
+	{
+		setup.dU = setup.dV = setup.origin = make_float4(0.f, 0.f, 0.f, 0.f);
+		return setup;
+	}
+
+	float3 inverseDepth = make_float3(1.f / i_v0.z, 1.f / i_v1.z, 1.f / i_v2.z);
+
+	//screen space barycentric derivatives
+	float3 lambdaU = make_float3(i_v1.y - i_v2.y, i_v2.y - i_v0.y, i_v0.y - i_v1.y) / area;
+	float3 lambdaV = make_float3(i_v2.x - i_v1.x, i_v0.x - i_v2.x, i_v1.x - i_v0.x) / area;
+
+	setup.dU		= make_float4(lambdaU.x * inverseDepth.x, lambdaU.y * inverseDepth.y, dot(lambdaU, inverseDepth), dot(lambdaU, inverseDepth * inverseDepth));
+	setup.dV		= make_float4(lambdaV.x * inverseDepth.x, lambdaV.y * inverseDepth.y, dot(lambdaV, inverseDepth), dot(lambdaV, inverseDepth * inverseDepth));
+	setup.origin	= make_float4(inverseDepth.x, 0.f, inverseDepth.x, inverseDepth.x * inverseDepth.x);
+
+	return setup;
+}
+
+//==============================================================================================//
+
+/*
+Counterpart of rasterizeFacePixel (RendererUtil.h) which evaluates the linear functions of the triangle setup instead of casting a ray
+*/
+inline __host__ __device__ bool rasterizeFaceSetupPixel(int u, int v, const FaceSetup& setup, float3& abc, float& depth)
+{
+	float du = u + 0.5f - setup.anchor.x;
+	float dv = v + 0.5f - setup.anchor.y;
+
+	float4 value = setup.origin + du * setup.dU + dv * setup.dV;
+
+	bool isInsideTriangle = (value.x >= 0.f) && (value.y >= 0.f) && (value.z - value.x - value.y >= 0.f) && (value.z > 0.f);
+
+	if (!isInsideTriangle)
+		return false;
+
+	abc.x = value.x / value.z;
+	abc.y = value.y / value.z;
+	abc.z = 1.f - abc.x - abc.y;
+
+	depth = value.z / value.w; //Perspective-Correct Interpolation
+	return true;
+}
+
+//==============================================================================================//
@@ -0,0 +1,109 @@
+//==============================================================================================//
+// Classname:
+//      Visibility
+//
+//==============================================================================================//
+// Description:
+//      Per pixel visibility keys of the rasterizer. The depth of a covered face is mapped to an
+//		order preserving 32 bit pattern and packed above the face id, so the minimum of the 64 bit
+//		keys is the closest face, with depth ties resolved towards the smaller face id.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <cuda_runtime.h>
+
+//==============================================================================================//
+
+//key of a pixel which is not covered by any face
+#define VISIBILITY_EMPTY 0xFFFFFFFFFFFFFFFFull
+
+//scale of the integer depth buffer
+#define VISIBILITY_DEPTH_SCALE 10000.f
+
+//depth bound of a pixel which is not covered by any face
+#define VISIBILITY_EMPTY_DEPTH 1e30f
+
+//==============================================================================================//
+
+/*
+Packed		: full float depth
+Quantized	: integer depth of the depth buffer, faces closer than 1 / VISIBILITY_DEPTH_SCALE tie
+*/
+enum VisibilityMode
+{
+	Packed, Quantized
+};
+
+//==============================================================================================//
+
+inline __host__ __device__ int quantizeDepth(float depth)
+{
+	return depth * VISIBILITY_DEPTH_SCALE;
+}
+
+//==============================================================================================//
+
+/*
+Maps the float bits to an unsigned int of the same order (negative values are inverted, positive ones get the sign bit)
+*/
+inline __host__ __device__ unsigned int orderedFloatBits(float value)
+{
+	union { float f; unsigned int u; } bits;
+	bits.f = value;
+	return (bits.u & 0x80000000u) ? ~bits.u : (bits.u | 0x80000000u);
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ float orderedBitsToFloat(unsigned int orderedBits)
+{
+	union { float f; unsigned int u; } bits;
+	bits.u = (orderedBits & 0x80000000u) ? (orderedBits & 0x7FFFFFFFu) : ~orderedBits;
+	return bits.f;
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ unsigned long long packVisibility(float depth, int faceId, VisibilityMode visibilityMode)
+{
+	unsigned int depthBits = visibilityMode == VisibilityMode::Quantized ? ((unsigned int)quantizeDepth(depth) ^ 0x80000000u) : orderedFloatBits(depth);
+	return ((unsigned long long)depthBits << 32) | (unsigned int)faceId;
+}
+
+//==============================================================================================//
+
+inline __host__ __device__ int unpackVisibilityFaceId(unsigned long long key)
+{
+	return (int)(key & 0xFFFFFFFFull);
+}
+
+//==============================================================================================//
+
+/*
+Upper bound of the depth of a key, used by the hierarchical depth test
+*/
+inline __host__ __device__ float unpackVisibilityFarDepth(unsigned long long key, VisibilityMode visibilityMode)
+{
+	if (key == VISIBILITY_EMPTY)
+		return VISIBILITY_EMPTY_DEPTH;
+
+	unsigned int depthBits = (unsigned int)(key >> 32);
+	return visibilityMode == VisibilityMode::Quantized ? ((int)(depthBits ^ 0x80000000u) + 1) / VISIBILITY_DEPTH_SCALE : orderedBitsToFloat(depthBits);
+}
+
+//==============================================================================================//
+
+/*
+Value of the integer depth buffer
+*/
+inline __host__ __device__ int unpackVisibilityDepth(unsigned long long key, VisibilityMode visibilityMode)
+{
+	unsigned int depthBits = (unsigned int)(key >> 32);
+	return visibilityMode == VisibilityMode::Quantized ? (int)(depthBits ^ 0x80000000u) : quantizeDepth(orderedBitsToFloat(depthBits));
+}
+
+//==============================================================================================//
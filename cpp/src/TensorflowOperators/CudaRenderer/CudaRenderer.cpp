@@ -6,19 +6,21 @@ REGISTER_OP("CudaRendererGpu")
 
 .Input("vertex_pos: float")
 .Input("vertex_color: float")
-.Input("texture: float")
+.Input("texture: texture_type")
 .Input("sh_coeff: float")
 .Input("target_image: float")
 .Input("extrinsics: float")
 .Input("intrinsics: float")
 
-.Output("barycentric_buffer: float")
+.Output("barycentric_buffer: barycentric_type")
 .Output("face_buffer: int32")
-.Output("render_buffer: float")
+.Output("render_buffer: render_type")
 
 .Output("vertex_normal: float")
 .Output("target_image_out: float")
 .Output("normal_map: float")
+.Output("culled_faces: int32")
+.Output("hiz_statistics: int32")
 
 .Attr("faces: list(int)")
 .Attr("texture_coordinates: list(float)")
@@ -30,13 +32,28 @@ REGISTER_OP("CudaRendererGpu")
 .Attr("shading_mode: string")
 .Attr("image_filter_size: int = 2")
 .Attr("texture_filter_size: int = 2")
-.Attr("compute_normal_map: bool = false");
+.Attr("compute_normal_map: bool = false")
+.Attr("topology_cache_dir: string = ''")
+.Attr("reorder_mesh: bool = false")
+.Attr("two_sided: bool = true")
+.Attr("triangle_setup: bool = true")
+.Attr("visibility_mode: string = 'packed'")
+.Attr("hierarchical_z: bool = true")
+.Attr("profile: bool = false")
+.Attr("launch_graphs: bool = false")
+.Attr("vertex_normal_layout: string = 'perCamera'")
+.Attr("render_type: {float, half, bfloat16, uint8} = DT_FLOAT")
+.Attr("barycentric_type: {float, half, uint16} = DT_FLOAT")
+.Attr("texture_type: {float, half, uint8} = DT_FLOAT")
+.Attr("texture_sampling: string = 'nearest'")
+.Attr("outputs: list(string) = ['barycentric', 'face', 'render', 'vertexNormal', 'target', 'normalMap', 'culledFaces', 'hiZStatistics']");
 
 //==============================================================================================//
 
 CudaRenderer::CudaRenderer(OpKernelConstruction* context)
 	: 
-	OpKernel(context) 
+	OpKernel(context),
+	cudaBasedRasterization(NULL)
 {
 	std::vector<int> faces;
 	OP_REQUIRES_OK(context, context->GetAttr("faces", &faces));
@@ -78,6 +95,86 @@ CudaRenderer::CudaRenderer(OpKernelConstruction* context)
 	bool computeNormal;
 	OP_REQUIRES_OK(context, context->GetAttr("compute_normal_map", &computeNormal));
 
+	std::string topologyCacheDirectory;
+	OP_REQUIRES_OK(context, context->GetAttr("topology_cache_dir", &topologyCacheDirectory));
+
+	bool reorderMesh;
+	OP_REQUIRES_OK(context, context->GetAttr("reorder_mesh", &reorderMesh));
+
+	bool twoSided;
+	OP_REQUIRES_OK(context, context->GetAttr("two_sided", &twoSided));
+
+	bool triangleSetup;
+	OP_REQUIRES_OK(context, context->GetAttr("triangle_setup", &triangleSetup));
+
+	std::string visibilityMode;
+	OP_REQUIRES_OK(context, context->GetAttr("visibility_mode", &visibilityMode));
+	OP_REQUIRES(context, visibilityMode == "packed" || visibilityMode == "quantized", errors::InvalidArgument("visibility_mode must be packed or quantized"));
+
+	bool hierarchicalZ;
+	OP_REQUIRES_OK(context, context->GetAttr("hierarchical_z", &hierarchicalZ));
+
+	bool profile;
+	OP_REQUIRES_OK(context, context->GetAttr("profile", &profile));
+
+	bool launchGraphs;
+	OP_REQUIRES_OK(context, context->GetAttr("launch_graphs", &launchGraphs));
+
+	std::string vertexNormalLayout;
+	OP_REQUIRES_OK(context, context->GetAttr("vertex_normal_layout", &vertexNormalLayout));
+	OP_REQUIRES(context, vertexNormalLayout == "perCamera" || vertexNormalLayout == "shared", errors::InvalidArgument("vertex_normal_layout must be perCamera or shared"));
+
+	//storage formats of the render and the barycentric buffer, uint8 renders are sRGB encoded and uint16 barycentrics unorm16
+	DataType renderType;
+	OP_REQUIRES_OK(context, context->GetAttr("render_type", &renderType));
+
+	DataType barycentricType;
+	OP_REQUIRES_OK(context, context->GetAttr("barycentric_type", &barycentricType));
+
+	//storage format of the texture, uint8 textures hold the image values in 1 / 255 steps
+	DataType textureType;
+	OP_REQUIRES_OK(context, context->GetAttr("texture_type", &textureType));
+
+	//nearest texel or trilinear samples of the mip pyramid of the texture
+	std::string textureSampling;
+	OP_REQUIRES_OK(context, context->GetAttr("texture_sampling", &textureSampling));
+	OP_REQUIRES(context, textureSampling == "nearest" || textureSampling == "trilinear", errors::InvalidArgument("texture_sampling must be nearest or trilinear"));
+
+	//unrequested outputs are zero sized and the kernels which only feed them are skipped
+	std::vector<std::string> outputNames;
+	OP_REQUIRES_OK(context, context->GetAttr("outputs", &outputNames));
+
+	const std::vector<std::pair<std::string, RenderOutput>> outputFlags = {
+		{ "barycentric",	RenderOutput::BarycentricOutput },
+		{ "face",			RenderOutput::FaceOutput },
+		{ "render",			RenderOutput::RenderBufferOutput },
+		{ "vertexNormal",	RenderOutput::VertexNormalOutput },
+		{ "target",			RenderOutput::TargetOutput },
+		{ "normalMap",		RenderOutput::NormalMapOutput },
+		{ "culledFaces",	RenderOutput::CulledFacesOutput },
+		{ "hiZStatistics",	RenderOutput::HiZStatisticsOutput } };
+
+	int outputs = 0;
+	for (const std::string& outputName : outputNames)
+	{
+		int flag = 0;
+		for (const std::pair<std::string, RenderOutput>& outputFlag : outputFlags)
+		{
+			if (outputFlag.first == outputName)
+				flag = outputFlag.second;
+		}
+
+		OP_REQUIRES(context, flag != 0, errors::InvalidArgument("unknown output in outputs: ", outputName));
+
+		outputs |= flag;
+	}
+
+	//the normal map is only computed on request
+	if (!computeNormal)
+	{
+		outputs &= ~RenderOutput::NormalMapOutput;
+	}
+
 	//---CONSOLE OUTPUT---
 
 	std::cout << std::endl;
@@ -115,6 +212,32 @@ CudaRenderer::CudaRenderer(OpKernelConstruction* context)
 	}
 
 	std::cout << "Compute Normal : " << computeNormal << std::endl;
+	std::cout << "Reorder mesh : " << reorderMesh << std::endl;
+	std::cout << "Two sided : " << twoSided << std::endl;
+	std::cout << "Triangle setup : " << triangleSetup << std::endl;
+	std::cout << "Visibility mode : " << visibilityMode << std::endl;
+	std::cout << "Hierarchical z : " << hierarchicalZ << std::endl;
+	std::cout << "Profile : " << profile << std::endl;
+	std::cout << "Launch graphs : " << launchGraphs << std::endl;
+	std::cout << "Vertex normal layout : " << vertexNormalLayout << std::endl;
+
+	std::cout << "Render type : " << DataTypeString(renderType) << std::endl;
+	std::cout << "Barycentric type : " << DataTypeString(barycentricType) << std::endl;
+	std::cout << "Texture type : " << DataTypeString(textureType) << std::endl;
+	std::cout << "Texture sampling : " << textureSampling << std::endl;
+
+	std::cout << "Outputs :";
+	for (const std::pair<std::string, RenderOutput>& outputFlag : outputFlags)
+	{
+		if (outputs & outputFlag.second)
+			std::cout << " " << outputFlag.first;
+	}
+	std::cout << std::endl;
+
+	if (!topologyCacheDirectory.empty())
+	{
+		std::cout << "Topology cache: " << topologyCacheDirectory << std::endl;
+	}
 	
 	/////////////////////////////////////////
 	/////////////////////////////////////////
@@ -151,7 +274,15 @@ CudaRenderer::CudaRenderer(OpKernelConstruction* context)
 	std::cout << "|||||||||||||||||||||||||||||||||||||||||||||||||||||||||" << std::endl;
 	std::cout << std::endl;
 
-	cudaBasedRasterization = new CUDABasedRasterization(faces, textureCoordinates, numberOfPoints, numberOfCameras, renderResolutionU, renderResolutionV, albedoMode, shadingMode, computeNormal);
+	cudaBasedRasterization = new CUDABasedRasterization(faces, textureCoordinates, numberOfPoints, numberOfCameras, renderResolutionU, renderResolutionV, albedoMode, shadingMode, computeNormal, reorderMesh, twoSided, triangleSetup, visibilityMode, hierarchicalZ, profile, launchGraphs, vertexNormalLayout, outputs, DataTypeString(renderType), DataTypeString(barycentricType), DataTypeString(textureType), textureSampling, topologyCacheDirectory);
+}
+
+//==============================================================================================//
+
+CudaRenderer::~CudaRenderer()
+{
+	//releases the shared mesh topology once the last forward / gradient kernel of the mesh is gone
+	delete cudaBasedRasterization;
 }
 
 //==============================================================================================//
@@ -173,10 +304,9 @@ void CudaRenderer::setupInputOutputTensorPointers(OpKernelContext* context)
 	d_inputVertexColor = inputTensorVertexColorFlat.data();
 
 	//[2]
-	//Grab the texture
+	//Grab the texture (B x H x W x 3 or the RGBA padded B x H x W x 4, in the format of texture_type)
 	const Tensor& inputTensorTexture = context->input(2);
-	Eigen::TensorMap<Eigen::Tensor< const float, 1, 1, Eigen::DenseIndex>, 16> inputTensorTextureFlat = inputTensorTexture.flat_inner_dims<float, 1>();
-	d_inputTexture = inputTensorTextureFlat.data();
+	d_inputTexture = inputTensorTexture.tensor_data().data();
 
 	//[3]
 	//Grab the sh coeffs 
@@ -207,6 +337,8 @@ void CudaRenderer::setupInputOutputTensorPointers(OpKernelContext* context)
 	numberOfBatches      = inputTensorTexture.dim_size(0);
 	textureResolutionV	 = inputTensorTexture.dim_size(1);
 	textureResolutionU   = inputTensorTexture.dim_size(2);
+	textureChannels      = inputTensorTexture.dim_size(3);
+	OP_REQUIRES(context, textureChannels == 3 || textureChannels == 4, errors::InvalidArgument("texture must have 3 (RGB) or 4 (RGBA) channels!", textureChannels));
 
 	//---OUTPUT---
 
@@ -237,7 +369,8 @@ void CudaRenderer::setupInputOutputTensorPointers(OpKernelContext* context)
 
 	std::vector<tensorflow::int64> vertexNormalDim;
 	vertexNormalDim.push_back(numberOfBatches);
-	vertexNormalDim.push_back(numberOfCameras);
+	if (cudaBasedRasterization->getNumberOfVertexNormalCopies() > 1)
+		vertexNormalDim.push_back(numberOfCameras);
 	vertexNormalDim.push_back(numberOfPoints);
 	vertexNormalDim.push_back(3);
 	tensorflow::gtl::ArraySlice<tensorflow::int64> vertexNormalDimSize(vertexNormalDim);
@@ -249,48 +382,70 @@ void CudaRenderer::setupInputOutputTensorPointers(OpKernelContext* context)
 	vertexNormalSingleDim.push_back(3);
 	tensorflow::gtl::ArraySlice<tensorflow::int64> vertexNormalSingleDimSize(vertexNormalSingleDim);
 
+	//unrequested outputs are zero sized, their device pointers are NULL
+	tensorflow::TensorShape emptyShape({ 0 });
+
 	//[0]
 	//barycentric
 	tensorflow::Tensor* outputTensorBarycentric;
-	OP_REQUIRES_OK(context, context->allocate_output(0, tensorflow::TensorShape(channel2DimSize), &outputTensorBarycentric));
-	Eigen::TensorMap<Eigen::Tensor<float, 1, 1, Eigen::DenseIndex>, 16> outputTensorBarycentricFlat = outputTensorBarycentric->flat<float>();
-	d_outputBarycentricCoordinatesBuffer = outputTensorBarycentricFlat.data();
+	bool barycentricRequested = cudaBasedRasterization->isOutputRequested(RenderOutput::BarycentricOutput);
+	OP_REQUIRES_OK(context, context->allocate_output(0, barycentricRequested ? tensorflow::TensorShape(channel2DimSize) : emptyShape, &outputTensorBarycentric));
+	d_outputBarycentricCoordinatesBuffer = barycentricRequested ? (void*)outputTensorBarycentric->tensor_data().data() : NULL;
 
 	//[1]
 	//face
 	tensorflow::Tensor* outputTensorFace;
-	OP_REQUIRES_OK(context, context->allocate_output(1, tensorflow::TensorShape(channel1DimSize), &outputTensorFace));
-	Eigen::TensorMap<Eigen::Tensor<int, 1, 1, Eigen::DenseIndex>, 16> outputTensorFaceFlat = outputTensorFace->flat<int>();
-	d_outputFaceIDBuffer = outputTensorFaceFlat.data();
+	bool faceRequested = cudaBasedRasterization->isOutputRequested(RenderOutput::FaceOutput);
+	OP_REQUIRES_OK(context, context->allocate_output(1, faceRequested ? tensorflow::TensorShape(channel1DimSize) : emptyShape, &outputTensorFace));
+	d_outputFaceIDBuffer = faceRequested ? outputTensorFace->flat<int>().data() : NULL;
 
 	//[2]
 	//render
 	tensorflow::Tensor* outputTensorRender;
-	OP_REQUIRES_OK(context, context->allocate_output(2, tensorflow::TensorShape(channel3DimSize), &outputTensorRender));
-	Eigen::TensorMap<Eigen::Tensor<float, 1, 1, Eigen::DenseIndex>, 16> outputTensorRenderFlat = outputTensorRender->flat<float>();
-	d_outputRenderBuffer = outputTensorRenderFlat.data();
+	bool renderRequested = cudaBasedRasterization->isOutputRequested(RenderOutput::RenderBufferOutput);
+	OP_REQUIRES_OK(context, context->allocate_output(2, renderRequested ? tensorflow::TensorShape(channel3DimSize) : emptyShape, &outputTensorRender));
+	d_outputRenderBuffer = renderRequested ? (void*)outputTensorRender->tensor_data().data() : NULL;
 
 	//[3]
 	//vertex normal
 	tensorflow::Tensor* outputTensorVertexNormal;
-	OP_REQUIRES_OK(context, context->allocate_output(3, tensorflow::TensorShape(vertexNormalDimSize), &outputTensorVertexNormal));
-	Eigen::TensorMap<Eigen::Tensor<float, 1, 1, Eigen::DenseIndex>, 16> outputTensorVertexNormalFlat = outputTensorVertexNormal->flat<float>();
-	d_outputVertexNormal = outputTensorVertexNormalFlat.data();
+	bool vertexNormalRequested = cudaBasedRasterization->isOutputRequested(RenderOutput::VertexNormalOutput);
+	OP_REQUIRES_OK(context, context->allocate_output(3, vertexNormalRequested ? tensorflow::TensorShape(vertexNormalDimSize) : emptyShape, &outputTensorVertexNormal));
+	d_outputVertexNormal = vertexNormalRequested ? outputTensorVertexNormal->flat<float>().data() : NULL;
 
 	//[4]
-	//target
-	tensorflow::Tensor* outputTensorTarget;
-	OP_REQUIRES_OK(context, context->allocate_output(4, tensorflow::TensorShape(channel3DimSize), &outputTensorTarget));
-	Eigen::TensorMap<Eigen::Tensor<float, 1, 1, Eigen::DenseIndex>, 16> outputTensorTargetFlat = outputTensorTarget->flat<float>();
-	d_outputTargetImage = outputTensorTargetFlat.data();
-	cutilSafeCall(cudaMemcpy(d_outputTargetImage, d_inputTargetImage, sizeof(float) * numberOfBatches * numberOfCameras * renderResolutionV * renderResolutionU * 3, cudaMemcpyDeviceToDevice));
+	//target, forwarded without a copy: the output shares the buffer of the input tensor
+	if (cudaBasedRasterization->isOutputRequested(RenderOutput::TargetOutput))
+	{
+		OP_REQUIRES(context, inputTargetImage.shape() == tensorflow::TensorShape(channel3DimSize), errors::InvalidArgument("target_image must have the shape of the render buffer"));
+		context->set_output(4, inputTargetImage);
+	}
+	else
+	{
+		tensorflow::Tensor* outputTensorTarget;
+		OP_REQUIRES_OK(context, context->allocate_output(4, emptyShape, &outputTensorTarget));
+	}
 
 	//[5]
-	//target
+	//normal map, only requested if it is computed
 	tensorflow::Tensor* outputTensorNormalMap;
-	OP_REQUIRES_OK(context, context->allocate_output(5, tensorflow::TensorShape(vertexNormalSingleDimSize), &outputTensorNormalMap));
-	Eigen::TensorMap<Eigen::Tensor<float, 1, 1, Eigen::DenseIndex>, 16> outputTensorNormalMapFlat = outputTensorNormalMap->flat<float>();
-	d_outputNormalMap = outputTensorNormalMapFlat.data();
+	bool normalMapRequested = cudaBasedRasterization->isOutputRequested(RenderOutput::NormalMapOutput);
+	OP_REQUIRES_OK(context, context->allocate_output(5, normalMapRequested ? tensorflow::TensorShape(vertexNormalSingleDimSize) : emptyShape, &outputTensorNormalMap));
+	d_outputNormalMap = normalMapRequested ? outputTensorNormalMap->flat<float>().data() : NULL;
+
+	//[6]
+	//culled faces per camera
+	tensorflow::Tensor* outputTensorCulledFaces;
+	bool culledFacesRequested = cudaBasedRasterization->isOutputRequested(RenderOutput::CulledFacesOutput);
+	OP_REQUIRES_OK(context, context->allocate_output(6, culledFacesRequested ? tensorflow::TensorShape({ numberOfBatches, numberOfCameras }) : emptyShape, &outputTensorCulledFaces));
+	d_outputCulledFaces = culledFacesRequested ? outputTensorCulledFaces->flat<int>().data() : NULL;
+
+	//[7]
+	//binned and rejected (tile, face) pairs of the hierarchical depth test per camera
+	tensorflow::Tensor* outputTensorHiZStatistics;
+	bool hiZStatisticsRequested = cudaBasedRasterization->isOutputRequested(RenderOutput::HiZStatisticsOutput);
+	OP_REQUIRES_OK(context, context->allocate_output(7, hiZStatisticsRequested ? tensorflow::TensorShape({ numberOfBatches, numberOfCameras, 2 }) : emptyShape, &outputTensorHiZStatistics));
+	d_outputHiZStatistics = hiZStatisticsRequested ? outputTensorHiZStatistics->flat<int>().data() : NULL;
 }
 
 //==============================================================================================//
@@ -302,30 +457,38 @@ void CudaRenderer::Compute(OpKernelContext* context)
 		//setup the input and output pointers of the tensor because they change from compute to compute call
 		setupInputOutputTensorPointers(context);
 
+		//a failed check in the setup only leaves the helper, so the op has to stop here
+		if (!context->status().ok())
+			return;
+
+		//all launches and copies are issued on the compute stream of the op, so they are ordered with the surrounding TF work
+		cudaBasedRasterization->setStream(context->eigen_device<Eigen::GpuDevice>().stream());
+
+		//the batch index is part of the kernel grids, so the whole batch is rendered with one launch per stage
+		cudaBasedRasterization->setNumberOfBatches(numberOfBatches);
+
 		//set input 
 		cudaBasedRasterization->setTextureWidth(textureResolutionU);
 		cudaBasedRasterization->setTextureHeight(textureResolutionV);
-
-		for (int b = 0; b < numberOfBatches; b++)
-		{
-			//set input 
-			cudaBasedRasterization->set_D_vertices(			(float3*)   d_inputVertexPos						+ b * numberOfPoints );
-			cudaBasedRasterization->set_D_vertexColors(		(float3*)	d_inputVertexColor						+ b * numberOfPoints );
-			cudaBasedRasterization->set_D_textureMap(					d_inputTexture							+ b * textureResolutionV * textureResolutionU * 3);
-			cudaBasedRasterization->set_D_shCoeff(						d_inputSHCoeff							+ b * numberOfCameras * 27);
-			cudaBasedRasterization->set_D_extrinsics(					d_inputExtrinsics						+ b * numberOfCameras * 12);
-			cudaBasedRasterization->set_D_intrinsics(					d_inputIntrinsics						+ b * numberOfCameras * 9);
-
-			//set output
-			cudaBasedRasterization->set_D_barycentricCoordinatesBuffer(	d_outputBarycentricCoordinatesBuffer	+ b * numberOfCameras * renderResolutionV * renderResolutionU * 2);
-			cudaBasedRasterization->set_D_faceIDBuffer(					d_outputFaceIDBuffer					+ b * numberOfCameras * renderResolutionV * renderResolutionU);
-			cudaBasedRasterization->set_D_renderBuffer(					d_outputRenderBuffer					+ b * numberOfCameras * renderResolutionV * renderResolutionU * 3);
-			cudaBasedRasterization->set_D_vertexNormal(		(float3*)	d_outputVertexNormal					+ b * numberOfCameras * numberOfPoints );
-			cudaBasedRasterization->set_D_normalMap(		(float3*)	d_outputNormalMap						+ b * textureResolutionU * textureResolutionV);
-
-			//render
-			cudaBasedRasterization->renderBuffers();
-		}
+		cudaBasedRasterization->setTextureChannels(textureChannels);
+		cudaBasedRasterization->set_D_vertices(			(float3*)   d_inputVertexPos);
+		cudaBasedRasterization->set_D_vertexColors(		(float3*)	d_inputVertexColor);
+		cudaBasedRasterization->set_D_textureMap(					d_inputTexture);
+		cudaBasedRasterization->set_D_shCoeff(						d_inputSHCoeff);
+		cudaBasedRasterization->set_D_extrinsics(					d_inputExtrinsics);
+		cudaBasedRasterization->set_D_intrinsics(					d_inputIntrinsics);
+
+		//set output
+		cudaBasedRasterization->set_D_barycentricCoordinatesBuffer(	d_outputBarycentricCoordinatesBuffer);
+		cudaBasedRasterization->set_D_faceIDBuffer(					d_outputFaceIDBuffer);
+		cudaBasedRasterization->set_D_renderBuffer(					d_outputRenderBuffer);
+		cudaBasedRasterization->set_D_vertexNormal(		(float3*)	d_outputVertexNormal);
+		cudaBasedRasterization->set_D_normalMap(		(float3*)	d_outputNormalMap);
+		cudaBasedRasterization->set_D_culledFaces(					d_outputCulledFaces);
+		cudaBasedRasterization->set_D_hiZStatistics(				d_outputHiZStatistics);
+
+		//render
+		cudaBasedRasterization->renderBuffers();
 	}
 
 	catch (std::exception e)
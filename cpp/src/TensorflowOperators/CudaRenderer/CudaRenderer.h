@@ -19,6 +19,9 @@
 
 #define NOMINMAX
 
+//the device of the op context exposes the compute stream
+#define EIGEN_USE_GPU
+
 //==============================================================================================//
 
 #pragma once
@@ -44,6 +47,7 @@ class CudaRenderer : public OpKernel
 	public:
 
 		explicit CudaRenderer(OpKernelConstruction* context);
+		~CudaRenderer();
 		void Compute(OpKernelContext* context);
 	
 	private:
@@ -63,6 +67,7 @@ class CudaRenderer : public OpKernel
 		int renderResolutionV;
 		int textureResolutionU;
 		int textureResolutionV;
+		int textureChannels;
 
 		std::string albedoMode;
 		std::string shadingMode;
@@ -72,7 +77,7 @@ class CudaRenderer : public OpKernel
 		//GPU input
 		const float* d_inputVertexPos;
 		const float* d_inputVertexColor;
-		const float* d_inputTexture;
+		const void*	 d_inputTexture;				//in the format of texture_type
 		const float* d_inputSHCoeff;
 		const float* d_inputTargetImage;
 
@@ -80,13 +85,14 @@ class CudaRenderer : public OpKernel
 		const float* d_inputIntrinsics;
 
 		//GPU output
-		float*	d_outputBarycentricCoordinatesBuffer;
+		void*	d_outputBarycentricCoordinatesBuffer;	//in the format of barycentric_type
 		int*	d_outputFaceIDBuffer;
-		float*	d_outputRenderBuffer;
+		void*	d_outputRenderBuffer;					//in the format of render_type
 
 		float*	d_outputVertexNormal;
-		float*	d_outputTargetImage;
 		float*	d_outputNormalMap;
+		int*	d_outputCulledFaces;
+		int*	d_outputHiZStatistics;
 };
 
 //==============================================================================================//
@@ -5,16 +5,16 @@
 
 REGISTER_OP("CudaRendererGradGpu")
 
-.Input("render_buffer_grad: float")
+.Input("render_buffer_grad: render_type")
 
 .Input("vertex_pos: float")
 .Input("vertex_color: float")
-.Input("texture: float")
+.Input("texture: texture_type")
 .Input("sh_coeff: float")
 .Input("target_image: float")
 
 .Input("vertex_normal: float")
-.Input("barycentric_buffer: float")
+.Input("barycentric_buffer: barycentric_type")
 .Input("face_buffer: int32")
 
 .Input("target_buffer_grad: float")
@@ -36,13 +36,22 @@ REGISTER_OP("CudaRendererGradGpu")
 .Attr("albedo_mode: string")
 .Attr("shading_mode: string")
 .Attr("image_filter_size: int = 2")
-.Attr("texture_filter_size: int = 2");
+.Attr("texture_filter_size: int = 2")
+.Attr("topology_cache_dir: string = ''")
+.Attr("reorder_mesh: bool = false")
+.Attr("profile: bool = false")
+.Attr("launch_graphs: bool = false")
+.Attr("render_type: {float, half, bfloat16} = DT_FLOAT")
+.Attr("barycentric_type: {float, half, uint16} = DT_FLOAT")
+.Attr("texture_type: {float, half, uint8} = DT_FLOAT")
+.Attr("texture_sampling: string = 'nearest'");
 
 //==============================================================================================//
 
 CudaRendererGrad::CudaRendererGrad(OpKernelConstruction* context)
 	: 
-	OpKernel(context) 
+	OpKernel(context),
+	cudaBasedRasterizationGrad(NULL)
 {
 	std::vector<int> faces;
 	OP_REQUIRES_OK(context, context->GetAttr("faces", &faces));
@@ -97,7 +106,42 @@ CudaRendererGrad::CudaRendererGrad(OpKernelConstruction* context)
 		return;
 	}
 
-	cudaBasedRasterizationGrad = new CUDABasedRasterizationGrad(faces, textureCoordinates, numberOfPoints, numberOfCameras, renderResolutionU, renderResolutionV, albedoMode, shadingMode, imageFilterSize, textureFilterSize);
+	std::string topologyCacheDirectory;
+	OP_REQUIRES_OK(context, context->GetAttr("topology_cache_dir", &topologyCacheDirectory));
+
+	bool reorderMesh;
+	OP_REQUIRES_OK(context, context->GetAttr("reorder_mesh", &reorderMesh));
+
+	bool profile;
+	OP_REQUIRES_OK(context, context->GetAttr("profile", &profile));
+
+	bool launchGraphs;
+	OP_REQUIRES_OK(context, context->GetAttr("launch_graphs", &launchGraphs));
+
+	//the reduced precision render gradient and barycentric buffer of the forward are read directly
+	DataType renderType;
+	OP_REQUIRES_OK(context, context->GetAttr("render_type", &renderType));
+
+	DataType barycentricType;
+	OP_REQUIRES_OK(context, context->GetAttr("barycentric_type", &barycentricType));
+
+	//the texture gradient is accumulated in float for every texture type, uint8 textures get none
+	OP_REQUIRES_OK(context, context->GetAttr("texture_type", &textureType));
+
+	//nearest texel or trilinear samples of the mip pyramid of the texture
+	std::string textureSampling;
+	OP_REQUIRES_OK(context, context->GetAttr("texture_sampling", &textureSampling));
+	OP_REQUIRES(context, textureSampling == "nearest" || textureSampling == "trilinear", errors::InvalidArgument("texture_sampling must be nearest or trilinear"));
+
+	cudaBasedRasterizationGrad = new CUDABasedRasterizationGrad(faces, textureCoordinates, numberOfPoints, numberOfCameras, renderResolutionU, renderResolutionV, albedoMode, shadingMode, imageFilterSize, textureFilterSize, reorderMesh, profile, launchGraphs, DataTypeString(renderType), DataTypeString(barycentricType), DataTypeString(textureType), textureSampling, topologyCacheDirectory);
+}
+
+//==============================================================================================//
+
+CudaRendererGrad::~CudaRendererGrad()
+{
+	//releases the shared mesh topology once the last forward / gradient kernel of the mesh is gone
+	delete cudaBasedRasterizationGrad;
 }
 
 //==============================================================================================//
@@ -112,9 +156,9 @@ void CudaRendererGrad::setupInputOutputTensorPointers(OpKernelContext* context)
 
 	//[0]
 	//Grab the vertec color buffer gradients 
+	//the gradient of an output that was not requested is empty, the backward pass skips its terms
 	const Tensor& inputTensorRenderBufferGrad = context->input(0);
-	Eigen::TensorMap<Eigen::Tensor< const float, 1, 1, Eigen::DenseIndex>, 16> inputTensorRenderBufferGradFlat = inputTensorRenderBufferGrad.flat_inner_dims<float, 1>();
-	d_inputRenderBufferGrad = inputTensorRenderBufferGradFlat.data();
+	d_inputRenderBufferGrad = inputTensorRenderBufferGrad.NumElements() > 0 ? inputTensorRenderBufferGrad.tensor_data().data() : NULL;
 
 	/////////////
 	//INPUT FROM INPUT OF FORWARD
@@ -133,10 +177,9 @@ void CudaRendererGrad::setupInputOutputTensorPointers(OpKernelContext* context)
 	d_inputVertexColor = inputTensorVertexColorFlat.data();
 
 	//[3]
-	//Grab the texture
+	//Grab the texture (B x H x W x 3 or the RGBA padded B x H x W x 4, in the format of texture_type)
 	const Tensor& inputTensorTexture = context->input(3);
-	Eigen::TensorMap<Eigen::Tensor< const float, 1, 1, Eigen::DenseIndex>, 16> inputTensorTextureFlat = inputTensorTexture.flat_inner_dims<float, 1>();
-	d_inputTexture = inputTensorTextureFlat.data();
+	d_inputTexture = inputTensorTexture.tensor_data().data();
 
 	//[4]
 	//Grab the sh coeffs 
@@ -160,11 +203,13 @@ void CudaRendererGrad::setupInputOutputTensorPointers(OpKernelContext* context)
 	Eigen::TensorMap<Eigen::Tensor< const float, 1, 1, Eigen::DenseIndex>, 16> inputTensorVertexNormalFlat = inputTensorVertexNormal.flat_inner_dims<float, 1>();
 	d_inputVertexNormal = inputTensorVertexNormalFlat.data();
 
+	//B x C x N x 3 in the per camera layout of the forward, B x N x 3 in the shared one
+	numberOfVertexNormalCopies = inputTensorVertexNormal.dims() == 4 ? numberOfCameras : 1;
+
 	//[7]
 	//Grab the barycentric co-ordinates 
 	const Tensor& inputTensorBaryCentricBuffer= context->input(7);
-	Eigen::TensorMap<Eigen::Tensor< const float, 1, 1, Eigen::DenseIndex>, 16> inputTensorBaryCentricBufferFlat = inputTensorBaryCentricBuffer.flat_inner_dims<float, 1>();
-	d_inputBaryCentricBuffer = inputTensorBaryCentricBufferFlat.data();
+	d_inputBaryCentricBuffer = inputTensorBaryCentricBuffer.tensor_data().data();
 
 	//[8]
 	//Grab the face id buffer  
@@ -176,7 +221,7 @@ void CudaRendererGrad::setupInputOutputTensorPointers(OpKernelContext* context)
 	//target buffer grad
 	const Tensor& inputTensorTargetGrad = context->input(9);
 	Eigen::TensorMap<Eigen::Tensor< const float, 1, 1, Eigen::DenseIndex>, 16> inputTensorTargetGradFlat = inputTensorTargetGrad.flat_inner_dims<float, 1>();
-	d_inputTargetImageGrad = inputTensorTargetGradFlat.data();
+	d_inputTargetImageGrad = inputTensorTargetGrad.NumElements() > 0 ? inputTensorTargetGradFlat.data() : NULL;
 
 	//[10]
 	//Grab the extrinsics
@@ -195,6 +240,8 @@ void CudaRendererGrad::setupInputOutputTensorPointers(OpKernelContext* context)
 	numberOfBatches      = inputTensorVertexPos.dim_size(0); 
 	textureResolutionV   = inputTensorTexture.dim_size(1);
 	textureResolutionU   = inputTensorTexture.dim_size(2);
+	textureChannels      = inputTensorTexture.dim_size(3);
+	OP_REQUIRES(context, textureChannels == 3 || textureChannels == 4, errors::InvalidArgument("texture must have 3 (RGB) or 4 (RGBA) channels!", textureChannels));
 
 	//---OUTPUT---
 
@@ -205,11 +252,19 @@ void CudaRendererGrad::setupInputOutputTensorPointers(OpKernelContext* context)
 	vertexDim.push_back(3);
 	tensorflow::gtl::ArraySlice<tensorflow::int64> vertexDimSize(vertexDim);
 
+	//in the channel layout of the texture, zero sized for uint8 textures
 	std::vector<tensorflow::int64> texDim;
-	texDim.push_back(numberOfBatches);
-	texDim.push_back(textureResolutionV);
-	texDim.push_back(textureResolutionU);
-	texDim.push_back(3);
+	if (textureType != DT_UINT8)
+	{
+		texDim.push_back(numberOfBatches);
+		texDim.push_back(textureResolutionV);
+		texDim.push_back(textureResolutionU);
+		texDim.push_back(textureChannels);
+	}
+	else
+	{
+		texDim.push_back(0);
+	}
 	tensorflow::gtl::ArraySlice<tensorflow::int64> texDimSize(texDim);
 
 	std::vector<tensorflow::int64> shDim;
@@ -237,7 +292,7 @@ void CudaRendererGrad::setupInputOutputTensorPointers(OpKernelContext* context)
 	tensorflow::Tensor* outputTensorTextureGrad;
 	OP_REQUIRES_OK(context, context->allocate_output(2, tensorflow::TensorShape(texDimSize), &outputTensorTextureGrad));
 	Eigen::TensorMap<Eigen::Tensor<float, 1, 1, Eigen::DenseIndex>, 16> outputTensorTextureGradFlat = outputTensorTextureGrad->flat<float>();
-	d_outputTextureGrad = outputTensorTextureGradFlat.data();
+	d_outputTextureGrad = textureType != DT_UINT8 ? outputTensorTextureGradFlat.data() : NULL;
 
 	//[3]
 	//sh coeff gradients
@@ -256,35 +311,44 @@ void CudaRendererGrad::Compute(OpKernelContext* context)
 		//setup the input and output pointers of the tensor because they change from compute to compute call
 		setupInputOutputTensorPointers(context);
 
-		for (int b = 0; b < numberOfBatches; b++)
-		{
-			//set input 
-			cudaBasedRasterizationGrad->setTextureWidth(textureResolutionU);
-			cudaBasedRasterizationGrad->setTextureHeight(textureResolutionV);
-			cudaBasedRasterizationGrad->set_D_RenderBufferGrad(				(float3*)			d_inputRenderBufferGrad					+ b * numberOfCameras * renderResolutionV * renderResolutionU);
-			cudaBasedRasterizationGrad->set_D_TargetBufferGrad(				(float3*)			d_inputTargetImageGrad					+ b * numberOfCameras * renderResolutionV * renderResolutionU);
-			cudaBasedRasterizationGrad->set_D_vertices(						(float3*)			d_inputVertexPos						+ b * numberOfPoints);
-			cudaBasedRasterizationGrad->set_D_vertexColors(					(float3*)			d_inputVertexColor						+ b * numberOfPoints);
-			cudaBasedRasterizationGrad->set_D_textureMap(										d_inputTexture							+ b * textureResolutionV * textureResolutionU * 3);
+		//a failed check in the setup only leaves the helper, so the op has to stop here
+		if (!context->status().ok())
+			return;
+
+		//all launches are issued on the compute stream of the op, so they are ordered with the surrounding TF work
+		cudaBasedRasterizationGrad->setStream(context->eigen_device<Eigen::GpuDevice>().stream());
+
+		//the batch index is part of the kernel grids, all gradients are zeroed once and computed with one launch
+		cudaBasedRasterizationGrad->setNumberOfBatches(numberOfBatches);
+		cudaBasedRasterizationGrad->setNumberOfVertexNormalCopies(numberOfVertexNormalCopies);
+
+		//set input 
+		cudaBasedRasterizationGrad->setTextureWidth(textureResolutionU);
+		cudaBasedRasterizationGrad->setTextureHeight(textureResolutionV);
+		cudaBasedRasterizationGrad->setTextureChannels(textureChannels);
+		cudaBasedRasterizationGrad->set_D_RenderBufferGrad(									d_inputRenderBufferGrad);
+		cudaBasedRasterizationGrad->set_D_TargetBufferGrad(				(float3*)			d_inputTargetImageGrad);
+		cudaBasedRasterizationGrad->set_D_vertices(						(float3*)			d_inputVertexPos);
+		cudaBasedRasterizationGrad->set_D_vertexColors(					(float3*)			d_inputVertexColor);
+		cudaBasedRasterizationGrad->set_D_textureMap(										d_inputTexture);
 	
-			cudaBasedRasterizationGrad->set_D_shCoeff(											d_inputSHCoeff							+ b * numberOfCameras * 27);
-			cudaBasedRasterizationGrad->set_D_vertexNormal(					(float3*)			d_inputVertexNormal						+ b * numberOfCameras * numberOfPoints);
-			cudaBasedRasterizationGrad->set_D_barycentricCoordinatesBuffer( (float2 *)			d_inputBaryCentricBuffer				+ b * numberOfCameras * renderResolutionV * renderResolutionU);
+		cudaBasedRasterizationGrad->set_D_shCoeff(											d_inputSHCoeff);
+		cudaBasedRasterizationGrad->set_D_vertexNormal(					(float3*)			d_inputVertexNormal);
+		cudaBasedRasterizationGrad->set_D_barycentricCoordinatesBuffer(						d_inputBaryCentricBuffer);
 			
-			cudaBasedRasterizationGrad->set_D_faceIDBuffer(					(int*)				d_inputFaceBuffer						+ b * numberOfCameras * renderResolutionV * renderResolutionU);
-			cudaBasedRasterizationGrad->set_D_targetImage(										d_inputTargetImage						+ b * numberOfCameras * renderResolutionV * renderResolutionU * 3);
-			cudaBasedRasterizationGrad->set_D_extrinsics(										d_inputExtrinsics						+ b * numberOfCameras * 12);
-			cudaBasedRasterizationGrad->set_D_intrinsics(										d_inputIntrinsics						+ b * numberOfCameras * 9);
+		cudaBasedRasterizationGrad->set_D_faceIDBuffer(					(int*)				d_inputFaceBuffer);
+		cudaBasedRasterizationGrad->set_D_targetImage(										d_inputTargetImage);
+		cudaBasedRasterizationGrad->set_D_extrinsics(										d_inputExtrinsics);
+		cudaBasedRasterizationGrad->set_D_intrinsics(										d_inputIntrinsics);
 			
-			//set output
-			cudaBasedRasterizationGrad->set_D_vertexPosGrad(				(float3*)			d_outputVertexPosGrad					+ b * numberOfPoints);
-			cudaBasedRasterizationGrad->set_D_vertexColorGrad(				(float3*)			d_outputVertexColorGrad					+ b * numberOfPoints);
-			cudaBasedRasterizationGrad->set_D_textureGrad(					(float3*)			d_outputTextureGrad						+ b * textureResolutionU * textureResolutionV);
-			cudaBasedRasterizationGrad->set_D_shCoeffGrad(					(float*)			d_outputSHCoeffGrad						+ b * numberOfCameras * 27);
-
-			//get gradients
-			cudaBasedRasterizationGrad->renderBuffersGrad();
-		}
+		//set output
+		cudaBasedRasterizationGrad->set_D_vertexPosGrad(				(float3*)			d_outputVertexPosGrad);
+		cudaBasedRasterizationGrad->set_D_vertexColorGrad(				(float3*)			d_outputVertexColorGrad);
+		cudaBasedRasterizationGrad->set_D_textureGrad(										d_outputTextureGrad);
+		cudaBasedRasterizationGrad->set_D_shCoeffGrad(					(float*)			d_outputSHCoeffGrad);
+
+		//get gradients
+		cudaBasedRasterizationGrad->renderBuffersGrad();
 	}
 	catch (std::exception e)
 	{
@@ -19,6 +19,9 @@
 
 #define NOMINMAX
 
+//the device of the op context exposes the compute stream
+#define EIGEN_USE_GPU
+
 //==============================================================================================//
 
 #pragma once
@@ -44,6 +47,7 @@ class CudaRendererGrad : public OpKernel
 	public:
 
 		explicit CudaRendererGrad(OpKernelConstruction* context);
+		~CudaRendererGrad();
 		void Compute(OpKernelContext* context);
 	
 	private:
@@ -63,19 +67,22 @@ class CudaRendererGrad : public OpKernel
 		int renderResolutionV;
 		int textureResolutionU;
 		int textureResolutionV;
+		int textureChannels;
+		int numberOfVertexNormalCopies;
 		std::string albedoMode;
 		std::string shadingMode;
+		DataType textureType;
 
 		CUDABasedRasterizationGrad* cudaBasedRasterizationGrad;
 
 		//GPU input
-		const float* d_inputRenderBufferGrad;
+		const void*	 d_inputRenderBufferGrad;		//in the format of render_type
 		const float* d_inputVertexPos;
 		const float* d_inputVertexColor;
-		const float* d_inputTexture;
+		const void*	 d_inputTexture;				//in the format of texture_type
 		const float* d_inputSHCoeff;
 		const float* d_inputVertexNormal;
-		const float* d_inputBaryCentricBuffer;
+		const void*	 d_inputBaryCentricBuffer;		//in the format of barycentric_type
 		const int*   d_inputFaceBuffer;
 		const float* d_inputTargetImage;
 		const float* d_inputTargetImageGrad;
@@ -86,7 +93,7 @@ class CudaRendererGrad : public OpKernel
 		//GPU output
 		float*	d_outputVertexPosGrad;
 		float*	d_outputVertexColorGrad;
-		float*  d_outputTextureGrad;
+		float*  d_outputTextureGrad;			//float for every texture_type, NULL for uint8 textures
 		float*	d_outputSHCoeffGrad;
 
 };
@@ -0,0 +1,89 @@
+#include "CudaRendererReference.h"
+
+//==============================================================================================//
+
+REGISTER_OP("CudaRendererReferenceCpu")
+
+.Input("vertex_pos: float")
+.Input("extrinsics: float")
+.Input("intrinsics: float")
+
+.Output("barycentric_buffer: float")
+.Output("face_buffer: int32")
+
+.Attr("faces: list(int)")
+.Attr("number_of_vertices: int")
+.Attr("number_of_cameras: int")
+.Attr("render_resolution_u: int = 512")
+.Attr("render_resolution_v: int = 512")
+.Attr("triangle_setup: bool = true")
+.Attr("visibility_mode: string = 'packed'");
+
+//==============================================================================================//
+
+CudaRendererReference::CudaRendererReference(OpKernelConstruction* context)
+	: 
+	OpKernel(context) 
+{
+	OP_REQUIRES_OK(context, context->GetAttr("faces", &faces));
+
+	OP_REQUIRES_OK(context, context->GetAttr("number_of_vertices", &numberOfPoints));
+	OP_REQUIRES(context, numberOfPoints > 0, errors::InvalidArgument("number_of_vertices not set!", numberOfPoints));
+
+	OP_REQUIRES_OK(context, context->GetAttr("number_of_cameras", &numberOfCameras));
+	OP_REQUIRES(context, numberOfCameras > 0, errors::InvalidArgument("number_of_cameras not set!", numberOfCameras));
+
+	OP_REQUIRES_OK(context, context->GetAttr("render_resolution_u", &renderResolutionU));
+	OP_REQUIRES(context, renderResolutionU > 0, errors::InvalidArgument("render_resolution_u not set!", renderResolutionU));
+
+	OP_REQUIRES_OK(context, context->GetAttr("render_resolution_v", &renderResolutionV));
+	OP_REQUIRES(context, renderResolutionV > 0, errors::InvalidArgument("render_resolution_v not set!", renderResolutionV));
+
+	OP_REQUIRES_OK(context, context->GetAttr("triangle_setup", &triangleSetup));
+
+	std::string visibility;
+	OP_REQUIRES_OK(context, context->GetAttr("visibility_mode", &visibility));
+	OP_REQUIRES(context, visibility == "packed" || visibility == "quantized", errors::InvalidArgument("visibility_mode must be packed or quantized"));
+	visibilityMode = visibility == "quantized" ? VisibilityMode::Quantized : VisibilityMode::Packed;
+}
+
+//==============================================================================================//
+
+void CudaRendererReference::Compute(OpKernelContext* context)
+{
+	//---INPUT---
+
+	const float* vertexPos	= context->input(0).flat<float>().data();
+	const float* extrinsics = context->input(1).flat<float>().data();
+	const float* intrinsics = context->input(2).flat<float>().data();
+
+	int numberOfBatches = context->input(0).dim_size(0);
+
+	//---OUTPUT---
+
+	tensorflow::Tensor* outputTensorBarycentric;
+	OP_REQUIRES_OK(context, context->allocate_output(0, tensorflow::TensorShape({ numberOfBatches, numberOfCameras, renderResolutionV, renderResolutionU, 2 }), &outputTensorBarycentric));
+	float* barycentricCoordinatesBuffer = outputTensorBarycentric->flat<float>().data();
+
+	tensorflow::Tensor* outputTensorFace;
+	OP_REQUIRES_OK(context, context->allocate_output(1, tensorflow::TensorShape({ numberOfBatches, numberOfCameras, renderResolutionV, renderResolutionU }), &outputTensorFace));
+	int* faceIDBuffer = outputTensorFace->flat<int>().data();
+
+	//---RENDER---
+
+	for (int b = 0; b < numberOfBatches; b++)
+	{
+		rasterizeReference(faces, numberOfPoints, numberOfCameras, renderResolutionU, renderResolutionV,
+			vertexPos							+ b * numberOfPoints * 3,
+			extrinsics							+ b * numberOfCameras * 12,
+			intrinsics							+ b * numberOfCameras * 9,
+			triangleSetup,
+			visibilityMode,
+			faceIDBuffer						+ b * numberOfCameras * renderResolutionV * renderResolutionU,
+			barycentricCoordinatesBuffer		+ b * numberOfCameras * renderResolutionV * renderResolutionU * 2);
+	}
+}
+
+//==============================================================================================//
+
+REGISTER_KERNEL_BUILDER(Name("CudaRendererReferenceCpu").Device(DEVICE_CPU), CudaRendererReference);
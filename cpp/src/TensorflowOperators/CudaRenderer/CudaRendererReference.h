@@ -0,0 +1,64 @@
+//==============================================================================================//
+// Classname:
+//      CudaRendererReference
+//
+//==============================================================================================//
+// Description:
+//      CPU reference of the barycentric and face buffers of CudaRendererGpu for testing
+//		(see RasterizationReference)
+//
+//==============================================================================================//
+// Input:
+//		vertex_pos [B, N, 3], extrinsics [B, C, 12], intrinsics [B, C, 9]
+//		faces, number_of_vertices, number_of_cameras, render_resolution_u, render_resolution_v, triangle_setup, visibility_mode (attr)
+//
+//==============================================================================================//
+// Output:
+//		barycentric_buffer [B, C, V, U, 2], face_buffer [B, C, V, U]
+//
+//==============================================================================================//
+
+#define NOMINMAX
+
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+#include "../../Renderer/RasterizationReference.h"
+
+//==============================================================================================//
+
+using namespace tensorflow;
+
+//==============================================================================================//
+
+class CudaRendererReference : public OpKernel 
+{
+	//functions
+
+	public:
+
+		explicit CudaRendererReference(OpKernelConstruction* context);
+		void Compute(OpKernelContext* context);
+
+	//variables
+
+	private:
+
+		std::vector<int> faces;
+
+		int numberOfPoints;
+		int numberOfCameras;
+		int renderResolutionU;
+		int renderResolutionV;
+		bool triangleSetup;
+		VisibilityMode visibilityMode;
+};
+
+//==============================================================================================//
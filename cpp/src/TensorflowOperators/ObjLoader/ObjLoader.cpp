@@ -0,0 +1,79 @@
+#include "ObjLoader.h"
+
+//==============================================================================================//
+
+REGISTER_OP("ObjLoaderCpu")
+
+.Output("vertex_coordinates: float")
+.Output("vertex_colors: float")
+.Output("faces: int32")
+.Output("texture_coordinates: float")
+.Output("vertex_neighbours: int32")
+.Output("vertex_neighbours_id: int32")
+.Output("texture_map_path: string")
+
+.Attr("filename: string");
+
+//==============================================================================================//
+
+ObjLoader::ObjLoader(OpKernelConstruction* context)
+	: 
+	OpKernel(context) 
+{
+	std::string filename;
+	OP_REQUIRES_OK(context, context->GetAttr("filename", &filename));
+
+	//---CONSOLE OUTPUT---
+
+	std::cout << std::endl;
+	std::cout << "|||||||||||||||||||||||||||||||||||||||||||||||||||||||||" << std::endl;
+	std::cout << std::endl;
+
+	std::cout << "OPERATOR: ObjLoader" << std::endl;
+	std::cout << "Filename: " << filename << std::endl;
+
+	std::cout << std::endl;
+	std::cout << "|||||||||||||||||||||||||||||||||||||||||||||||||||||||||" << std::endl;
+	std::cout << std::endl;
+
+	OP_REQUIRES(context, loadOBJ(filename, mesh), errors::InvalidArgument("Could not load OBJ file ", filename));
+}
+
+//==============================================================================================//
+
+template <class T>
+void ObjLoader::copyToOutput(OpKernelContext* context, int outputId, const std::vector<T>& values, const std::vector<tensorflow::int64>& dimensions)
+{
+	tensorflow::gtl::ArraySlice<tensorflow::int64> dimensionSize(dimensions);
+
+	tensorflow::Tensor* outputTensor;
+	OP_REQUIRES_OK(context, context->allocate_output(outputId, tensorflow::TensorShape(dimensionSize), &outputTensor));
+	std::copy(values.begin(), values.end(), outputTensor->flat<T>().data());
+}
+
+//==============================================================================================//
+
+void ObjLoader::Compute(OpKernelContext* context)
+{
+	int N = mesh.numberOfVertices;
+	int F = mesh.numberOfFaces;
+	int E = mesh.vertexNeighbours.size();
+
+	//[0] - [5]
+	copyToOutput(context, 0, mesh.vertexCoordinates,	{ N, 3 });
+	copyToOutput(context, 1, mesh.vertexColors,			{ N, 3 });
+	copyToOutput(context, 2, mesh.faces,				{ 3 * F });
+	copyToOutput(context, 3, mesh.textureCoordinates,	{ 6 * F });
+	copyToOutput(context, 4, mesh.vertexNeighbours,		{ E });
+	copyToOutput(context, 5, mesh.vertexNeighboursId,	{ N, 2 });
+
+	//[6]
+	//texture map path
+	tensorflow::Tensor* outputTensorTextureMapPath;
+	OP_REQUIRES_OK(context, context->allocate_output(6, tensorflow::TensorShape({}), &outputTensorTextureMapPath));
+	outputTensorTextureMapPath->scalar<tstring>()() = mesh.textureMapPath;
+}
+
+//==============================================================================================//
+
+REGISTER_KERNEL_BUILDER(Name("ObjLoaderCpu").Device(DEVICE_CPU), ObjLoader);
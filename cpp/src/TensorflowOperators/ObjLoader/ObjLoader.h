@@ -0,0 +1,62 @@
+//==============================================================================================//
+// Classname:
+//      ObjLoader
+//
+//==============================================================================================//
+// Description:
+//      Loads an OBJ file (and the texture map path of its material library) with the native
+//		MeshLoader. The file is parsed once when the kernel is constructed.
+//
+//==============================================================================================//
+// Input:
+//		filename (attr)
+//
+//==============================================================================================//
+// Output:
+//		vertex_coordinates [N, 3], vertex_colors [N, 3], faces [3F], texture_coordinates [6F],
+//		vertex_neighbours [E], vertex_neighbours_id [N, 2], texture_map_path []
+//
+//==============================================================================================//
+
+#define NOMINMAX
+
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+#include "../../Renderer/MeshLoader.h"
+
+//==============================================================================================//
+
+using namespace tensorflow;
+
+//==============================================================================================//
+
+class ObjLoader : public OpKernel 
+{
+	//functions
+
+	public:
+
+		explicit ObjLoader(OpKernelConstruction* context);
+		void Compute(OpKernelContext* context);
+
+	private:
+
+		template <class T>
+		void copyToOutput(OpKernelContext* context, int outputId, const std::vector<T>& values, const std::vector<tensorflow::int64>& dimensions);
+
+	//variables
+
+	private:
+
+		OBJMesh mesh;
+};
+
+//==============================================================================================//
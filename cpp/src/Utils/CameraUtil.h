@@ -138,7 +138,7 @@ __inline__ __device__ float2 projectPointFloat(float3* intrinsicMatrix, float3 p
 
 //==============================================================================================//
 
-__inline__ __device__ float3 projectPointFloat3(float3* intrinsicMatrix, float3 point)
+__inline__ __host__ __device__ float3 projectPointFloat3(float3* intrinsicMatrix, float3 point)
 {
 	float3 row1 = intrinsicMatrix[0];
 	float3 row2 = intrinsicMatrix[1];
@@ -171,7 +171,7 @@ __inline__ __device__ float3 projectPointFloat3(float3* intrinsicMatrix, float3
 
 //==============================================================================================//
 
-__inline__ __device__ float3 getCamSpacePoint(float4* extrinsicMatrix, float3 point)
+__inline__ __host__ __device__ float3 getCamSpacePoint(float4* extrinsicMatrix, float3 point)
 {
 	//get vertex in cam space
 	float4 homogCamSpaceVertex = make_float4(point.x, point.y, point.z, 1.f);
@@ -220,7 +220,7 @@ __inline__ __device__ float3 backprojectPixelCuda(float3 p, int cameraId, float4
 
 //==============================================================================================//
 
-__inline__ __device__ float3 backprojectPixelCuda(float3 p, float4* invCamProj)
+__inline__ __host__ __device__ float3 backprojectPixelCuda(float3 p, float4* invCamProj)
 {
 	const float3 tp = make_float3(p.x * p.z, p.y * p.z, p.z);
 	float4 tpHomo = make_float4(tp.x, tp.y, tp.z, 1.f);
@@ -248,7 +248,7 @@ __inline__ __device__ void getRayCuda(float2& p, float3& ro, float3& rd, int cam
 
 //==============================================================================================//
 
-__inline__ __device__ void getRayCuda2(float2& p, float3& ro, float3& rd, float4* invCamExtrinsics, float4* invCamProj)
+__inline__ __host__ __device__ void getRayCuda2(float2& p, float3& ro, float3& rd, float4* invCamExtrinsics, float4* invCamProj)
 {
 	float4 o = make_float4(invCamExtrinsics[0].w, invCamExtrinsics[1].w, invCamExtrinsics[2].w, invCamExtrinsics[3].w);
 	o /= o.w;
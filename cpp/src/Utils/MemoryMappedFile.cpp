@@ -0,0 +1,140 @@
+//==============================================================================================//
+
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+//==============================================================================================//
+
+MemoryMappedFile::MemoryMappedFile()
+	:
+	data(NULL),
+	size(0),
+#ifdef _WIN32
+	fileHandle(INVALID_HANDLE_VALUE),
+	mappingHandle(NULL)
+#else
+	fileDescriptor(-1)
+#endif
+{
+}
+
+//==============================================================================================//
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	close();
+}
+
+//==============================================================================================//
+
+bool MemoryMappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL)
+	{
+		close();
+		return false;
+	}
+
+	data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	size = (size_t)fileSize.QuadPart;
+
+#else
+
+	fileDescriptor = ::open(path.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* mapping = mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	data = (const char*)mapping;
+	size = fileStatus.st_size;
+
+#endif
+
+	if (data == NULL)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+//==============================================================================================//
+
+void MemoryMappedFile::close()
+{
+#ifdef _WIN32
+
+	if (data != NULL)
+		UnmapViewOfFile(data);
+
+	if (mappingHandle != NULL)
+		CloseHandle(mappingHandle);
+
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+
+	mappingHandle	= NULL;
+	fileHandle		= INVALID_HANDLE_VALUE;
+
+#else
+
+	if (data != NULL)
+		munmap((void*)data, size);
+
+	if (fileDescriptor >= 0)
+		::close(fileDescriptor);
+
+	fileDescriptor = -1;
+
+#endif
+
+	data = NULL;
+	size = 0;
+}
+
+//==============================================================================================//
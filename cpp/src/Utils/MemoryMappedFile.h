@@ -0,0 +1,59 @@
+//==============================================================================================//
+// Classname:
+//      MemoryMappedFile
+//
+//==============================================================================================//
+// Description:
+//      Read only memory mapping of a whole file (mmap on Linux, file mapping on Windows).
+//		The mapping stays valid until the object is destroyed.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <string>
+#include <stddef.h>
+
+//==============================================================================================//
+
+class MemoryMappedFile
+{
+	//functions
+
+	public:
+
+		MemoryMappedFile();
+		~MemoryMappedFile();
+
+		//returns false if the file does not exist or cannot be mapped
+		bool					open(const std::string& path);
+		void					close();
+
+		//getter
+		inline bool				isOpen()									{ return data != NULL; };
+		inline const char*		getData()									{ return data; };
+		inline size_t			getSize()									{ return size; };
+
+	private:
+
+		MemoryMappedFile(const MemoryMappedFile&);
+		MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+	//variables
+
+	private:
+
+		const char*				data;
+		size_t					size;
+
+#ifdef _WIN32
+		void*					fileHandle;
+		void*					mappingHandle;
+#else
+		int						fileDescriptor;
+#endif
+};
+
+//==============================================================================================//
@@ -23,7 +23,7 @@
 /*
 Computes the ray triangle intersection and returns the barycentric coordinates
 */
-inline __device__  bool rayTriangleIntersect(float3 orig, float3 dir, float3 v0, float3 v1, float3 v2, float &t, float &a, float &b)
+inline __host__ __device__ bool rayTriangleIntersect(float3 orig, float3 dir, float3 v0, float3 v1, float3 v2, float &t, float &a, float &b)
 {
 	//just to make it numerically more stable
 	v0 = v0 / 1000.f;
@@ -103,17 +103,10 @@ inline __device__  bool rayTriangleIntersect(float3 orig, float3 dir, float3 v0,
 //==============================================================================================//
 
 /*
-Computes the per pixel barycentric coordinates
+Computes the barycentric coordinates of the intersection of a ray with a triangle, (-1, -1, -1) if the ray misses it
 */
-inline __device__ float3 uv2barycentric(float u, float v, float3 v0, float3 v1, float3 v2, float4* invExtrinsics, float4* invProjection)
+inline __host__ __device__ float3 ray2barycentric(float3 o, float3 d, float3 v0, float3 v1, float3 v2)
 {
-	float3 o = make_float3(0.f, 0.f, 0.f);
-	float3 d = make_float3(0.f, 0.f, 0.f);
-
-	float2 pixelPos = make_float2(u, v);
-
-	getRayCuda2(pixelPos, o, d, invExtrinsics, invProjection);
-
 	float t, a, b, c;
 
 	bool intersect;
@@ -129,6 +122,119 @@ inline __device__ float3 uv2barycentric(float u, float v, float3 v0, float3 v1,
 
 //==============================================================================================//
 
+/*
+Computes the per pixel barycentric coordinates
+*/
+inline __host__ __device__ float3 uv2barycentric(float u, float v, float3 v0, float3 v1, float3 v2, float4* invExtrinsics, float4* invProjection)
+{
+	float3 o = make_float3(0.f, 0.f, 0.f);
+	float3 d = make_float3(0.f, 0.f, 0.f);
+
+	float2 pixelPos = make_float2(u, v);
+
+	getRayCuda2(pixelPos, o, d, invExtrinsics, invProjection);
+
+	return ray2barycentric(o, d, v0, v1, v2);
+}
+
+//==============================================================================================//
+
+/*
+Computes the inverse extrinsics and the inverse projection (intrinsics * extrinsics) of a camera as 4 rows each
+*/
+inline __host__ __device__ void computeInverseCameraMatrices(const float4* extrinsics, const float3* intrinsics, float4* inverseExtrinsics, float4* inverseProjection)
+{
+	float4x4 h_intrinsics;
+	float4x4 h_extrinsics;
+
+	h_extrinsics.setIdentity();
+	h_intrinsics.setIdentity();
+
+	for (int row = 0; row < 3; row++)
+	{
+		h_intrinsics(row, 0) = intrinsics[row].x;
+		h_intrinsics(row, 1) = intrinsics[row].y;
+		h_intrinsics(row, 2) = intrinsics[row].z;
+		h_intrinsics(row, 3) = 0.f;
+
+		h_extrinsics(row, 0) = extrinsics[row].x;
+		h_extrinsics(row, 1) = extrinsics[row].y;
+		h_extrinsics(row, 2) = extrinsics[row].z;
+		h_extrinsics(row, 3) = extrinsics[row].w;
+	}
+
+	float4x4 h_inExtrinsics = h_extrinsics.getInverse();
+	float4x4 h_invProjection = (h_intrinsics * h_extrinsics).getInverse();
+
+	for (int row = 0; row < 4; row++)
+	{
+		inverseExtrinsics[row].x = h_inExtrinsics(row, 0);
+		inverseExtrinsics[row].y = h_inExtrinsics(row, 1);
+		inverseExtrinsics[row].z = h_inExtrinsics(row, 2);
+		inverseExtrinsics[row].w = h_inExtrinsics(row, 3);
+
+		inverseProjection[row].x = h_invProjection(row, 0);
+		inverseProjection[row].y = h_invProjection(row, 1);
+		inverseProjection[row].z = h_invProjection(row, 2);
+		inverseProjection[row].w = h_invProjection(row, 3);
+	}
+}
+
+//==============================================================================================//
+
+/*
+Computes the pixel bounding box (minU, minV, maxU, maxV) of a projected triangle, the box is empty if minU > maxU or minV > maxV.
+The outer clamps only keep the float to int conversion in range, boxes outside of the image stay empty.
+*/
+inline __host__ __device__ int4 computeFaceBoundingBox(float3 i_v0, float3 i_v1, float3 i_v2, int w, int h)
+{
+	int4 bbox;
+	bbox.x = fminf(fmaxf(fminf(i_v0.x, fminf(i_v1.x, i_v2.x)) - 0.5f, 0), w);  //minx
+	bbox.y = fminf(fmaxf(fminf(i_v0.y, fminf(i_v1.y, i_v2.y)) - 0.5f, 0), h);  //miny
+
+	bbox.z = fmaxf(fminf(fmaxf(i_v0.x, fmaxf(i_v1.x, i_v2.x)) + 0.5f, w - 1), -1);   //maxx
+	bbox.w = fmaxf(fminf(fmaxf(i_v0.y, fmaxf(i_v1.y, i_v2.y)) + 0.5f, h - 1), -1);  //maxy
+	return bbox;
+}
+
+//==============================================================================================//
+
+/*
+Tests the ray through a pixel center (see CameraSetup) against a triangle given by its world space vertices and projected depths.
+Returns true if the pixel is covered and outputs the barycentric coordinates and the depth.
+*/
+inline __host__ __device__ bool rasterizeFacePixel(float3 rayOrigin, float3 rayDirection, float3 v0, float3 v1, float3 v2, float3 projectedDepth, float3& abc, float& depth)
+{
+	abc = ray2barycentric(rayOrigin, rayDirection, v0, v1, v2);
+
+	bool isInsideTriangle = (abc.x >= -0.001f) && (abc.y >= -0.001f) && (abc.z >= -0.001f) && (abc.x <= 1.001f) && (abc.y <= 1.001f) && (abc.z <= 1.001f);
+
+	if (!isInsideTriangle)
+		return false;
+
+	depth = 1.f / (abc.x / projectedDepth.x + abc.y / projectedDepth.y + abc.z / projectedDepth.z); //Perspective-Correct Interpolation
+	return true;
+}
+
+//==============================================================================================//
+
+/*
+Tests the center of pixel (u, v) against a triangle, the ray is computed from the inverse camera matrices
+*/
+inline __host__ __device__ bool rasterizeFacePixel(int u, int v, float3 v0, float3 v1, float3 v2, float3 projectedDepth, float4* invExtrinsics, float4* invProjection, float3& abc, float& depth)
+{
+	float3 o = make_float3(0.f, 0.f, 0.f);
+	float3 d = make_float3(0.f, 0.f, 0.f);
+
+	float2 pixelPos = make_float2(u + 0.5f, v + 0.5f);
+
+	getRayCuda2(pixelPos, o, d, invExtrinsics, invProjection);
+
+	return rasterizeFacePixel(o, d, v0, v1, v2, projectedDepth, abc, depth);
+}
+
+//==============================================================================================//
+
 /*
 Takes albedo color, normal direction and shading coefficients and computes the shaded color
 */
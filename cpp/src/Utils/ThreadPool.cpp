@@ -0,0 +1,105 @@
+//==============================================================================================//
+
+#include "ThreadPool.h"
+
+//==============================================================================================//
+
+static thread_local bool insideThreadPoolWorker = false;
+
+//==============================================================================================//
+
+ThreadPool& ThreadPool::getInstance()
+{
+	//never destroyed on purpose: joining threads during static destruction / library unload can dead lock
+	static ThreadPool* instance = new ThreadPool();
+	return *instance;
+}
+
+//==============================================================================================//
+
+ThreadPool::ThreadPool()
+	:
+	currentTask(nullptr),
+	numberOfCurrentTasks(0),
+	nextTaskId(0),
+	numberOfBusyWorkers(0),
+	generation(0)
+{
+	int numberOfWorkers = (int)std::thread::hardware_concurrency() - 1;
+
+	for (int t = 0; t < numberOfWorkers; t++)
+	{
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+		workers.back().detach();
+	}
+}
+
+//==============================================================================================//
+
+void ThreadPool::runTasks()
+{
+	int taskId;
+	while ((taskId = nextTaskId.fetch_add(1)) < numberOfCurrentTasks)
+	{
+		(*currentTask)(taskId);
+	}
+}
+
+//==============================================================================================//
+
+void ThreadPool::workerLoop()
+{
+	insideThreadPoolWorker = true;
+	unsigned int seenGeneration = 0;
+
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(stateMutex);
+		wakeUpCondition.wait(lock, [&] { return generation != seenGeneration; });
+		seenGeneration = generation;
+		lock.unlock();
+
+		runTasks();
+
+		lock.lock();
+		numberOfBusyWorkers--;
+		if (numberOfBusyWorkers == 0)
+			doneCondition.notify_one();
+	}
+}
+
+//==============================================================================================//
+
+void ThreadPool::parallelFor(int numberOfTasks, const std::function<void(int)>& task)
+{
+	//serial fallback for trivial work and nested calls from inside a task
+	if (numberOfTasks <= 1 || workers.empty() || insideThreadPoolWorker)
+	{
+		for (int t = 0; t < numberOfTasks; t++)
+			task(t);
+		return;
+	}
+
+	//one parallelFor at a time, e.g. when TF constructs several kernels concurrently
+	std::lock_guard<std::mutex> callLock(callMutex);
+
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		currentTask				= &task;
+		numberOfCurrentTasks	= numberOfTasks;
+		nextTaskId				= 0;
+		numberOfBusyWorkers		= (int)workers.size();
+		generation++;
+	}
+	wakeUpCondition.notify_all();
+
+	insideThreadPoolWorker = true;
+	runTasks();
+	insideThreadPoolWorker = false;
+
+	std::unique_lock<std::mutex> lock(stateMutex);
+	doneCondition.wait(lock, [&] { return numberOfBusyWorkers == 0; });
+	currentTask = nullptr;
+}
+
+//==============================================================================================//
@@ -0,0 +1,64 @@
+//==============================================================================================//
+// Classname:
+//      ThreadPool
+//
+//==============================================================================================//
+// Description:
+//      Process wide pool of host worker threads used for the CPU side preprocessing
+//		(adjacency, texture atlas, ...). The calling thread takes part in the work.
+//
+//==============================================================================================//
+
+#pragma once
+
+//==============================================================================================//
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+//==============================================================================================//
+
+class ThreadPool
+{
+	//functions
+
+	public:
+
+		static ThreadPool&	getInstance();
+
+		//runs task(0) ... task(numberOfTasks - 1) on the pool and returns once all of them are done
+		void				parallelFor(int numberOfTasks, const std::function<void(int)>& task);
+
+		//number of threads working on a parallelFor including the calling thread
+		inline int			getNumberOfThreads()						{ return (int)workers.size() + 1; };
+
+	private:
+
+		ThreadPool();
+
+		void				workerLoop();
+		void				runTasks();
+
+	//variables
+
+	private:
+
+		std::vector<std::thread>			workers;
+
+		std::mutex							callMutex;
+		std::mutex							stateMutex;
+		std::condition_variable				wakeUpCondition;
+		std::condition_variable				doneCondition;
+
+		const std::function<void(int)>*		currentTask;
+		int									numberOfCurrentTasks;
+		std::atomic<int>					nextTaskId;
+		int									numberOfBusyWorkers;
+		unsigned int						generation;
+};
+
+//==============================================================================================//
@@ -43,6 +43,20 @@ class CudaRendererGpu:
                  image_filter_size_attr     = 1,
                  texture_filter_size_attr   = 1,
                  compute_normal_map_attr    = False,
+                 topology_cache_dir_attr    = '',
+                 reorder_mesh_attr          = False,
+                 two_sided_attr             = True,
+                 triangle_setup_attr        = True,
+                 visibility_mode_attr       = 'packed',
+                 hierarchical_z_attr        = True,
+                 profile_attr               = False,
+                 launch_graphs_attr         = False,
+                 vertex_normal_layout_attr  = 'perCamera',
+                 render_type_attr           = tf.float32,
+                 barycentric_type_attr      = tf.float32,
+                 texture_type_attr          = tf.float32,
+                 texture_sampling_attr      = 'nearest',
+                 outputs_attr               = ['barycentric', 'face', 'render', 'vertexNormal', 'target', 'normalMap', 'culledFaces', 'hiZStatistics'],
 
                  vertexPos_input            = None,
                  vertexColor_input          = None,
@@ -65,6 +79,20 @@ class CudaRendererGpu:
         self.image_filter_size_attr     = image_filter_size_attr
         self.texture_filter_size_attr   = texture_filter_size_attr
         self.compute_normal_map_attr    = compute_normal_map_attr
+        self.topology_cache_dir_attr    = topology_cache_dir_attr
+        self.reorder_mesh_attr          = reorder_mesh_attr
+        self.two_sided_attr             = two_sided_attr
+        self.triangle_setup_attr        = triangle_setup_attr
+        self.visibility_mode_attr       = visibility_mode_attr
+        self.hierarchical_z_attr        = hierarchical_z_attr
+        self.profile_attr               = profile_attr
+        self.launch_graphs_attr         = launch_graphs_attr
+        self.vertex_normal_layout_attr  = vertex_normal_layout_attr
+        self.render_type_attr           = render_type_attr
+        self.barycentric_type_attr      = barycentric_type_attr
+        self.texture_type_attr          = texture_type_attr
+        self.texture_sampling_attr      = texture_sampling_attr
+        self.outputs_attr               = outputs_attr
 
         self.vertexPos_input            = vertexPos_input
         self.vertexColor_input          = vertexColor_input
@@ -87,6 +115,20 @@ class CudaRendererGpu:
                                                                         image_filter_size       = self.image_filter_size_attr,
                                                                         texture_filter_size     = self.texture_filter_size_attr,
                                                                         compute_normal_map      = self.compute_normal_map_attr,
+                                                                        topology_cache_dir      = self.topology_cache_dir_attr,
+                                                                        reorder_mesh            = self.reorder_mesh_attr,
+                                                                        two_sided               = self.two_sided_attr,
+                                                                        triangle_setup          = self.triangle_setup_attr,
+                                                                        visibility_mode         = self.visibility_mode_attr,
+                                                                        hierarchical_z          = self.hierarchical_z_attr,
+                                                                        profile                 = self.profile_attr,
+                                                                        launch_graphs           = self.launch_graphs_attr,
+                                                                        vertex_normal_layout    = self.vertex_normal_layout_attr,
+                                                                        render_type             = self.render_type_attr,
+                                                                        barycentric_type        = self.barycentric_type_attr,
+                                                                        texture_type            = self.texture_type_attr,
+                                                                        texture_sampling        = self.texture_sampling_attr,
+                                                                        outputs                 = self.outputs_attr,
 
                                                                         vertex_pos              = self.vertexPos_input,
                                                                         vertex_color            = self.vertexColor_input,
@@ -120,10 +162,21 @@ class CudaRendererGpu:
 
     ########################################################################################################################
 
+    def getCulledFacesTF(self):
+        return self.cudaRendererOperator[6]
+
+    ########################################################################################################################
+
+    def getHiZStatisticsTF(self):
+        return self.cudaRendererOperator[7]
+
+    ########################################################################################################################
+
     def getNormalMap(self):
         if self.compute_normal_map_attr:
             normalMap = self.cudaRendererOperator[5]
-            normalMap = tf.reshape(normalMap, tf.shape(self.texture_input))
+            # the normal map is RGB, also for the RGBA padded texture layout
+            normalMap = tf.reshape(normalMap, tf.concat([tf.shape(self.texture_input)[:3], [3]], 0))
             return normalMap
         else:
             tf.print('Requesting normal map but computation was not enabled!')
@@ -168,11 +221,22 @@ class CudaRendererGpu:
 ########################################################################################################################
 
 @ops.RegisterGradient("CudaRendererGpu")
-def cuda_renderer_gpu_grad(op, gradBarycentric, gradFace, gradRender, gradNorm, gradTarget, gradNormalMap):
+def cuda_renderer_gpu_grad(op, gradBarycentric, gradFace, gradRender, gradNorm, gradTarget, gradNormalMap, gradCulledFaces, gradHiZStatistics):
 
     albedoMode = op.get_attr('albedo_mode').decode("utf-8")
 
     if(albedoMode == 'vertexColor' or albedoMode == 'textured' or albedoMode == 'foregroundMask'):
+
+        # the gradient op reads the visibility and the normals of the forward pass
+        outputs = [output.decode("utf-8") for output in op.get_attr('outputs')]
+        for output in ['barycentric', 'face', 'vertexNormal']:
+            if output not in outputs:
+                raise ValueError('The gradient of the renderer needs the \'' + output + '\' output of the forward pass')
+
+        # half and bfloat16 render buffers get gradients of their own type, sRGB encoded uint8 renders are not differentiable
+        if op.get_attr('render_type') == tf.uint8:
+            raise ValueError('The uint8 (sRGB) render buffer is not differentiable, use float, half or bfloat16')
+
         gradients = customOperators.cuda_renderer_grad_gpu(
             # grads
             render_buffer_grad          = gradRender,
@@ -202,8 +266,17 @@ def cuda_renderer_gpu_grad(op, gradBarycentric, gradFace, gradRender, gradNorm,
             albedo_mode                 = op.get_attr('albedo_mode'),
             shading_mode                = op.get_attr('shading_mode'),
             image_filter_size           = op.get_attr('image_filter_size'),
-            texture_filter_size         = op.get_attr('texture_filter_size')
+            texture_filter_size         = op.get_attr('texture_filter_size'),
+            topology_cache_dir          = op.get_attr('topology_cache_dir'),
+            reorder_mesh                = op.get_attr('reorder_mesh'),
+            profile                     = op.get_attr('profile'),
+            launch_graphs               = op.get_attr('launch_graphs'),
+            render_type                 = op.get_attr('render_type'),
+            barycentric_type            = op.get_attr('barycentric_type'),
+            texture_type                = op.get_attr('texture_type'),
+            texture_sampling            = op.get_attr('texture_sampling')
         )
+        gradients = list(gradients)
     elif (albedoMode == 'normal' or albedoMode == 'lighting'):
         gradients = [
             tf.zeros(tf.shape(op.inputs[0])),
@@ -212,6 +285,13 @@ def cuda_renderer_gpu_grad(op, gradBarycentric, gradFace, gradRender, gradNorm,
             tf.zeros(tf.shape(op.inputs[3])),
         ]
 
+    # the texture gradient is accumulated in float, half textures get it in their own type and uint8 textures none
+    textureType = op.get_attr('texture_type')
+    if textureType == tf.uint8:
+        gradients[2] = None
+    elif textureType == tf.float16:
+        gradients[2] = tf.cast(gradients[2], tf.float16)
+
     return gradients[0], gradients[1], gradients[2], gradients[3],  tf.zeros(tf.shape(op.inputs[4])), tf.zeros(tf.shape(op.inputs[5])), tf.zeros(tf.shape(op.inputs[6]))
 
 ########################################################################################################################
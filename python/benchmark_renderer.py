@@ -0,0 +1,735 @@
+
+########################################################################################################################
+# Imports
+########################################################################################################################
+
+import sys
+import time
+import subprocess
+import tempfile
+import CudaRenderer
+import data.test_SH_tensor as test_SH_tensor
+import utils.CheckGPU as CheckGPU
+import utils.OBJReader as OBJReader
+import utils.CameraReader as CameraReader
+import numpy as np
+import tensorflow as tf
+
+freeGPU = CheckGPU.get_free_gpu()
+
+########################################################################################################################
+# Setup
+########################################################################################################################
+
+# usage: python benchmark_renderer.py [benchmark] [texture resolution (atlas) | topology cache directory (startup) | obj file (loader)]
+# benchmarks: startup, cache, atlas, reorder, loader, meshlets, tiles, setup, visibility, culling, hiz, buckets, cameras, shading, normals, batches, graphs, target, outputs, formats, textures, mipmap
+benchmark           = sys.argv[1] if len(sys.argv) > 1 else 'startup'
+
+numberOfBatches     = 1
+renderResolutionU   = 1024
+renderResolutionV   = 1024
+numberOfIterations  = 20
+
+cameraReader = CameraReader.CameraReader('data/cameras.calibration', renderResolutionU, renderResolutionV)
+objreader = OBJReader.OBJReader('data/magdalena.obj')
+
+inputVertexPositions = np.asarray(objreader.vertexCoordinates).reshape([1, objreader.numberOfVertices, 3])
+inputVertexPositions = np.tile(inputVertexPositions, (numberOfBatches, 1, 1))
+
+inputVertexColors = np.asarray(objreader.vertexColors).reshape([1, objreader.numberOfVertices, 3])
+inputVertexColors = np.tile(inputVertexColors, (numberOfBatches, 1, 1))
+
+inputTexture = np.asarray(objreader.textureMap).reshape([1, objreader.texHeight, objreader.texWidth, 3])
+inputTexture = np.tile(inputTexture, (numberOfBatches, 1, 1, 1))
+
+inputSHCoeff = test_SH_tensor.getSHCoeff(numberOfBatches, cameraReader.numberOfCameras)
+
+########################################################################################################################
+# Helpers
+########################################################################################################################
+
+def layeredMesh(numberOfLayers):
+
+    # copies of the mesh scaled about its center, every layer occludes the ones inside of it (like garment layers over a body)
+    faces = []
+    for layer in range(0, numberOfLayers):
+        faces = faces + [vertexId + layer * objreader.numberOfVertices for vertexId in objreader.facesVertexId]
+
+    center = np.mean(inputVertexPositions, axis=1, keepdims=True)
+    vertexPositions = np.concatenate([center + (inputVertexPositions - center) * (1.0 + 0.01 * layer) for layer in range(0, numberOfLayers)], axis=1)
+    vertexColors = np.tile(inputVertexColors, (1, numberOfLayers, 1))
+
+    return faces, objreader.textureCoordinates * numberOfLayers, vertexPositions, vertexColors
+
+def rendererInputs(texture=inputTexture, textureType=tf.float32, layers=1, extrinsics=None, batches=numberOfBatches, trainable=False):
+
+    # the input tensors are uploaded once, so the timed calls do not include them
+    # trainable: the vertex positions are a variable, which the backward calls take the gradient of the render buffer with respect to
+    faces, textureCoordinates, vertexPositions, vertexColors = layeredMesh(layers)
+
+    # copies of the first batch element
+    vertexPositions = np.tile(vertexPositions[:1], (batches, 1, 1))
+    vertexColors = np.tile(vertexColors[:1], (batches, 1, 1))
+    texture = np.tile(texture[:1], (batches, 1, 1, 1))
+
+    if extrinsics is None:
+        extrinsics = cameraReader.extrinsics
+
+    return {
+        'faces':                faces,
+        'textureCoordinates':   textureCoordinates,
+        'vertexPos':            tf.Variable(vertexPositions, dtype=tf.float32) if trainable else tf.constant(vertexPositions, dtype=tf.float32),
+        'vertexColor':          tf.constant(vertexColors, dtype=tf.float32),
+        'texture':              tf.constant(texture, dtype=textureType),
+        'shCoeff':              tf.constant(test_SH_tensor.getSHCoeff(batches, cameraReader.numberOfCameras), dtype=tf.float32),
+        'targetImage':          tf.zeros([batches, cameraReader.numberOfCameras, renderResolutionV, renderResolutionU, 3]),
+        'extrinsics':           tf.constant([extrinsics] * batches, dtype=tf.float32),
+        'intrinsics':           tf.constant([cameraReader.intrinsics] * batches, dtype=tf.float32)}
+
+def createRenderer(albedoMode='textured', shadingMode='shaded', texture=inputTexture, computeNormalMap=False, topologyCacheDir='', reorderMesh=False, twoSided=True, triangleSetup=True, visibilityMode='packed', hierarchicalZ=True, profile=False, launchGraphs=False, vertexNormalLayout='perCamera', outputs=['barycentric', 'face', 'render', 'vertexNormal', 'target', 'normalMap', 'culledFaces', 'hiZStatistics'], renderType=tf.float32, barycentricType=tf.float32, textureType=tf.float32, textureSampling='nearest', layers=1, extrinsics=None, batches=numberOfBatches, inputs=None, nodeName='benchmark'):
+
+    # inputs of rendererInputs, texture, textureType, layers, extrinsics and batches are only used without them
+    if inputs is None:
+        inputs = rendererInputs(texture=texture, textureType=textureType, layers=layers, extrinsics=extrinsics, batches=batches)
+
+    return CudaRenderer.CudaRendererGpu(
+                                        faces_attr                  = inputs['faces'],
+                                        texCoords_attr              = inputs['textureCoordinates'],
+                                        numberOfVertices_attr       = inputs['vertexPos'].shape[1],
+                                        numberOfCameras_attr        = cameraReader.numberOfCameras,
+                                        renderResolutionU_attr      = renderResolutionU,
+                                        renderResolutionV_attr      = renderResolutionV,
+                                        albedoMode_attr             = albedoMode,
+                                        shadingMode_attr            = shadingMode,
+                                        image_filter_size_attr      = 1,
+                                        texture_filter_size_attr    = 1,
+                                        compute_normal_map_attr     = computeNormalMap,
+                                        topology_cache_dir_attr     = topologyCacheDir,
+                                        reorder_mesh_attr           = reorderMesh,
+                                        two_sided_attr              = twoSided,
+                                        triangle_setup_attr         = triangleSetup,
+                                        visibility_mode_attr        = visibilityMode,
+                                        hierarchical_z_attr         = hierarchicalZ,
+                                        profile_attr                = profile,
+                                        launch_graphs_attr          = launchGraphs,
+                                        vertex_normal_layout_attr   = vertexNormalLayout,
+                                        render_type_attr            = renderType,
+                                        barycentric_type_attr       = barycentricType,
+                                        texture_type_attr           = inputs['texture'].dtype,
+                                        texture_sampling_attr       = textureSampling,
+                                        outputs_attr                = outputs,
+
+                                        vertexPos_input             = inputs['vertexPos'],
+                                        vertexColor_input           = inputs['vertexColor'],
+                                        texture_input               = inputs['texture'],
+                                        shCoeff_input               = inputs['shCoeff'],
+                                        targetImage_input           = inputs['targetImage'],
+                                        extrinsics_input            = inputs['extrinsics'],
+                                        intrinsics_input            = inputs['intrinsics'],
+
+                                        nodeName                    = nodeName)
+
+def forwardCall(inputs, **rendererArguments):
+
+    # forward call returning the render, face and barycentric buffers
+    def call():
+        renderer = createRenderer(inputs=inputs, **rendererArguments)
+        return renderer.getRenderBufferTF(), renderer.getFaceBufferTF(), renderer.getBaryCentricBufferTF()
+
+    return call
+
+def backwardCall(inputs, **rendererArguments):
+
+    # forward + backward call returning the render buffer and the gradient of its sum with respect to the vertex positions (trainable inputs)
+    def call():
+        with tf.GradientTape() as tape:
+            renderer = createRenderer(inputs=inputs, **rendererArguments)
+            loss = tf.reduce_sum(tf.cast(renderer.getRenderBufferTF(), tf.float32))
+        return renderer.getRenderBufferTF(), tape.gradient(loss, inputs['vertexPos'])
+
+    return call
+
+def timeCalls(call):
+
+    # the call is traced into a graph once and the timed runs only execute that graph, so neither the upload of the inputs nor
+    # the construction of the op is timed. Returns the time per call and the outputs of the last call as numpy arrays.
+    graphCall = tf.function(call)
+    tf.nest.map_structure(lambda output: output.numpy(), graphCall())
+
+    start = time.time()
+    for i in range(0, numberOfIterations):
+        outputs = graphCall()
+
+    # the runs are queued on the GPU, the outputs of the last one wait for all of them
+    outputs = tf.nest.map_structure(lambda output: output.numpy(), outputs)
+    perCall = (time.time() - start) / numberOfIterations
+
+    return perCall, outputs
+
+########################################################################################################################
+# Startup: construction of the forward and gradient kernels (vertex face adjacency, texture atlas, ...)
+########################################################################################################################
+
+def benchmarkStartup():
+
+    topologyCacheDir = sys.argv[2] if len(sys.argv) > 2 else ''
+
+    inputs = rendererInputs(trainable=True)
+
+    # eager calls, the first one constructs the kernels
+    start = time.time()
+    backwardCall(inputs, topologyCacheDir=topologyCacheDir)()[1].numpy()
+    firstCall = time.time() - start
+
+    start = time.time()
+    for i in range(0, numberOfIterations):
+        outputs = backwardCall(inputs, topologyCacheDir=topologyCacheDir)()
+    outputs[1].numpy()
+    perCall = (time.time() - start) / numberOfIterations
+
+    print('Vertices: ' + str(objreader.numberOfVertices) + '  Faces: ' + str(int(len(objreader.facesVertexId) / 3)))
+    print('First forward + backward call (includes kernel construction): ' + str(firstCall * 1000.0) + ' ms')
+    print('Following forward + backward calls:                            ' + str(perCall * 1000.0) + ' ms')
+    print('Startup overhead:                                              ' + str((firstCall - perCall) * 1000.0) + ' ms')
+
+########################################################################################################################
+# Cache: startup of fresh processes without, with an empty and with a filled on-disk topology cache
+########################################################################################################################
+
+def benchmarkCache():
+
+    cacheDir = tempfile.mkdtemp()
+
+    for title, arguments in [('No topology cache', []), ('Empty topology cache', [cacheDir]), ('Filled topology cache', [cacheDir])]:
+        print('======== ' + title + ' ========')
+        output = subprocess.run([sys.executable, sys.argv[0], 'startup'] + arguments, stdout=subprocess.PIPE, universal_newlines=True).stdout
+        for line in output.splitlines():
+            if 'ms' in line:
+                print(line)
+
+########################################################################################################################
+# Atlas: construction of the per texel face id map on the first normal map call
+########################################################################################################################
+
+def benchmarkAtlas():
+
+    textureResolution = int(sys.argv[2]) if len(sys.argv) > 2 else 4096
+    texture = tf.image.resize(inputTexture, [textureResolution, textureResolution]).numpy()
+
+    inputs = rendererInputs(texture=texture)
+
+    # eager calls, the first one builds the atlas
+    start = time.time()
+    createRenderer(computeNormalMap=True, inputs=inputs, nodeName='benchmark_atlas_first').getNormalMap().numpy()
+    firstCall = time.time() - start
+
+    start = time.time()
+    for i in range(0, numberOfIterations):
+        normalMap = createRenderer(computeNormalMap=True, inputs=inputs).getNormalMap()
+    normalMap.numpy()
+    perCall = (time.time() - start) / numberOfIterations
+
+    atlasTime = firstCall - perCall
+    print('Texture resolution: ' + str(textureResolution) + 'x' + str(textureResolution) + '  Faces: ' + str(int(len(objreader.facesVertexId) / 3)))
+    print('First normal map call (includes atlas construction): ' + str(firstCall * 1000.0) + ' ms')
+    print('Following normal map calls:                           ' + str(perCall * 1000.0) + ' ms')
+    print('Atlas construction:                                   ' + str(atlasTime * 1000.0) + ' ms (' + str(textureResolution * textureResolution / max(atlasTime, 1e-9) / 1e6) + ' Mtexels/s)')
+
+########################################################################################################################
+# Reorder: forward + backward timing with and without the locality optimized mesh order
+########################################################################################################################
+
+def benchmarkReorder():
+
+    inputs = rendererInputs(trainable=True)
+    VertexColorVar = tf.Variable(inputs['vertexColor'])
+    inputs['vertexColor'] = VertexColorVar
+
+    def reorderCall(reorderMesh):
+        def call():
+            with tf.GradientTape() as tape:
+                renderer = createRenderer(albedoMode='vertexColor', reorderMesh=reorderMesh, inputs=inputs)
+                renderBuffer = renderer.getRenderBufferTF()
+                loss = tf.reduce_sum(renderBuffer)
+            gradients = tape.gradient(loss, [inputs['vertexPos'], VertexColorVar])
+            return renderBuffer, renderer.getFaceBufferTF(), gradients
+        return call
+
+    results = {}
+    for reorderMesh in [False, True]:
+        perCall, results[reorderMesh] = timeCalls(reorderCall(reorderMesh))
+        print('Reorder mesh: ' + str(reorderMesh) + '  forward + backward call: ' + str(perCall * 1000.0) + ' ms')
+
+    # depth ties go to the smaller original face id, so the face buffer matches exactly. The render buffer and the gradients
+    # may deviate by the float rounding of the normals and gradients, which are accumulated in a different order.
+    renderBuffer, faceBuffer, gradients = results[False]
+    renderBufferReordered, faceBufferReordered, gradientsReordered = results[True]
+    differingFaceIds = np.count_nonzero(faceBuffer != faceBufferReordered)
+    assert differingFaceIds == 0, str(differingFaceIds) + ' face ids differ with the reordered mesh'
+    print('Differing face ids:          0')
+    print('Max render buffer deviation: ' + str(np.max(np.abs(renderBuffer - renderBufferReordered))))
+    print('Max vertex pos grad deviation:   ' + str(np.max(np.abs(gradients[0] - gradientsReordered[0]))))
+    print('Max vertex color grad deviation: ' + str(np.max(np.abs(gradients[1] - gradientsReordered[1]))))
+
+########################################################################################################################
+# Loader: python obj reader against the native, memory mapped loader
+########################################################################################################################
+
+def benchmarkLoader():
+
+    filename = sys.argv[2] if len(sys.argv) > 2 else 'data/magdalena.obj'
+
+    readers = {}
+    for nativeLoader in [False, True]:
+        start = time.time()
+        readers[nativeLoader] = OBJReader.OBJReader(filename, nativeLoader=nativeLoader, denseAdjacency=False)
+        print('Native loader: ' + str(nativeLoader) + '  load time: ' + str((time.time() - start) * 1000.0) + ' ms')
+
+    pythonReader = readers[False]
+    nativeReader = readers[True]
+    print('Same vertices:            ' + str(np.array_equal(np.float32(pythonReader.vertexCoordinates), np.float32(nativeReader.vertexCoordinates))))
+    print('Same vertex colors:       ' + str(np.array_equal(np.float32(pythonReader.vertexColors), np.float32(nativeReader.vertexColors))))
+    print('Same faces:               ' + str(pythonReader.facesVertexId == nativeReader.facesVertexId))
+    print('Same texture coordinates: ' + str(np.array_equal(np.float32(pythonReader.textureCoordinates), np.float32(nativeReader.textureCoordinates))))
+    print('Same adjacency:           ' + str(all(sorted(pythonReader.compressedAdjacency[v]) == nativeReader.compressedAdjacency[v] for v in range(0, nativeReader.numberOfVertices))))
+
+########################################################################################################################
+# Meshlets: forward timing with frustum culling only (two sided) and with additional back-facing meshlet culling
+########################################################################################################################
+
+def benchmarkMeshlets():
+
+    inputs = rendererInputs()
+
+    results = {}
+    for twoSided in [True, False]:
+        perCall, results[twoSided] = timeCalls(forwardCall(inputs, albedoMode='vertexColor', twoSided=twoSided))
+        print('Two sided: ' + str(twoSided) + '  forward call: ' + str(perCall * 1000.0) + ' ms')
+
+    # back-facing meshlets only cover pixels of back faces, which are hidden on closed meshes
+    renderBuffer, faceBuffer, _ = results[True]
+    renderBufferOneSided, faceBufferOneSided, _ = results[False]
+    print('Differing face ids:          ' + str(np.count_nonzero(faceBuffer != faceBufferOneSided)))
+    print('Max render buffer deviation: ' + str(np.max(np.abs(renderBuffer - renderBufferOneSided))))
+
+########################################################################################################################
+# Tiles: forward timing of the tile binned rasterizer and comparison against the CPU reference
+########################################################################################################################
+
+def benchmarkTiles():
+
+    inputs = rendererInputs()
+
+    perCall, (_, faceBuffer, barycentricBuffer) = timeCalls(forwardCall(inputs, albedoMode='vertexColor'))
+    print('Forward call: ' + str(perCall * 1000.0) + ' ms')
+
+    with tf.device('/cpu:0'):
+        start = time.time()
+        referenceBarycentricBuffer, referenceFaceBuffer = CudaRenderer.customOperators.cuda_renderer_reference_cpu(
+                                        vertex_pos                  = tf.constant(inputVertexPositions, dtype=tf.float32),
+                                        extrinsics                  = [cameraReader.extrinsics] * numberOfBatches,
+                                        intrinsics                  = [cameraReader.intrinsics] * numberOfBatches,
+                                        faces                       = objreader.facesVertexId,
+                                        number_of_vertices          = len(objreader.vertexCoordinates),
+                                        number_of_cameras           = cameraReader.numberOfCameras,
+                                        render_resolution_u         = renderResolutionU,
+                                        render_resolution_v         = renderResolutionV)
+        print('CPU reference: ' + str((time.time() - start) * 1000.0) + ' ms')
+
+    # the host and device compilers may contract the barycentric arithmetic differently, which can flip single pixels at edges
+    print('Differing face ids:        ' + str(np.count_nonzero(faceBuffer != referenceFaceBuffer.numpy())))
+    print('Max barycentric deviation: ' + str(np.max(np.abs(barycentricBuffer - referenceBarycentricBuffer.numpy()))))
+
+########################################################################################################################
+# Setup: forward timing of the triangle setup rasterization against per pixel ray casting
+########################################################################################################################
+
+def benchmarkSetup():
+
+    inputs = rendererInputs()
+
+    results = {}
+    timings = {}
+    for triangleSetup in [False, True]:
+        timings[triangleSetup], (_, faceBuffer, barycentricBuffer) = timeCalls(forwardCall(inputs, albedoMode='vertexColor', triangleSetup=triangleSetup))
+
+        results[triangleSetup] = (faceBuffer, barycentricBuffer)
+        print('Triangle setup: ' + str(triangleSetup) + '  forward call: ' + str(timings[triangleSetup] * 1000.0) + ' ms')
+
+    print('Speedup: ' + str(timings[False] / timings[True]))
+
+    # both paths compute the same barycentrics in a different order of operations, pixels exactly on an edge may flip
+    faceBufferRayCasting, barycentricBufferRayCasting = results[False]
+    faceBuffer, barycentricBuffer = results[True]
+    sameFace = faceBuffer == faceBufferRayCasting
+    print('Differing face ids:        ' + str(np.count_nonzero(~sameFace)))
+    print('Max barycentric deviation: ' + str(np.max(np.abs(barycentricBuffer - barycentricBufferRayCasting)[sameFace])))
+
+########################################################################################################################
+# Visibility: forward timing with packed float depth keys and with the quantized integer depth
+########################################################################################################################
+
+def benchmarkVisibility():
+
+    inputs = rendererInputs()
+
+    results = {}
+    for visibilityMode in ['quantized', 'packed']:
+        perCall, (_, results[visibilityMode], _) = timeCalls(forwardCall(inputs, albedoMode='vertexColor', visibilityMode=visibilityMode))
+        print('Visibility mode: ' + visibilityMode + '  forward call: ' + str(perCall * 1000.0) + ' ms')
+
+    # pixels where the quantized depth tied two faces and the smaller face id was not the closer one
+    print('Differing face ids: ' + str(np.count_nonzero(results['quantized'] != results['packed'])))
+
+########################################################################################################################
+# Culling: number of faces per camera which are rejected before the binning, with and without back-face culling
+########################################################################################################################
+
+def benchmarkCulling():
+
+    numberOfFaces = len(objreader.facesVertexId) // 3
+
+    inputs = rendererInputs()
+
+    for twoSided in [True, False]:
+        culledFaces = createRenderer(albedoMode='vertexColor', twoSided=twoSided, inputs=inputs).getCulledFacesTF().numpy()
+
+        perCall, _ = timeCalls(forwardCall(inputs, albedoMode='vertexColor', twoSided=twoSided))
+
+        print('Two sided: ' + str(twoSided) + '  forward call: ' + str(perCall * 1000.0) + ' ms')
+        print('    culled faces per camera: ' + str(culledFaces[0].tolist()) + ' of ' + str(numberOfFaces))
+        print('    culled fraction:         ' + str(np.mean(culledFaces) / numberOfFaces))
+
+########################################################################################################################
+# HiZ: forward timing of 4 occluding mesh layers with and without the hierarchical depth test
+########################################################################################################################
+
+def benchmarkHiZ():
+
+    numberOfLayers = 4
+
+    inputs = rendererInputs(layers=numberOfLayers)
+
+    results = {}
+    for hierarchicalZ in [False, True]:
+        hiZStatistics = createRenderer(albedoMode='vertexColor', hierarchicalZ=hierarchicalZ, inputs=inputs).getHiZStatisticsTF().numpy()
+
+        perCall, (_, results[hierarchicalZ], _) = timeCalls(forwardCall(inputs, albedoMode='vertexColor', hierarchicalZ=hierarchicalZ))
+
+        print('Hierarchical z: ' + str(hierarchicalZ) + '  forward call: ' + str(perCall * 1000.0) + ' ms')
+        print('    rejected (tile, face) pairs: ' + str(np.sum(hiZStatistics[..., 1])) + ' of ' + str(np.sum(hiZStatistics[..., 0])) + '  rate: ' + str(np.sum(hiZStatistics[..., 1]) / max(1, np.sum(hiZStatistics[..., 0]))))
+
+    print('Differing face ids: ' + str(np.count_nonzero(results[False] != results[True])))
+
+########################################################################################################################
+# Buckets: time of the small, medium and large faces of the binning (printed by the profiling of the forward pass)
+########################################################################################################################
+
+def benchmarkBuckets():
+
+    inputs = rendererInputs()
+
+    for i in range(0, numberOfIterations):
+        createRenderer(albedoMode='vertexColor', profile=True, inputs=inputs).getRenderBufferTF().numpy()
+
+    perCall, _ = timeCalls(forwardCall(inputs, albedoMode='vertexColor'))
+
+    print('Forward call without profiling: ' + str(perCall * 1000.0) + ' ms')
+
+########################################################################################################################
+# Cameras: forward + backward calls with static cameras (cached camera setup) and with cameras moving every call
+########################################################################################################################
+
+def benchmarkCameras():
+
+    inputs = rendererInputs(trainable=True)
+
+    # shift of the translation of every camera per call
+    translationShift = np.zeros(inputs['extrinsics'].shape, dtype=np.float32)
+    translationShift[:, 3::4] = 0.001
+
+    for moving in [False, True]:
+        ExtrinsicsVar = tf.Variable(inputs['extrinsics'])
+        movingInputs = dict(inputs, extrinsics=ExtrinsicsVar)
+
+        def call():
+            if moving:
+                ExtrinsicsVar.assign_add(translationShift)
+            return backwardCall(movingInputs, albedoMode='vertexColor')()
+
+        perCall, _ = timeCalls(call)
+
+        print('Moving cameras: ' + str(moving) + '  cameras: ' + str(cameraReader.numberOfCameras) + '  forward + backward call: ' + str(perCall * 1000.0) + ' ms')
+
+########################################################################################################################
+# Shading: forward timing of the textured and the SH shaded modes on all cameras of the calibration
+########################################################################################################################
+
+def benchmarkShading():
+
+    inputs = rendererInputs()
+
+    for albedoMode, shadingMode in [('textured', 'shadeless'), ('textured', 'shaded'), ('vertexColor', 'shaded')]:
+        perCall, _ = timeCalls(forwardCall(inputs, albedoMode=albedoMode, shadingMode=shadingMode))
+
+        print('Albedo mode: ' + albedoMode + '  shading mode: ' + shadingMode + '  cameras: ' + str(cameraReader.numberOfCameras) + '  forward call: ' + str(perCall * 1000.0) + ' ms')
+
+########################################################################################################################
+# Normals: forward + backward timing and vertex normal output size of the per camera and the shared normal layout
+########################################################################################################################
+
+def benchmarkNormals():
+
+    inputs = rendererInputs(trainable=True)
+
+    for vertexNormalLayout in ['perCamera', 'shared']:
+        perCall, _ = timeCalls(backwardCall(inputs, albedoMode='vertexColor', vertexNormalLayout=vertexNormalLayout))
+
+        vertexNormal = createRenderer(albedoMode='vertexColor', vertexNormalLayout=vertexNormalLayout, inputs=inputs).cudaRendererOperator[3]
+
+        print('Vertex normal layout: ' + vertexNormalLayout + '  vertex normal shape: ' + str(vertexNormal.shape.as_list()) + '  forward + backward call: ' + str(perCall * 1000.0) + ' ms')
+
+########################################################################################################################
+# Batches: forward + backward timing per batch element, the profile output reports the kernel launches per call
+########################################################################################################################
+
+def benchmarkBatches():
+
+    for batches in [1, 8, 32]:
+        inputs = rendererInputs(batches=batches, trainable=True)
+
+        backwardCall(inputs, albedoMode='vertexColor', profile=True)()[1].numpy()
+
+        perCall, _ = timeCalls(backwardCall(inputs, albedoMode='vertexColor'))
+
+        print('Batch elements: ' + str(batches) + '  forward + backward call: ' + str(perCall * 1000.0) + ' ms  per batch element: ' + str(perCall * 1000.0 / batches) + ' ms')
+
+########################################################################################################################
+# Graphs: forward + backward latency with the fixed shape stages launched directly and replayed from captured launch graphs,
+# the forward replay covers the geometry stage and the binning together with the raster stage
+########################################################################################################################
+
+def benchmarkGraphs():
+
+    inputs = rendererInputs(trainable=True)
+
+    results = {}
+    for launchGraphs in [False, True]:
+
+        # the untimed first call of timeCalls captures the launch graphs
+        perCall, results[launchGraphs] = timeCalls(backwardCall(inputs, albedoMode='vertexColor', launchGraphs=launchGraphs))
+
+        print('Launch graphs: ' + str(launchGraphs) + ' (geometry, binning + raster, backward)  forward + backward call: ' + str(perCall * 1000.0) + ' ms')
+
+    print('Max render difference: ' + str(np.max(np.abs(results[False][0] - results[True][0]))) + '  max gradient difference: ' + str(np.max(np.abs(results[False][1] - results[True][1]))))
+
+########################################################################################################################
+# Target: peak GPU memory of a forward + backward call, the target image is forwarded to target_image_out without a copy.
+# The copy path is emulated by feeding the op a fresh target sized tensor per call, as the copy into target_image_out did.
+########################################################################################################################
+
+def benchmarkTarget():
+
+    if not hasattr(tf.config.experimental, 'get_memory_info') or not hasattr(tf.config.experimental, 'reset_memory_stats'):
+        print('Peak memory statistics need TensorFlow 2.6 or newer')
+        return
+
+    # the scale is a variable, so the multiplication is neither folded away nor done in place of the target image
+    copyScale = tf.Variable(1.0)
+
+    for batches in [1, 8]:
+        inputs = rendererInputs(batches=batches, trainable=True)
+
+        targetBytes = batches * cameraReader.numberOfCameras * renderResolutionV * renderResolutionU * 3 * 4
+        print('Batch elements: ' + str(batches) + '  target image (expected footprint of one copy): ' + str(targetBytes / 2**20) + ' MB')
+
+        peakBytes = {}
+        for copyTarget in [True, False]:
+
+            def call():
+                callInputs = dict(inputs, targetImage=inputs['targetImage'] * copyScale) if copyTarget else inputs
+                return backwardCall(callInputs, albedoMode='vertexColor')()
+
+            tf.config.experimental.reset_memory_stats('GPU:0')
+
+            perCall, _ = timeCalls(call)
+
+            peakBytes[copyTarget] = tf.config.experimental.get_memory_info('GPU:0')['peak']
+            print('    ' + ('copy' if copyTarget else 'passthrough') + '  peak memory: ' + str(peakBytes[copyTarget] / 2**20) + ' MB  forward + backward call: ' + str(perCall * 1000.0) + ' ms')
+
+        print('    saved by the passthrough: ' + str((peakBytes[True] - peakBytes[False]) / 2**20) + ' MB')
+
+########################################################################################################################
+# Outputs: forward timing and peak GPU memory with all outputs and with the inference output sets (render buffer, mask)
+########################################################################################################################
+
+def benchmarkOutputs():
+
+    outputSets = [
+        ('all', ['barycentric', 'face', 'render', 'vertexNormal', 'target', 'normalMap', 'culledFaces', 'hiZStatistics']),
+        ('render', ['render']),
+        ('mask', ['face'])]
+
+    hasMemoryInfo = hasattr(tf.config.experimental, 'get_memory_info') and hasattr(tf.config.experimental, 'reset_memory_stats')
+
+    inputs = rendererInputs()
+
+    results = {}
+    for name, outputs in outputSets:
+
+        def call():
+            renderer = createRenderer(albedoMode='vertexColor', outputs=outputs, inputs=inputs)
+            return list(renderer.cudaRendererOperator)
+
+        if hasMemoryInfo:
+            tf.config.experimental.reset_memory_stats('GPU:0')
+
+        perCall, results[name] = timeCalls(call)
+
+        outputBytes = sum([output.nbytes for output in results[name]])
+        peakMemory = str(tf.config.experimental.get_memory_info('GPU:0')['peak'] / 2**20) + ' MB' if hasMemoryInfo else 'n/a'
+
+        print('Outputs: ' + name + '  output size: ' + str(outputBytes / 2**20) + ' MB  peak memory: ' + peakMemory + '  forward call: ' + str(perCall * 1000.0) + ' ms')
+
+    # the outputs are ordered as the operator outputs, [1] is the face buffer and [2] the render buffer
+    print('Max render difference: ' + str(np.max(np.abs(results['all'][2] - results['render'][2]))) +
+          '  mask differences: ' + str(np.sum((results['all'][1] >= 0) != (results['mask'][1] >= 0))))
+
+########################################################################################################################
+# Formats: size of the render and barycentric buffers, forward + backward timing and the error of the reduced precision formats
+########################################################################################################################
+
+def benchmarkFormats():
+
+    inputs = rendererInputs(trainable=True)
+
+    reference = createRenderer(albedoMode='vertexColor', inputs=inputs).getRenderBufferTF().numpy()
+
+    for renderType, barycentricType in [(tf.float32, tf.float32), (tf.float16, tf.float16), (tf.bfloat16, tf.uint16), (tf.uint8, tf.uint16)]:
+
+        # sRGB encoded renders are not differentiable, only the forward pass is timed
+        differentiable = renderType != tf.uint8
+
+        if differentiable:
+            perCall, (render, _) = timeCalls(backwardCall(inputs, albedoMode='vertexColor', renderType=renderType, barycentricType=barycentricType))
+        else:
+            perCall, (render, _, _) = timeCalls(forwardCall(inputs, albedoMode='vertexColor', renderType=renderType, barycentricType=barycentricType))
+
+        render = np.float32(render)
+        if renderType == tf.uint8:
+            render = render / 255.0
+            render = np.where(render <= 0.04045, render / 12.92, np.power((render + 0.055) / 1.055, 2.4))
+
+        bufferBytes = render.size * renderType.size + render.size // 3 * 2 * barycentricType.size
+        renderError = np.max(np.abs(render - reference))
+
+        print('Render: ' + renderType.name + '  barycentric: ' + barycentricType.name + '  buffers: ' + str(bufferBytes / 2**20) + ' MB  max render error: ' + str(renderError) +
+              ('  forward + backward call: ' if differentiable else '  forward call: ') + str(perCall * 1000.0) + ' ms')
+
+########################################################################################################################
+# Textures: size of the texture, forward + backward timing and the render error of the reduced precision and RGBA padded textures
+########################################################################################################################
+
+def benchmarkTextures():
+
+    reference = createRenderer(inputs=rendererInputs()).getRenderBufferTF().numpy()
+
+    # the RGBA layout pads every texel to 4 channels for aligned vector loads
+    rgbaTexture = np.concatenate([inputTexture, np.ones(inputTexture.shape[:3] + (1,))], axis=3)
+
+    for textureType in [tf.float32, tf.float16, tf.uint8]:
+        for texture in [inputTexture, rgbaTexture]:
+
+            # uint8 textures hold the image values in 1 / 255 steps
+            if textureType == tf.uint8:
+                texture = np.round(np.clip(texture, 0.0, 1.0) * 255.0)
+
+            inputs = rendererInputs(texture=texture, textureType=textureType, trainable=True)
+
+            perCall, (render, _) = timeCalls(backwardCall(inputs))
+
+            textureBytes = inputs['texture'].shape.num_elements() * textureType.size
+            renderError = np.max(np.abs(render - reference))
+
+            print('Texture: ' + textureType.name + ' x ' + str(texture.shape[3]) + '  size: ' + str(textureBytes / 2**20) + ' MB  max render error: ' + str(renderError) +
+                  '  forward + backward call: ' + str(perCall * 1000.0) + ' ms')
+
+########################################################################################################################
+# Mipmap: texture fetch throughput of the nearest and the trilinear sampling for cameras moved away from the mesh
+########################################################################################################################
+
+def benchmarkMipmap():
+
+    for distance in [1, 2, 4, 8]:
+
+        # scale the translation along the optical axis of every camera (3 x 4 extrinsics)
+        extrinsics = list(cameraReader.extrinsics)
+        for row in range(11, len(extrinsics), 12):
+            extrinsics[row] *= distance
+
+        inputs = rendererInputs(extrinsics=extrinsics, trainable=True)
+
+        for textureSampling, taps in [('nearest', 1), ('trilinear', 8)]:
+
+            forwardTime, (_, faceBuffer, _) = timeCalls(forwardCall(inputs, textureSampling=textureSampling))
+            backwardTime, _ = timeCalls(backwardCall(inputs, textureSampling=textureSampling))
+
+            # one fetch per tap of every covered pixel
+            coveredPixels = np.sum(faceBuffer >= 0)
+            fetches = coveredPixels * taps
+
+            print('Distance: ' + str(distance) + 'x  sampling: ' + textureSampling + '  covered pixels: ' + str(coveredPixels) + '  forward call: ' + str(forwardTime * 1000.0) + ' ms  fetches: ' +
+                  str(fetches / forwardTime / 1e9) + ' G/s  forward + backward call: ' + str(backwardTime * 1000.0) + ' ms')
+
+########################################################################################################################
+# Run
+########################################################################################################################
+
+if freeGPU:
+
+    if benchmark == 'startup':
+        benchmarkStartup()
+    elif benchmark == 'cache':
+        benchmarkCache()
+    elif benchmark == 'atlas':
+        benchmarkAtlas()
+    elif benchmark == 'reorder':
+        benchmarkReorder()
+    elif benchmark == 'loader':
+        benchmarkLoader()
+    elif benchmark == 'meshlets':
+        benchmarkMeshlets()
+    elif benchmark == 'tiles':
+        benchmarkTiles()
+    elif benchmark == 'setup':
+        benchmarkSetup()
+    elif benchmark == 'visibility':
+        benchmarkVisibility()
+    elif benchmark == 'culling':
+        benchmarkCulling()
+    elif benchmark == 'hiz':
+        benchmarkHiZ()
+    elif benchmark == 'buckets':
+        benchmarkBuckets()
+    elif benchmark == 'cameras':
+        benchmarkCameras()
+    elif benchmark == 'shading':
+        benchmarkShading()
+    elif benchmark == 'normals':
+        benchmarkNormals()
+    elif benchmark == 'batches':
+        benchmarkBatches()
+    elif benchmark == 'graphs':
+        benchmarkGraphs()
+    elif benchmark == 'target':
+        benchmarkTarget()
+    elif benchmark == 'outputs':
+        benchmarkOutputs()
+    elif benchmark == 'formats':
+        benchmarkFormats()
+    elif benchmark == 'textures':
+        benchmarkTextures()
+    elif benchmark == 'mipmap':
+        benchmarkMipmap()
+    else:
+        print('Unknown benchmark: ' + benchmark)
@@ -59,7 +59,7 @@ inputSHCoeff = test_SH_tensor.getSHCoeff(numberOfBatches, cameraReader.numberOfC
 # Test color function
 ########################################################################################################################
 
-def test_color_gradient():
+def test_color_gradient(textureSampling):
 
     VertexPosConst = tf.constant(inputVertexPositions, dtype=tf.float32)
     VertexColorConst = tf.constant(inputVertexColors, dtype=tf.float32)
@@ -76,6 +76,7 @@ def test_color_gradient():
                                         shadingMode_attr             = 'shadeless',
                                         image_filter_size_attr       = imageFilterSize,
                                         texture_filter_size_attr     = textureFilterSize,
+                                        texture_sampling_attr        = textureSampling,
                                         numberOfCameras_attr=1,
                                         vertexPos_input              = VertexPosConst,
                                         vertexColor_input            = VertexColorConst,
@@ -108,6 +109,7 @@ def test_color_gradient():
                 shadingMode_attr='shadeless',
                 image_filter_size_attr=imageFilterSize,
                 texture_filter_size_attr=textureFilterSize,
+                texture_sampling_attr=textureSampling,
 
                 vertexPos_input=VertexPosConst,
                 vertexColor_input=VertexColorConst,
@@ -142,7 +144,77 @@ def test_color_gradient():
         cv.imshow('texture', textureCV)
         cv.waitKey(1)
 
-    cv.imwrite('D:/texture.png', textureCV * 255.0)
+    cv.imwrite('D:/texture_' + textureSampling + '.png', textureCV * 255.0)
+
+########################################################################################################################
+# Test trilinear texture gradient against finite differences
+########################################################################################################################
+
+def test_trilinear_gradient():
+
+    # the texture is minified in the low resolution view, so the samples blend two mip levels
+    minifiedResolution = 64
+    minifiedCameraReader = CameraReader.CameraReader('data/cameras.calibration', minifiedResolution, minifiedResolution)
+
+    VertexPosConst = tf.constant(inputVertexPositions, dtype=tf.float32)
+    VertexColorConst = tf.constant(inputVertexColors, dtype=tf.float32)
+    SHCConst = tf.constant(inputSHCoeff, dtype=tf.float32)
+    VertexTexture = tf.Variable(tf.constant(inputTexture, dtype=tf.float32))
+
+    # random pixel weights, so every texel reaches the loss with a different weight
+    pixelWeights = np.random.RandomState(0).uniform(size=[numberOfBatches, 1, minifiedResolution, minifiedResolution, 3])
+
+    def render():
+        renderer = CudaRenderer.CudaRendererGpu(
+            faces_attr=objreader.facesVertexId,
+            texCoords_attr=objreader.textureCoordinates,
+            numberOfVertices_attr=len(objreader.vertexCoordinates),
+            renderResolutionU_attr=minifiedResolution,
+            renderResolutionV_attr=minifiedResolution,
+            numberOfCameras_attr=1,
+            albedoMode_attr='textured',
+            shadingMode_attr='shadeless',
+            image_filter_size_attr=imageFilterSize,
+            texture_filter_size_attr=textureFilterSize,
+            texture_sampling_attr='trilinear',
+
+            vertexPos_input=VertexPosConst,
+            vertexColor_input=VertexColorConst,
+            texture_input=VertexTexture,
+            shCoeff_input=SHCConst,
+            targetImage_input=tf.zeros([numberOfBatches, 1, minifiedResolution, minifiedResolution, 3]),
+            extrinsics_input=[minifiedCameraReader.extrinsics] * numberOfBatches,
+            intrinsics_input=[minifiedCameraReader.intrinsics] * numberOfBatches,
+            nodeName='trilinear'
+        )
+        return renderer.getRenderBufferTF()
+
+    with tf.GradientTape() as tape:
+        Loss = tf.reduce_sum(render() * tf.constant(pixelWeights, dtype=tf.float32))
+
+    gradient = tape.gradient(Loss, VertexTexture).numpy()
+
+    # the render is linear in the texels, the central differences are taken in double precision over the weighted renders
+    epsilon = 0.1
+    texels = np.argsort(np.abs(gradient).ravel())[-16:]
+    for texel in texels:
+        texelId = np.unravel_index(texel, gradient.shape)
+
+        texture = inputTexture.astype(np.float32)
+        texture[texelId] += epsilon
+        VertexTexture.assign(texture)
+        renderPlus = render().numpy().astype(np.float64)
+
+        texture[texelId] -= 2.0 * epsilon
+        VertexTexture.assign(texture)
+        renderMinus = render().numpy().astype(np.float64)
+
+        finiteDifference = np.sum((renderPlus - renderMinus) * pixelWeights) / (2.0 * epsilon)
+
+        print('Texel ' + str(texelId) + '  gradient: ' + str(gradient[texelId]) + '  finite difference: ' + str(finiteDifference))
+        assert abs(finiteDifference - gradient[texelId]) <= 1e-3 + 0.05 * abs(gradient[texelId]), 'trilinear texture gradient differs from the finite difference at texel ' + str(texelId)
+
+    VertexTexture.assign(inputTexture.astype(np.float32))
 
 ########################################################################################################################
 # main
@@ -151,7 +223,9 @@ def test_color_gradient():
 freeGPU = CheckGPU.get_free_gpu()
 
 if freeGPU:
-    test_color_gradient()   
+    test_trilinear_gradient()
+    for textureSampling in ['nearest', 'trilinear']:
+        test_color_gradient(textureSampling)   
     
     
     
@@ -0,0 +1,110 @@
+
+########################################################################################################################
+# Imports
+########################################################################################################################
+
+import data.test_SH_tensor as test_SH_tensor
+import CudaRenderer
+import utils.CheckGPU as CheckGPU
+import numpy as np
+import utils.OBJReader as OBJReader
+import utils.CameraReader as CameraReader
+import tensorflow as tf
+
+freeGPU = CheckGPU.get_free_gpu()
+
+########################################################################################################################
+# CudaRendererGpu class
+########################################################################################################################
+
+numberOfBatches     = 2
+renderResolutionU   = 512
+renderResolutionV   = 512
+
+# barycentrics of the same face may differ between the host and the device arithmetic
+barycentricTolerance = 3e-4
+
+cameraReader = CameraReader.CameraReader('data/cameras.calibration',renderResolutionU,renderResolutionV)
+objreader = OBJReader.OBJReader('data/cone.obj')
+
+inputVertexPositions = objreader.vertexCoordinates
+inputVertexPositions = np.asarray(inputVertexPositions)
+inputVertexPositions = inputVertexPositions.reshape([1, objreader.numberOfVertices, 3])
+inputVertexPositions = np.tile(inputVertexPositions, (numberOfBatches, 1, 1))
+
+inputVertexColors = objreader.vertexColors
+inputVertexColors = np.asarray(inputVertexColors)
+inputVertexColors = inputVertexColors.reshape([1, objreader.numberOfVertices, 3])
+inputVertexColors = np.tile(inputVertexColors, (numberOfBatches, 1, 1))
+
+inputTexture = objreader.textureMap
+inputTexture = np.asarray(inputTexture)
+inputTexture = inputTexture.reshape([1, objreader.texHeight, objreader.texWidth, 3])
+inputTexture = np.tile(inputTexture, (numberOfBatches, 1, 1, 1))
+
+inputSHCoeff = test_SH_tensor.getSHCoeff(numberOfBatches, cameraReader.numberOfCameras)
+
+########################################################################################################################
+# Test face and barycentric buffer against the CPU reference
+########################################################################################################################
+
+def test_reference(visibilityMode, triangleSetup):
+
+    renderer = CudaRenderer.CudaRendererGpu(
+                                            faces_attr                  = objreader.facesVertexId,
+                                            texCoords_attr              = objreader.textureCoordinates,
+                                            numberOfVertices_attr       = len(objreader.vertexCoordinates),
+                                            numberOfCameras_attr        = cameraReader.numberOfCameras,
+                                            renderResolutionU_attr      = renderResolutionU,
+                                            renderResolutionV_attr      = renderResolutionV,
+                                            albedoMode_attr             = 'vertexColor',
+                                            shadingMode_attr            = 'shadeless',
+                                            triangle_setup_attr         = triangleSetup,
+                                            visibility_mode_attr        = visibilityMode,
+
+                                            vertexPos_input             = tf.constant(inputVertexPositions, dtype=tf.float32),
+                                            vertexColor_input           = tf.constant(inputVertexColors, dtype=tf.float32),
+                                            texture_input               = tf.constant(inputTexture, dtype=tf.float32),
+                                            shCoeff_input               = tf.constant(inputSHCoeff, dtype=tf.float32),
+                                            targetImage_input           = tf.zeros( [numberOfBatches, cameraReader.numberOfCameras, renderResolutionV, renderResolutionU, 3]),
+                                            extrinsics_input            = [cameraReader.extrinsics] * numberOfBatches,
+                                            intrinsics_input            = [cameraReader.intrinsics] * numberOfBatches,
+
+                                            nodeName                    = 'test')
+
+    faceBuffer = renderer.getFaceBufferTF().numpy()
+    barycentricBuffer = renderer.getBaryCentricBufferTF().numpy()
+
+    with tf.device('/cpu:0'):
+        referenceBarycentricBuffer, referenceFaceBuffer = CudaRenderer.customOperators.cuda_renderer_reference_cpu(
+                                            vertex_pos                  = tf.constant(inputVertexPositions, dtype=tf.float32),
+                                            extrinsics                  = [cameraReader.extrinsics] * numberOfBatches,
+                                            intrinsics                  = [cameraReader.intrinsics] * numberOfBatches,
+                                            faces                       = objreader.facesVertexId,
+                                            number_of_vertices          = len(objreader.vertexCoordinates),
+                                            number_of_cameras           = cameraReader.numberOfCameras,
+                                            render_resolution_u         = renderResolutionU,
+                                            render_resolution_v         = renderResolutionV,
+                                            triangle_setup              = triangleSetup,
+                                            visibility_mode             = visibilityMode)
+
+    referenceFaceBuffer = referenceFaceBuffer.numpy()
+    referenceBarycentricBuffer = referenceBarycentricBuffer.numpy()
+
+    differingFaceIds = np.count_nonzero(faceBuffer != referenceFaceBuffer)
+    assert differingFaceIds == 0, 'visibility mode ' + visibilityMode + ', triangle setup ' + str(triangleSetup) + ': ' + str(differingFaceIds) + ' face ids differ from the reference'
+
+    covered = referenceFaceBuffer >= 0
+    barycentricDeviation = np.max(np.abs(barycentricBuffer - referenceBarycentricBuffer)[covered]) if np.any(covered) else 0.0
+    assert barycentricDeviation <= barycentricTolerance, 'visibility mode ' + visibilityMode + ', triangle setup ' + str(triangleSetup) + ': barycentric deviation ' + str(barycentricDeviation)
+
+    print('Visibility mode: ' + visibilityMode + '  triangle setup: ' + str(triangleSetup) + '  max barycentric deviation: ' + str(barycentricDeviation))
+
+########################################################################################################################
+# main
+########################################################################################################################
+
+if freeGPU:
+    for visibilityMode in ['packed', 'quantized']:
+        for triangleSetup in [True, False]:
+            test_reference(visibilityMode, triangleSetup)
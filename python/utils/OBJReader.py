@@ -10,20 +10,30 @@ class OBJReader:
 
     ########################################################################################################################
 
-    def __init__(self, filename):
+    # nativeLoader:   parse the obj with the memory mapped, multithreaded ObjLoaderCpu operator (see cpp/src/Renderer/MeshLoader.h).
+    #                 It needs the compiled operator library and fan triangulates polygons, where the python reader keeps the first triangle.
+    # denseAdjacency: also build the dense N x N adjacency (and laplacian), which is not feasible for large meshes
+    def __init__(self, filename, nativeLoader=False, denseAdjacency=True):
 
         print('++ ObjReader: Set filename and folderpath')
         self.filename = filename
         self.folderPath = self.filename[0:self.filename.rfind('/') + 1]
+        self.nativeLoader = nativeLoader
+        self.denseAdjacency = denseAdjacency
 
-        print('++ ObjReader: Read file ...')
-        self.readObjFile()
+        if self.nativeLoader:
+            print('++ ObjReader: Read file (native) ...')
+            self.readObjFileNative()
+        else:
+            print('++ ObjReader: Read file ...')
+            self.readObjFile()
 
         print('++ ObjReader: Set number of vertices')
         self.numberOfVertices = len(self.vertexColors)
 
-        print('++ ObjReader: Compute per face tex coords')
-        self.computePerFaceTextureCoordinated()
+        if not self.nativeLoader:
+            print('++ ObjReader: Compute per face tex coords')
+            self.computePerFaceTextureCoordinated()
 
         print('++ ObjReader: Load segmentation weights')
         self.loadSegmentationWeights()
@@ -31,8 +41,14 @@ class OBJReader:
         print('++ ObjReader: Compute adjacency')
         self.computeAdjacency()
 
-        print('++ ObjReader: Load Mtl')
-        self.loadMtlTexture(self.mtlFilePathFull, self.mtlFilePath)
+        if self.nativeLoader:
+            # as with the mtl, there is no texture without a map_Kd
+            if self.textureMapPath != '':
+                print('++ ObjReader: Load texture')
+                self.loadTextureMap(self.textureMapPath)
+        else:
+            print('++ ObjReader: Load Mtl')
+            self.loadMtlTexture(self.mtlFilePathFull, self.mtlFilePath)
 
         print('++ ObjReader: Finished loading')
 
@@ -91,6 +107,25 @@ class OBJReader:
 
     ########################################################################################################################
 
+    def readObjFileNative(self):
+
+        # the operator library is only loaded when the native loader is used
+        from CudaRenderer import customOperators
+
+        vertexCoordinates, vertexColors, faces, textureCoordinates, vertexNeighbours, vertexNeighboursId, textureMapPath = customOperators.obj_loader_cpu(filename=self.filename)
+
+        self.vertexCoordinates = vertexCoordinates.numpy().tolist()
+        self.vertexColors = vertexColors.numpy().tolist()
+        self.facesVertexId = faces.numpy().tolist()
+        self.textureCoordinates = textureCoordinates.numpy().tolist()
+        self.textureMapPath = textureMapPath.numpy().decode()
+
+        # sparse adjacency: the neighbours of vertex v are vertexNeighbours[vertexNeighboursId[v, 0] : vertexNeighboursId[v, 0] + vertexNeighboursId[v, 1]]
+        self.vertexNeighbours = vertexNeighbours.numpy()
+        self.vertexNeighboursId = vertexNeighboursId.numpy()
+
+    ########################################################################################################################
+
     def computePerFaceTextureCoordinated(self):
         # per face texture coordinates
         self.textureCoordinates = []
@@ -103,9 +138,45 @@ class OBJReader:
 
     def computeAdjacency(self):
 
+        if self.nativeLoader:
+            self.computeAdjacencyFromNeighbours()
+        else:
+            self.computeAdjacencyFromFaces()
+
+        self.maximumNumNeighbours = int(np.amax(self.numberOfNeigbours))
+
+        #weights and laplacian matrix
+        if len(self.vertexLabels) == self.numberOfVertices and self.denseAdjacency:
+            self.computeLaplacian()
+
+    ########################################################################################################################
+
+    def computeAdjacencyFromNeighbours(self):
+
+        # adjacency (compressed) matrix from the sparse adjacency of the native loader
+        print('     ++ Compute (compressed) adjacency')
+        starts = self.vertexNeighboursId[:, 0]
+        counts = self.vertexNeighboursId[:, 1]
+
+        self.compressedAdjacency = np.empty(self.numberOfVertices, dtype=object)
+        for v in range(0, self.numberOfVertices):
+            self.compressedAdjacency[v] = (self.vertexNeighbours[starts[v]:starts[v] + counts[v]] + 1).tolist()
+
+        self.numberOfEdges = int(np.sum(counts))
+        self.numberOfNeigbours = counts.astype(np.float32)
+
+        if self.denseAdjacency:
+            self.adjacency = np.zeros((self.numberOfVertices, self.numberOfVertices), dtype=np.float32)
+            self.adjacency[np.repeat(np.arange(self.numberOfVertices), counts), self.vertexNeighbours] = 1
+
+    ########################################################################################################################
+
+    def computeAdjacencyFromFaces(self):
+
         # adjacency (compressed) matrix
         print('     ++ Compute (compressed) adjacency')
-        self.adjacency = np.zeros((self.numberOfVertices, self.numberOfVertices),dtype=np.float32)
+        if self.denseAdjacency:
+            self.adjacency = np.zeros((self.numberOfVertices, self.numberOfVertices),dtype=np.float32)
         self.compressedAdjacency = [ [] for _ in range(self.numberOfVertices) ]
         self.numberOfEdges = 0
         self.numberOfNeigbours = np.zeros((self.numberOfVertices), dtype=np.float32)
@@ -115,12 +186,13 @@ class OBJReader:
             v1 = self.facesVertexId[f * 3 + 1]
             v2 = self.facesVertexId[f * 3 + 2]
 
-            self.adjacency[v0, v1] = 1
-            self.adjacency[v0, v2] = 1
-            self.adjacency[v1, v0] = 1
-            self.adjacency[v1, v2] = 1
-            self.adjacency[v2, v0] = 1
-            self.adjacency[v2, v1] = 1
+            if self.denseAdjacency:
+                self.adjacency[v0, v1] = 1
+                self.adjacency[v0, v2] = 1
+                self.adjacency[v1, v0] = 1
+                self.adjacency[v1, v2] = 1
+                self.adjacency[v2, v0] = 1
+                self.adjacency[v2, v1] = 1
 
             # v0
             if v1 + 1 not in self.compressedAdjacency[v0]:
@@ -157,42 +229,41 @@ class OBJReader:
 
         self.compressedAdjacency = np.asarray(self.compressedAdjacency)
 
-        self.maximumNumNeighbours = int(np.amax(self.numberOfNeigbours))
+    ########################################################################################################################
 
-        #weights and laplacian matrix
-        if len(self.vertexLabels) == self.numberOfVertices:
-
-            #laplacian
-            print('     ++ Compute laplacian matrix')
-            self.laplacian = - self.adjacency
-            for i in range(0, self.numberOfVertices):
-                self.laplacian[i,i] =  self.numberOfNeigbours[i]
-
-            #row weight
-            print('     ++ Compute row weights')
-            self.rowWeight = np.zeros((self.numberOfVertices), dtype=np.float32)
-
-            for i in range(0, self.numberOfVertices):
-                self.rowWeight[i] = 0.0
-                for j in range(0, len(self.compressedAdjacency[i])):
-                    nIdx = self.compressedAdjacency[i][j] - 1
-                    self.rowWeight[i] = self.rowWeight[i] +  (self.vertexWeights[i] + self.vertexWeights[nIdx]) / 2.0
-                self.rowWeight[i] = self.rowWeight[i] / float(self.numberOfNeigbours[i])
-
-            #laplacian weighted
-            print('     ++ Compute laplacian weights')
-            self.adjacencyWeights = np.zeros((self.numberOfVertices, self.numberOfVertices))
-            for f in range(0, int(len(self.facesVertexId) / 3)):
-                v0 = self.facesVertexId[f * 3 + 0]
-                v1 = self.facesVertexId[f * 3 + 1]
-                v2 = self.facesVertexId[f * 3 + 2]
-
-                self.adjacencyWeights[v0, v1] = (self.vertexWeights[v0] + self.vertexWeights[v1]) / 2.0
-                self.adjacencyWeights[v0, v2] = (self.vertexWeights[v0] + self.vertexWeights[v2]) / 2.0
-                self.adjacencyWeights[v1, v0] = (self.vertexWeights[v1] + self.vertexWeights[v0]) / 2.0
-                self.adjacencyWeights[v1, v2] = (self.vertexWeights[v1] + self.vertexWeights[v2]) / 2.0
-                self.adjacencyWeights[v2, v0] = (self.vertexWeights[v2] + self.vertexWeights[v0]) / 2.0
-                self.adjacencyWeights[v2, v1] = (self.vertexWeights[v2] + self.vertexWeights[v1]) / 2.0
+    def computeLaplacian(self):
+
+        #laplacian
+        print('     ++ Compute laplacian matrix')
+        self.laplacian = - self.adjacency
+        for i in range(0, self.numberOfVertices):
+            self.laplacian[i,i] =  self.numberOfNeigbours[i]
+
+        #row weight
+        print('     ++ Compute row weights')
+        self.rowWeight = np.zeros((self.numberOfVertices), dtype=np.float32)
+
+        for i in range(0, self.numberOfVertices):
+            self.rowWeight[i] = 0.0
+            for j in range(0, len(self.compressedAdjacency[i])):
+                nIdx = self.compressedAdjacency[i][j] - 1
+                self.rowWeight[i] = self.rowWeight[i] +  (self.vertexWeights[i] + self.vertexWeights[nIdx]) / 2.0
+            self.rowWeight[i] = self.rowWeight[i] / float(self.numberOfNeigbours[i])
+
+        #laplacian weighted
+        print('     ++ Compute laplacian weights')
+        self.adjacencyWeights = np.zeros((self.numberOfVertices, self.numberOfVertices))
+        for f in range(0, int(len(self.facesVertexId) / 3)):
+            v0 = self.facesVertexId[f * 3 + 0]
+            v1 = self.facesVertexId[f * 3 + 1]
+            v2 = self.facesVertexId[f * 3 + 2]
+
+            self.adjacencyWeights[v0, v1] = (self.vertexWeights[v0] + self.vertexWeights[v1]) / 2.0
+            self.adjacencyWeights[v0, v2] = (self.vertexWeights[v0] + self.vertexWeights[v2]) / 2.0
+            self.adjacencyWeights[v1, v0] = (self.vertexWeights[v1] + self.vertexWeights[v0]) / 2.0
+            self.adjacencyWeights[v1, v2] = (self.vertexWeights[v1] + self.vertexWeights[v2]) / 2.0
+            self.adjacencyWeights[v2, v0] = (self.vertexWeights[v2] + self.vertexWeights[v0]) / 2.0
+            self.adjacencyWeights[v2, v1] = (self.vertexWeights[v2] + self.vertexWeights[v1]) / 2.0
 
     ########################################################################################################################
 
@@ -204,17 +275,21 @@ class OBJReader:
             splitted = line.split()
             if len(splitted) > 0:
                 if splitted[0] == 'map_Kd':
-                    textureMapPath = shortPath+splitted[1]
-                    self.textureMap = cv2.imread(textureMapPath)
-                    self.textureMap = cv2.cvtColor( self.textureMap , cv2.COLOR_BGR2RGB)
-                    self.textureMap = list(self.textureMap / 255.0)
-                    self.texHeight = np.size(self.textureMap, 0)
-                    self.texWidth = np.size(self.textureMap, 1)
+                    self.loadTextureMap(shortPath+splitted[1])
 
         mtlFile.close()
 
     ########################################################################################################################
 
+    def loadTextureMap(self, textureMapPath):
+        self.textureMap = cv2.imread(textureMapPath)
+        self.textureMap = cv2.cvtColor( self.textureMap , cv2.COLOR_BGR2RGB)
+        self.textureMap = list(self.textureMap / 255.0)
+        self.texHeight = np.size(self.textureMap, 0)
+        self.texWidth = np.size(self.textureMap, 1)
+
+    ########################################################################################################################
+
     def loadSegmentationWeights(self):
 
         self.vertexLabels = []